@@ -10,6 +10,10 @@
 #include <lib/Settings.h>
 #include <lib/FancyZones.h>
 #include <lib/FancyZonesWinHookEventIDs.h>
+#include <lib/StartupTimeline.h>
+
+#include <future>
+#include <wil/resource.h>
 
 extern "C" IMAGE_DOS_HEADER __ImageBase;
 
@@ -63,30 +67,11 @@ public:
             InitializeWinhookEventIds();
             m_app = MakeFancyZones(reinterpret_cast<HINSTANCE>(&__ImageBase), m_settings);
 
-            s_llKeyboardHook = SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, GetModuleHandle(NULL), NULL);
-            if (!s_llKeyboardHook)
-            {
-                MessageBoxW(NULL, L"Cannot install keyboard listener.", L"PowerToys - FancyTiling", MB_OK | MB_ICONERROR);
-            }
-
-            std::array<DWORD, 4> events_to_subscribe = {
-                EVENT_OBJECT_NAMECHANGE,
-                EVENT_OBJECT_UNCLOAKED,
-                EVENT_OBJECT_SHOW,
-                EVENT_OBJECT_CREATE,
-            };
-            for (const auto event : events_to_subscribe)
-            {
-                auto hook = SetWinEventHook(event, event, nullptr, WinHookProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
-                if (hook)
-                {
-                    m_staticWinEventHooks.emplace_back(hook);
-                }
-                else
-                {
-                    MessageBoxW(NULL, L"Cannot install Windows event listener.", L"PowerToys - FancyTiling", MB_OK | MB_ICONERROR);
-                }
-            }
+            // Hooks go in while the data may still be parsed, their events are let through until
+            // the callback is set once it's loaded
+            InstallHooks();
+            WaitForData();
+            m_callback = m_app.as<IFancyZonesCallback>();
 
             if (m_app)
             {
@@ -125,19 +110,75 @@ public:
 
     FancyZonesModule()
     {
+        Startup::s_timeline.Start();
         app_name = GET_RESOURCE_STRING(IDS_FANCYZONES);
         m_settings = MakeFancyZonesSettings(reinterpret_cast<HINSTANCE>(&__ImageBase), FancyZonesModule::get_name());
-        JSONHelpers::FancyZonesDataInstance().LoadFancyZonesData();
+        // Parsed while enable() creates FancyZones, nothing reads the data before Run
+        m_dataLoadedEvent.reset(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+        m_dataLoaded = std::async(std::launch::async, [loaded = m_dataLoadedEvent.get()] {
+            auto signal = wil::scope_exit([loaded] { SetEvent(loaded); });
+            Startup::PhaseTimer timer(Startup::Phase::DataLoad);
+            JSONHelpers::FancyZonesDataInstance().LoadFancyZonesData();
+        });
         s_instance = this;
     }
 
 private:
+    void InstallHooks()
+    {
+        Startup::PhaseTimer timer(Startup::Phase::Hooks);
+
+        s_llKeyboardHook = SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, GetModuleHandle(NULL), NULL);
+        if (!s_llKeyboardHook)
+        {
+            MessageBoxW(NULL, L"Cannot install keyboard listener.", L"PowerToys - FancyTiling", MB_OK | MB_ICONERROR);
+        }
+
+        std::array<DWORD, 5> events_to_subscribe = {
+            EVENT_OBJECT_NAMECHANGE,
+            EVENT_OBJECT_UNCLOAKED,
+            EVENT_OBJECT_SHOW,
+            EVENT_OBJECT_CREATE,
+            EVENT_OBJECT_DESTROY,
+        };
+        for (const auto event : events_to_subscribe)
+        {
+            auto hook = SetWinEventHook(event, event, nullptr, WinHookProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+            if (hook)
+            {
+                m_staticWinEventHooks.emplace_back(hook);
+            }
+            else
+            {
+                MessageBoxW(NULL, L"Cannot install Windows event listener.", L"PowerToys - FancyTiling", MB_OK | MB_ICONERROR);
+            }
+        }
+    }
+
+    // The thread owning the low level keyboard hook has to keep handling sent messages, or every
+    // key press on the system stalls until the hook times out. Posted messages stay queued.
+    void WaitForData()
+    {
+        if (m_dataLoaded.valid())
+        {
+            Startup::PhaseTimer timer(Startup::Phase::DataWait);
+            HANDLE loaded = m_dataLoadedEvent.get();
+            while (loaded && MsgWaitForMultipleObjects(1, &loaded, FALSE, INFINITE, QS_SENDMESSAGE) == WAIT_OBJECT_0 + 1)
+            {
+                MSG message;
+                PeekMessageW(&message, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+            }
+            m_dataLoaded.get();
+        }
+    }
+
     void Disable(bool const traceEvent)
     {
         if (m_app)
         {
             m_app->Destroy();
             m_app = nullptr;
+            m_callback = nullptr;
             m_settings->ResetCallback();
 
             if (s_llKeyboardHook)
@@ -168,8 +209,11 @@ private:
     void HandleWinHookEvent(WinHookEvent* data) noexcept;
 
     winrt::com_ptr<IFancyZones> m_app;
+    winrt::com_ptr<IFancyZonesCallback> m_callback; // Cached, hooks shouldn't pay for QueryInterface on every event
     winrt::com_ptr<IFancyZonesSettings> m_settings;
     std::wstring app_name;
+    wil::unique_handle m_dataLoadedEvent; // Set by the parsing thread, outlives it
+    std::future<void> m_dataLoaded; // Until enable() waits for it
 
     static inline FancyZonesModule* s_instance;
     static inline HHOOK s_llKeyboardHook;
@@ -180,7 +224,8 @@ private:
     static LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
     {
         LowlevelKeyboardEvent event;
-        if (nCode == HC_ACTION && wParam == WM_KEYDOWN)
+        // Key releases are forwarded too, FancyZones tracks modifier state from them
+        if (nCode == HC_ACTION && (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN || wParam == WM_KEYUP || wParam == WM_SYSKEYUP))
         {
             event.lParam = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
             event.wParam = wParam;
@@ -213,12 +258,27 @@ private:
 
 intptr_t FancyZonesModule::HandleKeyboardHookEvent(LowlevelKeyboardEvent* data) noexcept
 {
-    return m_app.as<IFancyZonesCallback>()->OnKeyDown(data->lParam);
+    if (!m_callback)
+    {
+        return 0;
+    }
+
+    if (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP)
+    {
+        m_callback->OnKeyUp(data->lParam);
+        return 0;
+    }
+    return m_callback->OnKeyDown(data->lParam);
 }
 
 void FancyZonesModule::HandleWinHookEvent(WinHookEvent* data) noexcept
 {
-    auto fzCallback = m_app.as<IFancyZonesCallback>();
+    if (!m_callback)
+    {
+        return;
+    }
+
+    auto& fzCallback = m_callback;
     switch (data->event)
     {
     case EVENT_OBJECT_LOCATIONCHANGE:
@@ -233,7 +293,7 @@ void FancyZonesModule::HandleWinHookEvent(WinHookEvent* data) noexcept
         // switches virtual desktops.
         if (data->hwnd == GetDesktopWindow())
         {
-            m_app.as<IFancyZonesCallback>()->VirtualDesktopChanged();
+            fzCallback->VirtualDesktopChanged();
         }
     }
     break;
@@ -241,6 +301,7 @@ void FancyZonesModule::HandleWinHookEvent(WinHookEvent* data) noexcept
     case EVENT_OBJECT_UNCLOAKED:
     case EVENT_OBJECT_SHOW:
     case EVENT_OBJECT_CREATE:
+    case EVENT_OBJECT_DESTROY:
     {
         fzCallback->HandleWinHookEvent(data);
     }
@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "AllocationTracker.h"
+
+#if defined(FANCYZONES_ALLOCATION_TRACKING)
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions of the whole module. Over-aligned allocations keep
+// the default implementation and aren't counted.
+void* operator new(size_t size)
+{
+    Allocations::Record(size);
+    if (void* memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    Allocations::Record(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+#endif
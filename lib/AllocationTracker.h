@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocations made on behalf of user actions. Code handling an action opens a Scope on its
+// thread, and the replaced global operator new charges every allocation made meanwhile to that
+// action. The replacement is only built with FANCYZONES_ALLOCATION_TRACKING defined, otherwise
+// counters stay at zero and a scope costs a thread local store.
+namespace Allocations
+{
+    enum class Action : uint8_t
+    {
+        None,
+        Cycle, // Win+Up, Win+Down, created windows
+        Settle, // Win+Left
+        MainZoneWidth, // Win+Shift+Left, Win+Shift+Right
+        Count
+    };
+
+    inline constexpr const wchar_t* ACTION_NAMES[] = {
+        L"none",
+        L"cycle",
+        L"settle",
+        L"mainZoneWidth",
+    };
+    static_assert(std::size(ACTION_NAMES) == static_cast<size_t>(Action::Count));
+
+    struct Counters
+    {
+        std::atomic<uint64_t> actions{ 0 };
+        std::atomic<uint64_t> allocations{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+    };
+
+    inline std::array<Counters, static_cast<size_t>(Action::Count)> s_counters{};
+    inline thread_local Action t_action = Action::None;
+    inline thread_local uint64_t t_allocations = 0; // Every allocation made on this thread, in any scope
+
+    class Scope
+    {
+    public:
+        explicit Scope(Action action) noexcept :
+            m_previous(t_action)
+        {
+            t_action = action;
+        }
+
+        ~Scope()
+        {
+            t_action = m_previous;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const Action m_previous;
+    };
+
+    // Once per action, however many threads work on it.
+    inline void CountAction(Action action) noexcept
+    {
+        s_counters[static_cast<size_t>(action)].actions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Called by operator new, must not allocate.
+    inline void Record(size_t bytes) noexcept
+    {
+        t_allocations++;
+        const Action action = t_action;
+        if (action != Action::None)
+        {
+            auto& counters = s_counters[static_cast<size_t>(action)];
+            counters.allocations.fetch_add(1, std::memory_order_relaxed);
+            counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    inline const Counters& Of(Action action) noexcept
+    {
+        return s_counters[static_cast<size_t>(action)];
+    }
+
+    inline uint64_t OnThisThread() noexcept
+    {
+        return t_allocations;
+    }
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interned strings with reference counts. Ids of released strings are reused.
+class StringPool
+{
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t Acquire(std::wstring_view value)
+    {
+        if (const auto it = m_ids.find(value); it != m_ids.end())
+        {
+            m_slots[it->second].references++;
+            return it->second;
+        }
+
+        uint32_t id;
+        if (!m_free.empty())
+        {
+            id = m_free.back();
+            m_free.pop_back();
+            m_slots[id].value.assign(value);
+        }
+        else
+        {
+            id = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(Slot{ std::wstring(value) });
+        }
+        m_slots[id].references = 1;
+        // Slots live in a deque, so views of their strings stay valid while others are added
+        m_ids.emplace(m_slots[id].value, id);
+        return id;
+    }
+
+    void Release(uint32_t id)
+    {
+        auto& slot = m_slots[id];
+        if (--slot.references == 0)
+        {
+            m_ids.erase(slot.value);
+            slot.value.clear();
+            slot.value.shrink_to_fit();
+            m_free.push_back(id);
+        }
+    }
+
+    // NONE if the string isn't interned.
+    uint32_t Find(std::wstring_view value) const
+    {
+        const auto it = m_ids.find(value);
+        return it != m_ids.end() ? it->second : NONE;
+    }
+
+    std::wstring_view Get(uint32_t id) const noexcept
+    {
+        return m_slots[id].value;
+    }
+
+    size_t Count() const noexcept
+    {
+        return m_ids.size();
+    }
+
+    // Estimate of the heap memory used, including the lookup table.
+    size_t Bytes() const noexcept
+    {
+        size_t bytes = m_slots.size() * sizeof(Slot) + m_free.capacity() * sizeof(uint32_t);
+        bytes += m_ids.bucket_count() * sizeof(void*) + m_ids.size() * (sizeof(std::pair<std::wstring_view, uint32_t>) + 2 * sizeof(void*));
+        for (const auto& slot : m_slots)
+        {
+            bytes += StringBytes(slot.value);
+        }
+        return bytes;
+    }
+
+    // Heap memory of a string, none if it's stored inline.
+    static size_t StringBytes(const std::wstring& value) noexcept
+    {
+        static const size_t inlineCapacity = std::wstring{}.capacity();
+        return value.capacity() > inlineCapacity ? (value.capacity() + 1) * sizeof(wchar_t) : 0;
+    }
+
+private:
+    struct Slot
+    {
+        std::wstring value;
+        uint32_t references{};
+    };
+
+    std::deque<Slot> m_slots;
+    std::vector<uint32_t> m_free;
+    std::unordered_map<std::wstring_view, uint32_t> m_ids;
+};
+
+// Zones applications were last in, by process path, for at most a given number of applications.
+// When it's full, the application which was looked up or moved least recently is forgotten.
+//
+// Paths are stored as an interned directory and the file name, device and zone set ids are
+// interned too: installers and updaters run from a handful of directories, on a handful of work
+// areas, so an entry costs little more than its file name.
+class AppZoneHistory
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1000;
+
+    struct Entry
+    {
+        uint32_t directory{};
+        std::wstring fileName;
+        uint32_t zoneSet{};
+        uint32_t device{};
+        std::vector<int> zoneIndexSet;
+    };
+
+    explicit AppZoneHistory(size_t capacity = DEFAULT_CAPACITY) :
+        m_capacity(capacity ? capacity : 1)
+    {
+    }
+
+    AppZoneHistory(const AppZoneHistory&) = delete;
+    AppZoneHistory& operator=(const AppZoneHistory&) = delete;
+
+    // Looking an application up counts as using it. nullptr if there's no entry for the path.
+    const Entry* Find(std::wstring_view path)
+    {
+        const auto it = m_index.find(KeyOf(path));
+        if (it == m_index.end())
+        {
+            return nullptr;
+        }
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return &*it->second;
+    }
+
+    void Set(std::wstring_view path, std::wstring_view zoneSetUuid, std::wstring_view deviceId, const std::vector<int>& zoneIndexSet)
+    {
+        if (const auto it = m_index.find(KeyOf(path)); it != m_index.end())
+        {
+            auto& entry = *it->second;
+            Reassign(entry.zoneSet, zoneSetUuid);
+            Reassign(entry.device, deviceId);
+            entry.zoneIndexSet = zoneIndexSet;
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return;
+        }
+
+        while (m_entries.size() >= m_capacity)
+        {
+            Remove(std::prev(m_entries.end()));
+            m_evictions++;
+        }
+
+        const size_t separator = path.find_last_of(L"\\/");
+        const auto directory = separator == std::wstring_view::npos ? std::wstring_view{} : path.substr(0, separator + 1);
+        auto& entry = m_entries.emplace_front(Entry{
+            .directory = m_strings.Acquire(directory),
+            .fileName = std::wstring(path.substr(directory.size())),
+            .zoneSet = m_strings.Acquire(zoneSetUuid),
+            .device = m_strings.Acquire(deviceId),
+            .zoneIndexSet = zoneIndexSet,
+        });
+        m_index.emplace(Key{ entry.directory, entry.fileName }, m_entries.begin());
+    }
+
+    bool Erase(std::wstring_view path)
+    {
+        const auto it = m_index.find(KeyOf(path));
+        if (it == m_index.end())
+        {
+            return false;
+        }
+        Remove(it->second);
+        return true;
+    }
+
+    // Replaces every device id for which update returns a different one, returns true if any was.
+    template<typename Update>
+    bool UpdateDeviceIds(Update&& update)
+    {
+        bool modified = false;
+        for (auto& entry : m_entries)
+        {
+            const std::wstring deviceId = update(m_strings.Get(entry.device));
+            if (deviceId != m_strings.Get(entry.device))
+            {
+                Reassign(entry.device, deviceId);
+                modified = true;
+            }
+        }
+        return modified;
+    }
+
+    // Least recently used first, so adding entries back in this order restores the same history.
+    template<typename Visitor>
+    void ForEach(Visitor&& visitor) const
+    {
+        for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it)
+        {
+            visitor(Path(*it), m_strings.Get(it->zoneSet), m_strings.Get(it->device), it->zoneIndexSet);
+        }
+    }
+
+    std::wstring Path(const Entry& entry) const
+    {
+        std::wstring path(m_strings.Get(entry.directory));
+        path += entry.fileName;
+        return path;
+    }
+
+    std::wstring_view ZoneSetUuid(const Entry& entry) const noexcept
+    {
+        return m_strings.Get(entry.zoneSet);
+    }
+
+    std::wstring_view DeviceId(const Entry& entry) const noexcept
+    {
+        return m_strings.Get(entry.device);
+    }
+
+    // Shrinking evicts the least recently used entries right away.
+    void SetCapacity(size_t capacity)
+    {
+        m_capacity = capacity ? capacity : 1;
+        while (m_entries.size() > m_capacity)
+        {
+            Remove(std::prev(m_entries.end()));
+            m_evictions++;
+        }
+    }
+
+    size_t Capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    size_t Size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+    uint64_t Evictions() const noexcept
+    {
+        return m_evictions;
+    }
+
+    void Clear()
+    {
+        while (!m_entries.empty())
+        {
+            Remove(m_entries.begin());
+        }
+    }
+
+    // Estimate of the heap memory used by entries, interned strings and lookup tables.
+    size_t Bytes() const noexcept
+    {
+        // A list node holds the entry and two links, a hash node the key, the iterator and a link
+        size_t bytes = m_entries.size() * (sizeof(Entry) + 2 * sizeof(void*));
+        bytes += m_index.bucket_count() * sizeof(void*) + m_index.size() * (sizeof(std::pair<Key, EntryIterator>) + sizeof(void*));
+        for (const auto& entry : m_entries)
+        {
+            bytes += StringPool::StringBytes(entry.fileName) + entry.zoneIndexSet.capacity() * sizeof(int);
+        }
+        return bytes + m_strings.Bytes();
+    }
+
+    size_t InternedStrings() const noexcept
+    {
+        return m_strings.Count();
+    }
+
+private:
+    using EntryIterator = std::list<Entry>::iterator;
+
+    // The file name is a view of the entry's own string for keys in the index, list nodes don't move
+    struct Key
+    {
+        uint32_t directory{};
+        std::wstring_view fileName;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept
+        {
+            return std::hash<std::wstring_view>{}(key.fileName) ^ (static_cast<size_t>(key.directory) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    // Key of a path, with StringPool::NONE as directory if no entry is in it.
+    Key KeyOf(std::wstring_view path) const
+    {
+        const size_t separator = path.find_last_of(L"\\/");
+        const auto directory = separator == std::wstring_view::npos ? std::wstring_view{} : path.substr(0, separator + 1);
+        return Key{ m_strings.Find(directory), path.substr(directory.size()) };
+    }
+
+    void Reassign(uint32_t& id, std::wstring_view value)
+    {
+        if (m_strings.Get(id) != value)
+        {
+            const uint32_t previous = id;
+            id = m_strings.Acquire(value);
+            m_strings.Release(previous);
+        }
+    }
+
+    void Remove(EntryIterator it)
+    {
+        m_index.erase(Key{ it->directory, it->fileName });
+        m_strings.Release(it->directory);
+        m_strings.Release(it->zoneSet);
+        m_strings.Release(it->device);
+        m_entries.erase(it);
+    }
+
+    size_t m_capacity;
+    uint64_t m_evictions{};
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_map<Key, EntryIterator, KeyHash> m_index;
+    StringPool m_strings;
+};
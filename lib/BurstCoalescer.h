@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Folds a burst of events into a single action. Every event pushes the flush out by the quiet
+// period, but never past the maximum delay measured from the first event of the burst.
+//
+// The quiet period adapts to how long the action takes: the slower a relayout is, the more
+// it pays off to wait for the rest of the burst instead of running it again.
+//
+// Clock requirements (std::chrono::steady_clock satisfies them):
+//     typename Clock::duration, typename Clock::time_point
+//     static time_point now()
+template<typename Clock = std::chrono::steady_clock>
+class BurstCoalescer
+{
+public:
+    using duration = typename Clock::duration;
+    using time_point = typename Clock::time_point;
+
+    struct Config
+    {
+        std::chrono::milliseconds minQuietPeriod{ 15 };
+        std::chrono::milliseconds maxQuietPeriod{ 250 };
+        std::chrono::milliseconds maxDelay{ 500 };
+        double latencyFactor{ 1.5 }; // Quiet period in units of measured action latency
+        double smoothing{ 0.25 }; // Weight of the newest latency sample
+    };
+
+    struct Stats
+    {
+        uint64_t events{};
+        uint64_t bursts{};
+        uint64_t folded{}; // Events which didn't cause an action of their own
+    };
+
+    BurstCoalescer() noexcept :
+        BurstCoalescer(Config{})
+    {
+    }
+
+    explicit BurstCoalescer(const Config& config) noexcept :
+        m_config(config)
+    {
+    }
+
+    // Record an event, returns how long to wait before flushing the burst.
+    duration OnEvent() noexcept
+    {
+        const time_point now = Clock::now();
+        if (m_pendingEvents == 0)
+        {
+            m_burstStart = now;
+        }
+        m_pendingEvents++;
+        m_stats.events++;
+
+        const time_point deadline = (std::min)(now + QuietPeriod(), m_burstStart + duration{ m_config.maxDelay });
+        return (std::max)(deadline - now, duration::zero());
+    }
+
+    // Close the burst, returns false if there was nothing pending.
+    bool Flush() noexcept
+    {
+        if (m_pendingEvents == 0)
+        {
+            return false;
+        }
+
+        m_stats.bursts++;
+        m_stats.folded += m_pendingEvents - 1;
+        m_pendingEvents = 0;
+        return true;
+    }
+
+    void RecordLatency(duration latency) noexcept
+    {
+        const double sample = std::chrono::duration<double, std::milli>(latency).count();
+        m_averageLatency = m_hasLatency ? m_averageLatency + m_config.smoothing * (sample - m_averageLatency) : sample;
+        m_hasLatency = true;
+    }
+
+    duration QuietPeriod() const noexcept
+    {
+        const std::chrono::duration<double, std::milli> quiet{ m_config.latencyFactor * m_averageLatency };
+        return std::clamp(std::chrono::duration_cast<duration>(quiet), duration{ m_config.minQuietPeriod }, duration{ m_config.maxQuietPeriod });
+    }
+
+    const Stats& GetStats() const noexcept
+    {
+        return m_stats;
+    }
+
+private:
+    Config m_config;
+    Stats m_stats;
+    time_point m_burstStart{};
+    uint64_t m_pendingEvents{};
+    double m_averageLatency{}; // Milliseconds
+    bool m_hasLatency{};
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+// Keeps the last known list of virtual desktops and reports which ones were added and removed
+// since, so only work areas and persisted devices of those desktops need to be touched.
+//
+// The virtual desktops registry key also changes on every desktop switch, so most updates carry
+// the same list as before; those are recognized with a single comparison, without hashing.
+template<typename Id, typename Hash = std::hash<Id>>
+class DesktopTopologyTracker
+{
+public:
+    struct Delta
+    {
+        std::vector<Id> added;
+        std::vector<Id> removed;
+
+        bool empty() const noexcept
+        {
+            return added.empty() && removed.empty();
+        }
+    };
+
+    struct Stats
+    {
+        uint64_t updates{};
+        uint64_t unchanged{}; // Updates which only reordered desktops or changed nothing at all
+        uint64_t added{};
+        uint64_t removed{};
+    };
+
+    // Record the current list of desktops, returns the difference to the previous one.
+    // First update reports every desktop as added.
+    Delta Update(const std::vector<Id>& desktops)
+    {
+        m_stats.updates++;
+        Delta delta;
+        if (desktops == m_desktops)
+        {
+            m_stats.unchanged++;
+            return delta;
+        }
+
+        // Deltas follow the order of the desktops
+        std::unordered_set<Id, Hash> current(desktops.begin(), desktops.end());
+        for (const auto& id : desktops)
+        {
+            if (!m_known.contains(id))
+            {
+                delta.added.push_back(id);
+            }
+        }
+        for (const auto& id : m_desktops)
+        {
+            if (!current.contains(id))
+            {
+                delta.removed.push_back(id);
+            }
+        }
+
+        m_desktops = desktops;
+        m_known = std::move(current);
+        if (delta.empty())
+        {
+            m_stats.unchanged++;
+        }
+        m_stats.added += delta.added.size();
+        m_stats.removed += delta.removed.size();
+        return delta;
+    }
+
+    const std::vector<Id>& Desktops() const noexcept
+    {
+        return m_desktops;
+    }
+
+    const Stats& GetStats() const noexcept
+    {
+        return m_stats;
+    }
+
+private:
+    std::vector<Id> m_desktops; // In the order reported by the shell
+    std::unordered_set<Id, Hash> m_known;
+    Stats m_stats;
+};
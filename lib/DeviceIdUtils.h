@@ -0,0 +1,104 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Parsing and checking of the ids zone windows are persisted by, they're made by
+// ZoneWindowUtils::GenerateUniqueId: <parsed device id>_<width>_<height>_<virtual desktop id>
+namespace DeviceIdUtils
+{
+    constexpr std::wstring_view FALLBACK_DEVICE_ID = L"FallbackDevice";
+
+    // We're interested in the unique part between the first and last #'s
+    // Example input: \\?\DISPLAY#DELA026#5&10a58c63&0&UID16777488#{e6f07b5f-ee97-4a90-b076-33f57bf4eaa7}
+    // Example output: DELA026#5&10a58c63&0&UID16777488
+    // Returns a view into deviceId, ids longer than 255 characters are cut like the copy into a
+    // fixed buffer did.
+    inline std::wstring_view ParseDeviceId(std::wstring_view deviceId) noexcept
+    {
+        deviceId = deviceId.substr(0, 255);
+        const auto start = deviceId.find(L'#');
+        const auto end = deviceId.rfind(L'#');
+        if (start == std::wstring_view::npos || start == end)
+        {
+            return FALLBACK_DEVICE_ID;
+        }
+        return deviceId.substr(start + 1, end - start - 1);
+    }
+
+    // IsValidGuid checks the virtual desktop id, JSONHelpers::isValidGuid in the module.
+    template<typename IsValidGuid>
+    bool IsValidDeviceId(const std::wstring& str, IsValidGuid&& isValidGuid)
+    {
+        std::wstring monitorName;
+        std::wstring temp;
+        std::vector<std::wstring> parts;
+        std::wstringstream wss(str);
+
+        /*
+         Important fix for device info that contains a '_' in the name:
+         1. first search for '#'
+         2. Then split the remaining string by '_'
+        */
+
+        // Step 1: parse the name until the #, then to the '_'
+        if (str.find(L'#') != std::string::npos)
+        {
+            std::getline(wss, temp, L'#');
+
+            monitorName = temp;
+
+            if (!std::getline(wss, temp, L'_'))
+            {
+                return false;
+            }
+
+            monitorName += L"#" + temp;
+            parts.push_back(monitorName);
+        }
+
+        // Step 2: parse the rest of the id
+        while (std::getline(wss, temp, L'_'))
+        {
+            parts.push_back(temp);
+        }
+
+        if (parts.size() != 4)
+        {
+            return false;
+        }
+
+        /*
+         Refer to ZoneWindowUtils::GenerateUniqueId parts contain:
+         1. monitor id [string]
+         2. width of device [int]
+         3. height of device [int]
+         4. virtual desktop id (GUID) [string]
+        */
+        try
+        {
+            //check if resolution contain only digits
+            for (const auto& c : parts[1])
+            {
+                std::stoi(std::wstring(&c));
+            }
+            for (const auto& c : parts[2])
+            {
+                std::stoi(std::wstring(&c));
+            }
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+
+        if (!isValidGuid(parts[3]) || parts[0].empty())
+        {
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,491 @@
+#pragma once
+
+#include "BurstCoalescer.h"
+#include "EventTrace.h"
+#include "InMemoryPlatform.h"
+#include "KeyboardHookState.h"
+#include "LatencyHistogram.h"
+#include "LayoutPipeline.h"
+#include "RelayoutRequests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Replay of a recorded session. Recorded inputs go through the same decision logic FancyZones
+// uses (keyboard action table, relayout request coalescing, created-window bursts), and the
+// resulting relayouts run Layout::Model against an in-memory desktop instead of real windows.
+//
+// Time is virtual: events happen at their recorded times, and the window thread is modelled as
+// busy for as long as running a relayout was measured to take, plus an optional synthetic cost
+// per placed window. Requests arriving meanwhile coalesce just like they do on a loaded machine,
+// so how many relayouts run depends on the speed of the machine replaying.
+namespace EventTrace
+{
+    // WinEvent and object ids, same values as in WinUser.h.
+    namespace WinEvent
+    {
+        constexpr uint32_t ObjectCreate = 0x8000;
+        constexpr uint32_t ObjectDestroy = 0x8001;
+        constexpr uint32_t ObjectShow = 0x8002;
+        constexpr uint32_t ObjectHide = 0x8003;
+        constexpr uint32_t ObjectCloaked = 0x8017;
+        constexpr uint32_t ObjectUncloaked = 0x8018;
+        constexpr int32_t ObjectIdWindow = 0;
+    }
+
+    // Virtual clock for BurstCoalescer, advanced by the replayer.
+    struct ReplayClock
+    {
+        using duration = std::chrono::steady_clock::duration;
+        using time_point = std::chrono::steady_clock::time_point;
+
+        static time_point now() noexcept
+        {
+            return current;
+        }
+
+        static inline thread_local time_point current{};
+    };
+
+    // Stand-in for the Windows desktop and the FancyZones window thread. Recorded windows become
+    // InMemoryPlatform windows, and relayouts go through the same stages FancyZones runs: a snapshot
+    // of the platform and zone set state, Layout::Model, and a commit placing windows in their zones.
+    // Like the placement tracker, a window already at its zone's rect isn't placed again.
+    class SimulatedDesktop
+    {
+    public:
+        using WindowHandle = Platform::WindowHandle;
+        using MonitorHandle = Platform::MonitorHandle;
+        using Rect = Platform::Rect;
+
+        explicit SimulatedDesktop(InMemoryPlatform& platform) noexcept :
+            m_platform(platform)
+        {
+        }
+
+        // Returns true if the window wasn't shown before. New windows open on the first monitor.
+        bool WindowShown(uint64_t window)
+        {
+            if (m_windows.contains(window))
+            {
+                return false;
+            }
+
+            Rect area{};
+            Rect workArea{};
+            m_platform.Monitors(m_monitors);
+            if (!m_monitors.empty())
+            {
+                m_platform.GetMonitorRects(m_monitors.front(), area, workArea);
+            }
+            InMemoryPlatform::Window info{};
+            info.processPath = L"C:\\APPS\\REPLAY" + std::to_wstring(window % 50) + L".EXE";
+            info.rect = Rect{ workArea.left + 100, workArea.top + 100, workArea.left + 900, workArea.top + 700 };
+            m_windows.emplace(window, m_platform.AddWindow(std::move(info)));
+            return true;
+        }
+
+        void WindowHidden(uint64_t window)
+        {
+            const auto it = m_windows.find(window);
+            if (it == m_windows.end())
+            {
+                return;
+            }
+            for (auto& [monitor, zoneSet] : m_zoneSets)
+            {
+                std::replace(zoneSet.windows.begin(), zoneSet.windows.end(), it->second, WindowHandle{});
+            }
+            m_platform.RemoveWindow(it->second);
+            m_windows.erase(it);
+        }
+
+        // Hotkeys and created window bursts, returns the number of windows placed.
+        uint64_t Relayout(const std::vector<Relayout::Request>& requests)
+        {
+            if (requests.empty() || !TakeSnapshot(requests))
+            {
+                return 0;
+            }
+            m_model.Compute(m_snapshot, m_result);
+            return Commit();
+        }
+
+        // Display, work area or zone layout changed, every zoned window is placed again.
+        uint64_t PlaceAll()
+        {
+            uint64_t placements = 0;
+            for (const auto& [monitor, zoneSet] : m_zoneSets)
+            {
+                for (size_t i = 0; i < zoneSet.windows.size() && i < zoneSet.zones.size(); i++)
+                {
+                    placements += zoneSet.windows[i] ? Place(zoneSet.windows[i], monitor, zoneSet.zones[i]) : 0;
+                }
+            }
+            return placements;
+        }
+
+        size_t WindowCount() const noexcept
+        {
+            return m_windows.size();
+        }
+
+    private:
+        // Zones are relative to the work area, like in a zone set.
+        struct ZoneSet
+        {
+            std::vector<Rect> zones;
+            std::vector<WindowHandle> windows; // Window in each zone, if any
+            int mainZoneWidth{ 7000 };
+        };
+
+        bool IsInteresting(WindowHandle window) noexcept
+        {
+            return window && m_platform.GetZonableWindowProcess(window, m_processPath) && m_platform.IsOnCurrentDesktop(window);
+        }
+
+        // Same as FancyZones::TakeLayoutSnapshot.
+        bool TakeSnapshot(const std::vector<Relayout::Request>& requests)
+        {
+            const WindowHandle foreground = m_platform.ForegroundWindow();
+            if (!IsInteresting(foreground))
+            {
+                return false;
+            }
+
+            const MonitorHandle monitor = m_platform.MonitorOfWindow(foreground);
+            Rect area{};
+            auto& snapshot = m_snapshot;
+            if (!monitor || !m_platform.GetMonitorRects(monitor, area, snapshot.workArea))
+            {
+                return false;
+            }
+
+            snapshot.requests = requests;
+            snapshot.generation = requests.back().generation;
+            snapshot.takenAt = std::chrono::steady_clock::now();
+            snapshot.monitor = monitor;
+            snapshot.foregroundWindow = foreground;
+            snapshot.cycleAcrossMonitors = false;
+            snapshot.windows.clear();
+            snapshot.zoneIndices.clear();
+
+            const bool snap = std::any_of(requests.begin(), requests.end(), [](const Relayout::Request& request) {
+                return request.kind == Relayout::RequestKind::Snap;
+            });
+            if (snap)
+            {
+                m_platform.TopLevelWindows(m_topLevelWindows);
+                for (const WindowHandle window : m_topLevelWindows)
+                {
+                    if (IsInteresting(window))
+                    {
+                        snapshot.windows.push_back(window);
+                    }
+                }
+            }
+
+            const ZoneSet& zoneSet = m_zoneSets[monitor];
+            snapshot.zoneCount = static_cast<int>(zoneSet.zones.size());
+            snapshot.mainZoneWidth = zoneSet.mainZoneWidth;
+            for (const WindowHandle window : snapshot.windows)
+            {
+                const auto it = std::find(zoneSet.windows.begin(), zoneSet.windows.end(), window);
+                snapshot.zoneIndices.push_back(it != zoneSet.windows.end() ? static_cast<int>(it - zoneSet.windows.begin()) : -1);
+            }
+            return true;
+        }
+
+        // Same as FancyZones::CommitLayout, nothing supersedes a replayed relayout.
+        uint64_t Commit()
+        {
+            const auto& result = m_result;
+            if (result.zonesChanged)
+            {
+                ZoneSet& zoneSet = m_zoneSets[result.monitor];
+                zoneSet.zones = result.zones;
+                zoneSet.mainZoneWidth = result.mainZoneWidth;
+            }
+
+            uint64_t placements = 0;
+            for (size_t i = 0; i < result.order.size(); i++)
+            {
+                const WindowHandle window = result.order[i];
+                const MonitorHandle monitor = result.placeOnWindowMonitor ? m_platform.MonitorOfWindow(window) : result.monitor;
+                ZoneSet& zoneSet = m_zoneSets[monitor];
+                if (!window || i >= zoneSet.zones.size())
+                {
+                    continue;
+                }
+
+                std::replace(zoneSet.windows.begin(), zoneSet.windows.end(), window, WindowHandle{});
+                zoneSet.windows.resize((std::max)(zoneSet.windows.size(), zoneSet.zones.size()));
+                zoneSet.windows[i] = window;
+                placements += Place(window, monitor, zoneSet.zones[i]);
+            }
+
+            if (result.activateFirst && !result.order.empty() && result.order[0])
+            {
+                m_platform.Activate(result.order[0]);
+            }
+            return placements;
+        }
+
+        // Returns 1 if the window had to be moved.
+        uint64_t Place(WindowHandle window, MonitorHandle monitor, const Rect& zone)
+        {
+            Rect area{};
+            Rect workArea{};
+            const auto* info = m_platform.WindowInfo(window);
+            if (!info || !m_platform.GetMonitorRects(monitor, area, workArea))
+            {
+                return 0;
+            }
+
+            const Rect rect{ workArea.left + zone.left, workArea.top + zone.top, workArea.left + zone.right, workArea.top + zone.bottom };
+            if (info->rect.left == rect.left && info->rect.top == rect.top && info->rect.right == rect.right && info->rect.bottom == rect.bottom)
+            {
+                return 0;
+            }
+            m_platform.PlaceWindow(window, rect);
+            return 1;
+        }
+
+        InMemoryPlatform& m_platform;
+        Layout::Model m_model;
+        Layout::Snapshot m_snapshot;
+        Layout::Result m_result;
+        std::unordered_map<uint64_t, WindowHandle> m_windows; // Recorded window to simulated one
+        std::map<MonitorHandle, ZoneSet> m_zoneSets;
+        std::vector<WindowHandle> m_topLevelWindows;
+        std::vector<MonitorHandle> m_monitors;
+        std::wstring m_processPath;
+    };
+
+    struct ReplayOptions
+    {
+        bool displayChangeMoveWindows{}; // Settings::displayChange_moveWindows
+        bool zoneSetChangeMoveWindows{}; // Settings::zoneSetChange_moveWindows
+        // Synthetic, added per placed window for what moving a real window would take. Zero counts
+        // only the measured time of running the relayout against the simulated desktop.
+        std::chrono::nanoseconds syntheticPlacementCost{};
+    };
+
+    // Desktop requirements (SimulatedDesktop satisfies them):
+    //     bool WindowShown(uint64_t window)
+    //     void WindowHidden(uint64_t window)
+    //     uint64_t Relayout(const std::vector<Relayout::Request>& requests), returns windows placed
+    //     uint64_t PlaceAll(), returns windows placed
+    template<typename Desktop = SimulatedDesktop>
+    class Replayer
+    {
+    public:
+        struct Report
+        {
+            uint64_t events{};
+            uint64_t requests{}; // Relayout requests made by hotkeys and created window bursts
+            uint64_t relayouts{}; // Relayouts actually run, after coalescing
+            uint64_t placements{};
+            LatencyHistogram latency; // From the input which caused a relayout to windows placed, in nanoseconds
+            LatencyHistogram relayoutTime; // Measured time of running each relayout, in nanoseconds
+        };
+
+        explicit Replayer(Desktop& desktop, ReplayOptions options = {}) noexcept :
+            m_desktop(desktop),
+            m_options(options)
+        {
+        }
+
+        const Report& Run(const std::vector<Event>& events)
+        {
+            for (const auto& event : events)
+            {
+                const auto at = m_origin + event.time;
+                AdvanceTo(at);
+                ReplayClock::current = at;
+                m_report.events++;
+                Dispatch(event, at);
+            }
+            AdvanceTo(ReplayClock::time_point::max());
+            return m_report;
+        }
+
+    private:
+        using time_point = ReplayClock::time_point;
+
+        void Dispatch(const Event& event, time_point at)
+        {
+            switch (event.kind)
+            {
+            case EventKind::KeyDown:
+                OnKeyDown(event.value, at);
+                break;
+            case EventKind::KeyUp:
+                m_modifiers.Update(event.value, false);
+                break;
+            case EventKind::WinHook:
+                OnWinHook(event, at);
+                break;
+            case EventKind::DisplayChange:
+            case EventKind::WorkAreaChange:
+                if (m_options.displayChangeMoveWindows)
+                {
+                    PlaceAll(at);
+                }
+                break;
+            case EventKind::EditorExit:
+                if (m_options.zoneSetChangeMoveWindows && event.value == EDITOR_EXIT)
+                {
+                    PlaceAll(at);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        void OnKeyDown(uint32_t vkCode, time_point at)
+        {
+            if (m_modifiers.Update(vkCode, true))
+            {
+                return;
+            }
+
+            switch (m_actions.Lookup(m_modifiers.Mask(), vkCode))
+            {
+            case KeyboardHook::KeyAction::Snap:
+                Queue(Relayout::RequestKind::Snap, vkCode, at);
+                break;
+            case KeyboardHook::KeyAction::MainZoneWidth:
+                Queue(Relayout::RequestKind::MainZoneWidth, vkCode, at);
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Every recorded window counts as interesting, the trace has no window properties
+        void OnWinHook(const Event& event, time_point at)
+        {
+            if (event.objectId != WinEvent::ObjectIdWindow)
+            {
+                return;
+            }
+
+            switch (event.value)
+            {
+            case WinEvent::ObjectCreate:
+            case WinEvent::ObjectShow:
+            case WinEvent::ObjectUncloaked:
+                if (m_desktop.WindowShown(event.window))
+                {
+                    if (!m_burstPending)
+                    {
+                        m_burstStart = at;
+                    }
+                    m_burstDeadline = at + m_burst.OnEvent();
+                    m_burstPending = true;
+                }
+                break;
+            case WinEvent::ObjectDestroy:
+            case WinEvent::ObjectHide:
+            case WinEvent::ObjectCloaked:
+                m_desktop.WindowHidden(event.window);
+                break;
+            }
+        }
+
+        void Queue(Relayout::RequestKind kind, uint32_t vkCode, time_point origin)
+        {
+            m_report.requests++;
+            if (m_requests.Submit(kind, vkCode))
+            {
+                m_requestsOrigin = origin;
+                m_requestsPending = true;
+            }
+        }
+
+        // Runs everything the window thread would have done up to given time.
+        void AdvanceTo(time_point limit)
+        {
+            for (;;)
+            {
+                const time_point burstAt = m_burstPending ? (std::max)(m_burstDeadline, m_busyUntil) : time_point::max();
+                const time_point requestsAt = m_requestsPending ? (std::max)(m_requestsOrigin, m_busyUntil) : time_point::max();
+                const time_point next = (std::min)(burstAt, requestsAt);
+                if (next == time_point::max() || next > limit)
+                {
+                    return;
+                }
+
+                ReplayClock::current = next;
+                if (burstAt <= requestsAt)
+                {
+                    m_burstPending = false;
+                    if (m_burst.Flush())
+                    {
+                        Queue(Relayout::RequestKind::Snap, 0, m_burstStart);
+                    }
+                }
+                else
+                {
+                    m_requestsPending = false;
+                    m_requests.TakeAll(m_taken);
+                    const auto measureStart = std::chrono::steady_clock::now();
+                    const uint64_t placements = m_desktop.Relayout(m_taken);
+                    const auto cost = Cost(measureStart, placements);
+                    m_burst.RecordLatency(cost);
+                    Execute(next, m_requestsOrigin, placements, cost);
+                }
+            }
+        }
+
+        void PlaceAll(time_point at)
+        {
+            const auto measureStart = std::chrono::steady_clock::now();
+            const uint64_t placements = m_desktop.PlaceAll();
+            Execute((std::max)(at, m_busyUntil), at, placements, Cost(measureStart, placements));
+        }
+
+        ReplayClock::duration Cost(std::chrono::steady_clock::time_point measureStart, uint64_t placements)
+        {
+            const auto measured = std::chrono::steady_clock::now() - measureStart;
+            m_report.relayoutTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(measured));
+            return std::chrono::duration_cast<ReplayClock::duration>(measured + m_options.syntheticPlacementCost * static_cast<int64_t>(placements));
+        }
+
+        void Execute(time_point start, time_point origin, uint64_t placements, ReplayClock::duration cost)
+        {
+            const time_point end = start + cost;
+            m_busyUntil = end;
+            m_report.relayouts++;
+            m_report.placements += placements;
+            m_report.latency.Record(end - origin);
+        }
+
+        static constexpr uint32_t EDITOR_EXIT = 0; // EditorExitKind::Exit, the editor wasn't terminated
+
+        Desktop& m_desktop;
+        const ReplayOptions m_options;
+        Report m_report;
+
+        KeyboardHook::ModifierState m_modifiers;
+        const KeyboardHook::ActionTable m_actions{ KeyboardHook::ActionTable::FancyZonesDefaults() };
+        Relayout::RequestQueue m_requests;
+        std::vector<Relayout::Request> m_taken;
+        BurstCoalescer<ReplayClock> m_burst;
+
+        const time_point m_origin{ std::chrono::hours{ 1 } }; // Keeps virtual times away from the clock's epoch
+        time_point m_busyUntil{};
+        time_point m_requestsOrigin{};
+        bool m_requestsPending{};
+        time_point m_burstStart{};
+        time_point m_burstDeadline{};
+        bool m_burstPending{};
+    };
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "HookEventQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <vector>
+
+// Recording of the inputs which drive FancyZones, so a session can be replayed later.
+//
+// File layout, little endian:
+//     FileHeader
+//     Record * n
+// Records are fixed size. Timestamps are stored as the distance to the previous record, in
+// microseconds, so a record takes 24 bytes regardless of how long the session ran.
+namespace EventTrace
+{
+    enum class EventKind : uint8_t
+    {
+        WinHook = 1, // value: WinEvent id, objectId: idObject
+        KeyDown, // value: virtual key code, only modifiers and keys with an action are recorded
+        KeyUp, // value: virtual key code, only modifiers are recorded
+        DisplayChange,
+        WorkAreaChange,
+        DesktopSwitch,
+        DesktopUpdate,
+        EditorExit, // value: EditorExitKind
+    };
+
+    struct FileHeader
+    {
+        char magic[4]{ 'F', 'T', 'T', 'R' };
+        uint32_t version{ 1 };
+        uint32_t recordSize{};
+        uint32_t reserved{};
+    };
+    static_assert(sizeof(FileHeader) == 16);
+
+    struct Record
+    {
+        uint32_t deltaUs{}; // Since previous record, saturated
+        EventKind kind{};
+        uint8_t reserved[3]{};
+        uint32_t value{};
+        int32_t objectId{};
+        uint64_t window{};
+    };
+    static_assert(sizeof(Record) == 24);
+
+    // Event with its absolute time, as recorded and as read back.
+    struct Event
+    {
+        std::chrono::microseconds time{}; // Since recording started
+        EventKind kind{};
+        uint32_t value{};
+        int32_t objectId{};
+        uint64_t window{};
+    };
+
+    // Events are appended lock-free from any thread, including hooks, and written to the file
+    // by whichever thread calls Flush, e.g. on a timer. Flush, Start and Stop are serialized, a
+    // flush racing a stop either writes before the file is closed or finds it closed. Events which
+    // don't fit into the queue between two flushes are counted and dropped.
+    class Recorder
+    {
+    public:
+        static constexpr size_t QUEUE_CAPACITY = 4096;
+
+        Recorder() = default;
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+
+        ~Recorder()
+        {
+            Stop();
+        }
+
+        bool Start(const std::filesystem::path& path)
+        {
+            std::scoped_lock lock{ m_writeLock };
+            StopLocked();
+            m_file.open(path, std::ios::binary | std::ios::trunc);
+            if (!m_file)
+            {
+                return false;
+            }
+
+            FileHeader header{};
+            header.recordSize = sizeof(Record);
+            m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            // Events appended while a previous recording was stopping belong to neither file
+            Event stale;
+            while (m_queue.TryPop(stale))
+            {
+            }
+
+            m_start = std::chrono::steady_clock::now();
+            m_lastWritten = {};
+            m_dropped.store(0, std::memory_order_relaxed);
+            m_recording.store(true, std::memory_order_release);
+            return true;
+        }
+
+        void Stop()
+        {
+            std::scoped_lock lock{ m_writeLock };
+            StopLocked();
+        }
+
+        bool IsRecording() const noexcept
+        {
+            return m_recording.load(std::memory_order_acquire);
+        }
+
+        void Append(EventKind kind, uint64_t window = 0, uint32_t value = 0, int32_t objectId = 0) noexcept
+        {
+            if (!IsRecording())
+            {
+                return;
+            }
+
+            const auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+            if (!m_queue.TryPush(Event{ time, kind, value, objectId, window }))
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void Flush()
+        {
+            std::scoped_lock lock{ m_writeLock };
+            FlushLocked();
+        }
+
+        uint64_t Dropped() const noexcept
+        {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void StopLocked()
+        {
+            if (m_recording.exchange(false, std::memory_order_acq_rel))
+            {
+                FlushLocked();
+                m_file.close();
+            }
+        }
+
+        void FlushLocked()
+        {
+            if (!m_file.is_open())
+            {
+                return;
+            }
+
+            Event event;
+            while (m_queue.TryPop(event))
+            {
+                // Producers may enqueue slightly out of order, deltas never go negative
+                const auto delta = (std::max)(event.time - m_lastWritten, std::chrono::microseconds::zero());
+                m_lastWritten = (std::max)(event.time, m_lastWritten);
+
+                Record record{};
+                record.deltaUs = delta.count() > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(delta.count());
+                record.kind = event.kind;
+                record.value = event.value;
+                record.objectId = event.objectId;
+                record.window = event.window;
+                m_file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            }
+            m_file.flush();
+        }
+
+        HookEvents::MpscRing<Event, QUEUE_CAPACITY> m_queue;
+        std::atomic<bool> m_recording{ false };
+        std::atomic<uint64_t> m_dropped{ 0 };
+        std::chrono::steady_clock::time_point m_start{};
+        std::chrono::microseconds m_lastWritten{};
+        std::mutex m_writeLock; // Never taken by Append
+        std::ofstream m_file;
+    };
+
+    // Returns false if the stream isn't a trace, a truncated last record is ignored.
+    inline bool Read(std::istream& stream, std::vector<Event>& events)
+    {
+        FileHeader header{};
+        const FileHeader expected{};
+        if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+            header.version != expected.version ||
+            header.recordSize != sizeof(Record))
+        {
+            return false;
+        }
+
+        std::chrono::microseconds time{};
+        Record record{};
+        while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        {
+            time += std::chrono::microseconds{ record.deltaUs };
+            events.push_back(Event{ time, record.kind, record.value, record.objectId, record.window });
+        }
+        return true;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Matching of process paths against the apps excluded from zoning, both already upper case.
+namespace ExcludedApps
+{
+    // Same matching as find_app_name_in_path from the PowerToys common library: an app matches
+    // when its last occurrence in the path covers the start of the file name.
+    inline bool Matches(std::wstring_view processPath, const std::vector<std::wstring>& apps) noexcept
+    {
+        const auto lastSlash = processPath.rfind(L'\\');
+        for (const auto& app : apps)
+        {
+            const auto pos = processPath.rfind(app);
+            if (pos != std::wstring_view::npos && pos <= lastSlash + 1 && pos + app.length() > lastSlash)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 
 #include <common/dpi_aware.h>
+#include <common/settings_helpers.h>
 #include <common/on_thread_executor.h>
 #include <common/window_helpers.h>
 
@@ -10,12 +11,35 @@
 #include "lib/JsonHelpers.h"
 #include "lib/ZoneSet.h"
 #include "lib/WindowMoveHandler.h"
+#include "lib/WindowAnimator.h"
+#include "lib/PlacementTracker.h"
+#include "lib/Platform.h"
+#include "lib/LayoutPipeline.h"
+#include "lib/RelayoutRequests.h"
 #include "lib/FancyZonesWinHookEventIDs.h"
+#include "lib/HookEventQueue.h"
+#include "lib/BurstCoalescer.h"
+#include "lib/KeyboardHookState.h"
+#include "lib/LatencyHistogram.h"
+#include "lib/LatencyTrace.h"
+#include "lib/LockProfiler.h"
+#include "lib/DesktopTopology.h"
+#include "lib/EventTrace.h"
+#include "lib/AllocationTracker.h"
+#include "lib/MetricsBlock.h"
+#include "lib/StartupTimeline.h"
+#include "lib/FlightRecorder.h"
+#include "lib/MonitorTopology.h"
+#include "lib/ZoneNeighborIndex.h"
 #include "lib/util.h"
 #include "VirtualDesktopUtils.h"
+#include "VirtualDesktopDispatcher.h"
 
 #include <interface/win_hook_event_data.h>
 
+#include <atomic>
+#include <condition_variable>
+
 enum class DisplayChangeType
 {
     WorkArea,
@@ -24,6 +48,24 @@ enum class DisplayChangeType
     Initialization
 };
 
+// Places in code which take FancyZones::m_lock, each one has its own contention counters
+enum class LockSite : uint8_t
+{
+    Run,
+    Destroy,
+    ToggleEditor,
+    EditorExit,
+    SettingsChanged,
+    AddZoneWindow,
+    ParentZoneWindow,
+    UpdateWindowsPositions,
+    LayoutSnapshot,
+    CommitLayout,
+    VirtualDesktopUpdates,
+    MonitorData,
+    Count
+};
+
 namespace std
 {
     template<>
@@ -48,6 +90,12 @@ public:
         m_settings->SetCallback(this);
     }
 
+    ~FancyZones()
+    {
+        // The executor waits for its running task when destroyed, the worker loop has to end first
+        StopLayoutWorker();
+    }
+
     // IFancyZones
     IFACEMETHODIMP_(void)
     Run() noexcept;
@@ -57,24 +105,25 @@ public:
     IFACEMETHODIMP_(void)
     HandleWinHookEvent(const WinHookEvent* data) noexcept
     {
-        const auto wparam = reinterpret_cast<WPARAM>(data->hwnd);
-        const LONG lparam = 0;
-        std::shared_lock readLock(m_lock);
+        m_eventTrace.Append(EventTrace::EventKind::WinHook, reinterpret_cast<uintptr_t>(data->hwnd), data->event, data->idObject);
+
+        // Location and name changes have no handler in WndProc, they aren't queued, neither are destroys.
         switch (data->event)
         {
-        case EVENT_OBJECT_LOCATIONCHANGE:
-            PostMessageW(m_window, WM_PRIV_LOCATIONCHANGE, wparam, lparam);
-            break;
-        case EVENT_OBJECT_NAMECHANGE:
-            PostMessageW(m_window, WM_PRIV_NAMECHANGE, wparam, lparam);
-            break;
-
         case EVENT_OBJECT_UNCLOAKED:
         case EVENT_OBJECT_SHOW:
         case EVENT_OBJECT_CREATE:
+            // All of them mean the same to us, record them as one event so they coalesce per window
+            if (data->idObject == OBJID_WINDOW && m_hookEvents.Push(data->hwnd, EVENT_OBJECT_CREATE) && !Wake(WM_PRIV_WINDOWCREATED))
+            {
+                m_hookEvents.CancelWake();
+            }
+            break;
+        case EVENT_OBJECT_DESTROY:
+            // Cheaper than pruning every tracked window on each snap
             if (data->idObject == OBJID_WINDOW)
             {
-                PostMessageW(m_window, WM_PRIV_WINDOWCREATED, wparam, lparam);
+                PlacementTrackerInstance().Forget(data->hwnd);
             }
             break;
         }
@@ -87,11 +136,15 @@ public:
     IFACEMETHODIMP_(bool)
     OnKeyDown(PKBDLLHOOKSTRUCT info) noexcept;
     IFACEMETHODIMP_(void)
+    OnKeyUp(PKBDLLHOOKSTRUCT info) noexcept;
+    IFACEMETHODIMP_(void)
     ToggleEditor() noexcept;
     IFACEMETHODIMP_(void)
     SettingsChanged() noexcept;
     
     void WindowCreated(HWND window) noexcept;
+    void ProcessHookEvents() noexcept;
+    void OnWindowCreatedBurst() noexcept;
 
     // IZoneWindowHost
     IFACEMETHODIMP_(void)
@@ -99,8 +152,7 @@ public:
     IFACEMETHODIMP_(IZoneWindow*)
     GetParentZoneWindow(HMONITOR monitor) noexcept
     {
-        //NOTE: as public method it's unsafe without lock, but it's called from AddZoneWindow through making ZoneWindow that causes deadlock
-        //TODO: needs refactoring
+        auto readLock = LockForRead(LockSite::ParentZoneWindow);
         auto it = m_zoneWindowMap.find(monitor);
         if (it != m_zoneWindowMap.end())
         {
@@ -141,10 +193,26 @@ private:
         }
     };
 
+    using ReadLock = ProfiledLock<std::shared_lock<std::shared_mutex>>;
+    using WriteLock = ProfiledLock<std::unique_lock<std::shared_mutex>>;
+
+    ReadLock LockForRead(LockSite site) const noexcept
+    {
+        return ReadLock(m_lock, m_lockStats[static_cast<size_t>(site)]);
+    }
+
+    WriteLock LockForWrite(LockSite site) const noexcept
+    {
+        return WriteLock(m_lock, m_lockStats[static_cast<size_t>(site)]);
+    }
+
+    void PublishStats() const noexcept;
+    void PublishDataFootprint() const noexcept;
+    void UpdateEventTrace() noexcept;
+    void DumpLatencyTrace() const noexcept;
+
     void UpdateZoneWindows() noexcept;
     void UpdateWindowsPositions() noexcept;
-    void SettleWindowsPositions() noexcept;
-    bool OnSnapHotkey(DWORD vkCode) noexcept;
     void RegisterVirtualDesktopUpdates(std::vector<GUID>& ids) noexcept;
     void RegisterNewWorkArea(GUID virtualDesktopId, HMONITOR monitor) noexcept;
     bool IsNewWorkArea(GUID virtualDesktopId, HMONITOR monitor) noexcept;
@@ -152,20 +220,35 @@ private:
     void OnEditorExitEvent() noexcept;
     bool ProcessSnapHotkey() noexcept;
 
-    bool CycleWindows(DWORD vkCode, HMONITOR monitor, MONITORINFO mi);
-    std::vector<HWND> GetWindowList(void) noexcept;
-    bool OnWidthChangeHotkey(DWORD vkCode) noexcept;
-
-    std::vector<std::pair<HMONITOR, RECT>> GetRawMonitorData() noexcept;
-    std::vector<HMONITOR> GetMonitorsSorted() noexcept;
+    bool HandleKeyDown(DWORD vkCode, LatencyTrace::TimePoint inputAt) noexcept;
+    void QueueRelayout(Relayout::RequestKind kind, DWORD vkCode, LatencyTrace::TimePoint inputAt = LatencyTrace::Now()) noexcept;
+    bool Wake(UINT message) const noexcept;
+    void ProcessRelayoutRequests() noexcept;
+    bool TakeLayoutSnapshot(Layout::Snapshot& snapshot) noexcept;
+    void RunLayoutWorker() noexcept;
+    void StopLayoutWorker() noexcept;
+    void CommitLayout() noexcept;
+    const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& PlacementZoneWindows() noexcept;
+    void GetWindowList(std::vector<HWND>& windows) noexcept;
+    void UpdateZoneNeighbors(HMONITOR monitor, IZoneWindow* zoneWindow) noexcept;
+    void UpdateZoneNeighbors() noexcept;
 
     const HINSTANCE m_hinstance{};
 
+    // Guards the zone window map, processed work areas and the editor event. No OS call is made while
+    // it's held: zone sets are only modified on the FancyZones window thread, which places windows
+    // using a copy of the zone window map.
     mutable std::shared_mutex m_lock;
+    mutable std::array<LockSiteStats, static_cast<size_t>(LockSite::Count)> m_lockStats;
     HWND m_window{};
+    std::atomic<HWND> m_wakeWindow{}; // Same as m_window, for hook and worker threads which don't take the lock
     WindowMoveHandler m_windowMoveHandler;
+    WindowAnimator m_windowAnimator;
 
     std::map<HMONITOR, winrt::com_ptr<IZoneWindow>> m_zoneWindowMap; // Map of monitor to ZoneWindow (one per monitor)
+    uint64_t m_zoneWindowMapVersion{}; // Bumped whenever the zone window map changes
+    ZoneNeighborIndex m_zoneNeighbors; // Zones of every active zone set in virtual-screen coordinates, window thread only
+    std::vector<RECT> m_neighborZoneRects;
     winrt::com_ptr<IFancyZonesSettings> m_settings{};
     GUID m_currentVirtualDesktopId{}; // UUID of the current virtual desktop. Is GUID_NULL until first VD switch per session.
     std::unordered_map<GUID, std::vector<HMONITOR>> m_processedWorkAreas; // Work area is defined by monitor and virtual desktop id.
@@ -175,14 +258,55 @@ private:
     OnThreadExecutor m_dpiUnawareThread;
     OnThreadExecutor m_virtualDesktopTrackerThread;
 
-    std::vector<HWND> m_currentHwndList;
+    Relayout::RequestQueue m_relayoutRequests;
+    HookEvents::EventQueue<HWND, 256> m_hookEvents;
+    BurstCoalescer<> m_windowCreatedBurst; // Only used on the FancyZones window thread
+    DesktopTopologyTracker<GUID> m_desktopTopology; // Only used on the FancyZones window thread
+    std::optional<LatencyTrace::TimePoint> m_relayoutInputAt; // Oldest input of relayouts not placed yet, only used on the FancyZones window thread
+    EventTrace::Recorder m_eventTrace; // Appended to from any thread, flushed on the FancyZones window thread, stopped by Destroy too
+    Metrics::Publisher m_metrics;
+
+    // Kept from one relayout to the next for their buffers, only used on the FancyZones window thread
+    Layout::Snapshot m_snapshot;
+    Layout::Result m_commitResult;
+    std::vector<HWND> m_topLevelWindows;
+    std::vector<int> m_placementIndexSet;
+    std::map<HMONITOR, winrt::com_ptr<IZoneWindow>> m_placementZoneWindows; // Copy of the zone window map
+    uint64_t m_placementZoneWindowsVersion{}; // Version of the zone window map it was copied from
+
+    // Only used on the keyboard hook thread
+    KeyboardHook::ModifierState m_modifierState;
+    const KeyboardHook::ActionTable m_keyActions{ KeyboardHook::ActionTable::FancyZonesDefaults() };
+
+    // Worker threads, declared last so they're joined before the state their tasks use goes away
+    Layout::Model m_layoutModel; // Only used on the layout thread
+    std::mutex m_layoutLock; // Guards the exchange of snapshots and results with the layout worker
+    std::condition_variable m_layoutWake;
+    Layout::Snapshot m_pendingSnapshot; // Waiting to be picked up by the layout worker
+    bool m_snapshotPending{};
+    Layout::Result m_layoutResult; // Latest computed layout, waiting to be committed
+    bool m_resultPending{};
+    bool m_stopLayoutWorker{};
+    OnThreadExecutor m_layoutThread; // Runs the layout worker loop until it's stopped
+    VirtualDesktopDispatcher m_virtualDesktopDispatcher; // Completions queue relayouts
 
     static UINT WM_PRIV_VD_INIT; // Scheduled when FancyZones is initialized
     static UINT WM_PRIV_VD_SWITCH; // Scheduled when virtual desktop switch occurs
     static UINT WM_PRIV_VD_UPDATE; // Scheduled on virtual desktops update (creation/deletion)
     static UINT WM_PRIV_EDITOR; // Scheduled when the editor exits
+    static UINT WM_PRIV_SETTINGS; // Scheduled when settings change
+    static UINT WM_PRIV_DUMP_LATENCY; // Posted by tools to the FancyTiling window, writes latency histograms out when built with tracing and refreshes the published stats
+    static UINT WM_PRIV_DUMP_FLIGHT_RECORDER; // Posted by tools to the FancyTiling window, writes the flight recorder out
 
-    static UINT WM_PRIV_LOWLEVELKB; // Scheduled when we receive a key down press
+    static UINT WM_PRIV_LOWLEVELKB; // Scheduled when a relayout is queued while none was pending
+    static UINT WM_PRIV_LAYOUT; // Scheduled when the layout worker has computed a layout
+
+    static constexpr UINT_PTR WINDOW_CREATED_TIMER_ID = 1; // Fires when a burst of created windows settles
+    static constexpr UINT_PTR EVENT_TRACE_TIMER_ID = 2; // Fires while recording, to write out recorded events
+    static constexpr UINT EVENT_TRACE_FLUSH_INTERVAL_MS = 1000;
+    static constexpr wchar_t EVENT_TRACE_FILE[] = L"event-trace.bin";
+    static constexpr wchar_t LATENCY_TRACE_FILE[] = L"latency-trace.json";
+    static constexpr wchar_t FLIGHT_RECORDER_FILE[] = L"flight-recorder.bin";
 
     // Did we terminate the editor or was it closed cleanly?
     enum class EditorExitKind : byte
@@ -196,52 +320,121 @@ UINT FancyZones::WM_PRIV_VD_INIT = RegisterWindowMessage(L"{469818a8-00fa-4069-b
 UINT FancyZones::WM_PRIV_VD_SWITCH = RegisterWindowMessage(L"{128c2cb0-6bdf-493e-abbe-f8705e04aa95}");
 UINT FancyZones::WM_PRIV_VD_UPDATE = RegisterWindowMessage(L"{b8b72b46-f42f-4c26-9e20-29336cf2f22e}");
 UINT FancyZones::WM_PRIV_EDITOR = RegisterWindowMessage(L"{87543824-7080-4e91-9d9c-0404642fc7b6}");
+UINT FancyZones::WM_PRIV_SETTINGS = RegisterWindowMessage(L"{d4e1b7a2-9c38-4f65-8a0e-3b5f27c9e614}");
+UINT FancyZones::WM_PRIV_DUMP_LATENCY = RegisterWindowMessage(L"{6b0f3e91-27ad-4c58-b1e4-90d2a7c35f8e}");
+UINT FancyZones::WM_PRIV_DUMP_FLIGHT_RECORDER = RegisterWindowMessage(L"{c3a85e17-4d92-4b6f-8e05-7f1b29d6a4c8}");
 UINT FancyZones::WM_PRIV_LOWLEVELKB = RegisterWindowMessage(L"{763c03a3-03d9-4cde-8d71-f0358b0b4b52}");
+UINT FancyZones::WM_PRIV_LAYOUT = RegisterWindowMessage(L"{2f6a1c8e-5b0d-4f7e-9a43-d1e6c9b27f05}");
+
+namespace
+{
+    wchar_t s_flightRecorderPath[MAX_PATH]{}; // Resolved up front, the crash handler mustn't allocate
+    LPTOP_LEVEL_EXCEPTION_FILTER s_previousExceptionFilter{};
+
+    void __stdcall RecordFailure(const wil::FailureInfo& failure) noexcept
+    {
+        FlightRecorder::LogFailure(failure.hr, failure.uLineNumber, failure.pszFile ? failure.pszFile : "");
+    }
+
+    bool WriteFlightRecorder(const wchar_t* path) noexcept
+    {
+        wil::unique_hfile file(CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!file)
+        {
+            return false;
+        }
+
+        bool written = true;
+        FlightRecorder::Dump([&](const void* data, size_t size) {
+            DWORD bytes = 0;
+            written = written && WriteFile(file.get(), data, static_cast<DWORD>(size), &bytes, nullptr) && bytes == size;
+        });
+        return written;
+    }
+
+    LONG WINAPI DumpFlightRecorderOnCrash(EXCEPTION_POINTERS* exception)
+    {
+        WriteFlightRecorder(s_flightRecorderPath);
+        return s_previousExceptionFilter ? s_previousExceptionFilter(exception) : EXCEPTION_CONTINUE_SEARCH;
+    }
+}
 
 // IFancyZones
 IFACEMETHODIMP_(void)
 FancyZones::Run() noexcept
 {
-    std::unique_lock writeLock(m_lock);
+    {
+        Startup::PhaseTimer timer(Startup::Phase::Window);
 
-    WNDCLASSEXW wcex{};
-    wcex.cbSize = sizeof(WNDCLASSEX);
-    wcex.lpfnWndProc = s_WndProc;
-    wcex.hInstance = m_hinstance;
-    wcex.lpszClassName = L"FancyTiling";
-    RegisterClassExW(&wcex);
+        WNDCLASSEXW wcex{};
+        wcex.cbSize = sizeof(WNDCLASSEX);
+        wcex.lpfnWndProc = s_WndProc;
+        wcex.hInstance = m_hinstance;
+        wcex.lpszClassName = L"FancyTiling";
+        RegisterClassExW(&wcex);
 
-    BufferedPaintInit();
+        HWND window = CreateWindowExW(WS_EX_TOOLWINDOW, L"FancyTiling", L"", WS_POPUP, 0, 0, 0, 0, nullptr, nullptr, m_hinstance, this);
+        if (!window)
+            return;
 
-    m_window = CreateWindowExW(WS_EX_TOOLWINDOW, L"FancyTiling", L"", WS_POPUP, 0, 0, 0, 0, nullptr, nullptr, m_hinstance, this);
-    if (!m_window)
-        return;
+        auto writeLock = LockForWrite(LockSite::Run);
+        m_window = window;
+        m_wakeWindow.store(window, std::memory_order_release);
+    }
 
     // RegisterHotKey(m_window, 1, m_settings->GetSettings()->editorHotkey.get_modifiers(), m_settings->GetSettings()->editorHotkey.get_code());
 
+    UpdateEventTrace();
+    m_metrics.Start(GetCurrentProcessId());
+
+    const std::wstring flightRecorderPath = PTSettingsHelper::get_module_save_folder_location(L"FancyZones") + L"\\" + FLIGHT_RECORDER_FILE;
+    StringCchCopyW(s_flightRecorderPath, ARRAYSIZE(s_flightRecorderPath), flightRecorderPath.c_str());
+    s_previousExceptionFilter = SetUnhandledExceptionFilter(DumpFlightRecorderOnCrash);
+    wil::SetResultLoggingCallback(RecordFailure);
+    JSONHelpers::FancyZonesDataInstance().SetAppZoneHistoryCapacity(m_settings->GetSettings()->appZoneHistoryCapacity);
     VirtualDesktopInitialize();
 
+    Startup::PhaseTimer timer(Startup::Phase::Workers);
+
+    // Tasks run in order, later ones submitted to this thread find it set up without waiting here
     m_dpiUnawareThread.submit(OnThreadExecutor::task_t{ [] {
-                          SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_UNAWARE);
-                          SetThreadDpiHostingBehavior(DPI_HOSTING_BEHAVIOR_MIXED);
-                      } })
-        .wait();
+        SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_UNAWARE);
+        SetThreadDpiHostingBehavior(DPI_HOSTING_BEHAVIOR_MIXED);
+    } });
 
     m_terminateVirtualDesktopTrackerEvent.reset(CreateEvent(nullptr, FALSE, FALSE, nullptr));
     m_virtualDesktopTrackerThread.submit(OnThreadExecutor::task_t{ [&] { VirtualDesktopUtils::HandleVirtualDesktopUpdates(m_window, WM_PRIV_VD_UPDATE, m_terminateVirtualDesktopTrackerEvent.get()); } });
+    m_layoutThread.submit(OnThreadExecutor::task_t{ [this] { RunLayoutWorker(); } });
 }
 
 // IFancyZones
 IFACEMETHODIMP_(void)
 FancyZones::Destroy() noexcept
 {
-    std::unique_lock writeLock(m_lock);
-    m_zoneWindowMap.clear();
-    BufferedPaintUnInit();
-    if (m_window)
+    std::map<HMONITOR, winrt::com_ptr<IZoneWindow>> zoneWindowMap;
+    HWND window{};
     {
-        DestroyWindow(m_window);
-        m_window = nullptr;
+        auto writeLock = LockForWrite(LockSite::Destroy);
+        zoneWindowMap.swap(m_zoneWindowMap);
+        m_zoneWindowMapVersion++;
+        window = std::exchange(m_window, nullptr);
+        m_wakeWindow.store(nullptr, std::memory_order_release);
+    }
+
+    // Zone windows destroy their windows when released
+    StopLayoutWorker();
+    zoneWindowMap.clear();
+    m_placementZoneWindows.clear();
+    m_zoneNeighbors.Clear();
+    m_eventTrace.Stop();
+    m_metrics.Stop();
+    DumpLatencyTrace();
+    wil::SetResultLoggingCallback(nullptr);
+    SetUnhandledExceptionFilter(s_previousExceptionFilter);
+    VirtualDesktopUtils::ReleaseShellServices();
+    if (window)
+    {
+        DestroyWindow(window);
     }
     if (m_terminateVirtualDesktopTrackerEvent)
     {
@@ -249,6 +442,77 @@ FancyZones::Destroy() noexcept
     }
 }
 
+// Stats kept by other parts of the module, summed into the metrics block. Called after startup,
+// after every committed layout and when a tool asks.
+void FancyZones::PublishStats() const noexcept
+{
+    using Metrics::Counter;
+
+    const auto& latency = KeyboardHookLatency();
+    Metrics::Set(Counter::KeyboardHookEvents, latency.Count());
+    Metrics::Set(Counter::KeyboardHookP99Nanos, latency.ValueAtPercentile(99));
+    Metrics::Set(Counter::KeyboardHookMaxNanos, latency.Max());
+    Metrics::Set(Counter::EventTraceDropped, m_eventTrace.Dropped());
+
+    // Acquisitions, contended, wait and max wait counters of each lock are consecutive
+    const auto publishLock = [](Counter first, size_t sites, auto&& siteStats) {
+        uint64_t acquisitions = 0, contended = 0, waitNs = 0, maxWaitNs = 0;
+        for (size_t i = 0; i < sites; i++)
+        {
+            const LockSiteStats& stats = siteStats(i);
+            acquisitions += stats.acquisitions.load(std::memory_order_relaxed);
+            contended += stats.contended.load(std::memory_order_relaxed);
+            waitNs += stats.waitNs.load(std::memory_order_relaxed);
+            maxWaitNs = (std::max)(maxWaitNs, stats.maxWaitNs.load(std::memory_order_relaxed));
+        }
+        const auto index = static_cast<uint32_t>(first);
+        Metrics::Set(first, acquisitions);
+        Metrics::Set(static_cast<Counter>(index + 1), contended);
+        Metrics::Set(static_cast<Counter>(index + 2), waitNs);
+        Metrics::Set(static_cast<Counter>(index + 3), maxWaitNs);
+    };
+    publishLock(Counter::LockAcquisitions, m_lockStats.size(), [this](size_t i) -> const LockSiteStats& {
+        return m_lockStats[i];
+    });
+    const auto& fancyZonesData = JSONHelpers::FancyZonesDataInstance();
+    publishLock(Counter::DataLockAcquisitions, static_cast<size_t>(JSONHelpers::DataLockSite::Count), [&fancyZonesData](size_t i) -> const LockSiteStats& {
+        return fancyZonesData.GetLockStats(static_cast<JSONHelpers::DataLockSite>(i));
+    });
+
+    uint64_t allocations = 0, allocationBytes = 0;
+    for (size_t i = 1; i < static_cast<size_t>(Allocations::Action::Count); i++)
+    {
+        const auto& counters = Allocations::Of(static_cast<Allocations::Action>(i));
+        allocations += counters.allocations.load(std::memory_order_relaxed);
+        allocationBytes += counters.bytes.load(std::memory_order_relaxed);
+    }
+    Metrics::Set(Counter::TrackedAllocations, allocations);
+    Metrics::Set(Counter::TrackedAllocationBytes, allocationBytes);
+
+    static_assert(static_cast<size_t>(Counter::StartupShellServicesMicros) - static_cast<size_t>(Counter::StartupDataLoadMicros) + 1 == static_cast<size_t>(Startup::Phase::Count));
+    for (size_t i = 0; i < static_cast<size_t>(Startup::Phase::Count); i++)
+    {
+        const auto span = Startup::s_timeline.Get(static_cast<Startup::Phase>(i));
+        if (span.recorded)
+        {
+            Metrics::Set(static_cast<Counter>(static_cast<size_t>(Counter::StartupDataLoadMicros) + i), span.Duration().count());
+        }
+    }
+}
+
+// Walks all persisted data under its lock, so only after startup and when a tool asks.
+void FancyZones::PublishDataFootprint() const noexcept
+{
+    uint64_t entries = 0, bytes = 0;
+    for (const auto& section : JSONHelpers::FancyZonesDataInstance().GetMemoryFootprint())
+    {
+        entries += section.entries;
+        bytes += section.bytes;
+    }
+    Metrics::Set(Metrics::Counter::DataEntries, entries);
+    Metrics::Set(Metrics::Counter::DataBytes, bytes);
+}
+
 // IFancyZonesCallback
 IFACEMETHODIMP_(void)
 FancyZones::VirtualDesktopChanged() noexcept
@@ -269,77 +533,197 @@ FancyZones::VirtualDesktopInitialize() noexcept
 IFACEMETHODIMP_(void)
 FancyZones::WindowCreated(HWND window) noexcept
 {
-    std::shared_lock readLock(m_lock);
     if (IsInterestingWindow(window, m_settings->GetSettings()->excludedAppsArray))
     {
-        PostMessageW(m_window, WM_PRIV_LOWLEVELKB, 0, 0);
+        // Apps often open several windows at once, retile once when they're all there
+        const auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(m_windowCreatedBurst.OnEvent());
+        SetTimer(m_window, WINDOW_CREATED_TIMER_ID, static_cast<UINT>(delay.count()), nullptr);
     }
 }
 
-// IFancyZonesCallback
-IFACEMETHODIMP_(bool)
-FancyZones::OnKeyDown(PKBDLLHOOKSTRUCT info) noexcept
+void FancyZones::OnWindowCreatedBurst() noexcept
 {
-    // Return true to swallow the keyboard event
-    bool const shift = GetAsyncKeyState(VK_SHIFT) & 0x8000;
-    bool const win = GetAsyncKeyState(VK_LWIN) & 0x8000 || GetAsyncKeyState(VK_RWIN) & 0x8000;
-    if (win && !shift)
+    if (!m_windowCreatedBurst.Flush())
     {
-        bool const ctrl = GetAsyncKeyState(VK_CONTROL) & 0x8000;
-        if (ctrl)
+        return;
+    }
+
+    QueueRelayout(Relayout::RequestKind::Snap, 0);
+
+    const auto& stats = m_windowCreatedBurst.GetStats();
+    const auto quietPeriod = std::chrono::duration_cast<std::chrono::milliseconds>(m_windowCreatedBurst.QuietPeriod());
+    Metrics::Set(Metrics::Counter::WindowCreatedEvents, stats.events);
+    Metrics::Set(Metrics::Counter::WindowCreatedBursts, stats.bursts);
+    Metrics::Set(Metrics::Counter::WindowCreatedFolded, stats.folded);
+    Metrics::Set(Metrics::Counter::WindowCreatedQuietPeriodMillis, static_cast<uint64_t>(quietPeriod.count()));
+}
+
+void FancyZones::ProcessHookEvents() noexcept
+{
+    const bool complete = m_hookEvents.Drain([this](const HookEvents::EventRecord<HWND>& record) {
+        if (record.event == EVENT_OBJECT_CREATE)
         {
-            if ((info->vkCode >= '1') && (info->vkCode <= '9'))
-            {
-                auto window = GetForegroundWindow();
-                VirtualDesktopUtils::MoveWindowToVirtualDesktop(window, info->vkCode - '1');
-                return true;
-            }
+            WindowCreated(record.window);
         }
-        else if ((info->vkCode == VK_LEFT) || (info->vkCode == VK_UP) || (info->vkCode == VK_DOWN))
+    });
+
+    const auto stats = m_hookEvents.GetStats();
+    Metrics::Set(Metrics::Counter::HookEventsReceived, stats.received);
+    Metrics::Set(Metrics::Counter::HookEventsCoalesced, stats.coalesced);
+    Metrics::Set(Metrics::Counter::HookEventsDropped, stats.dropped);
+    Metrics::Set(Metrics::Counter::HookQueueDepthMax, stats.maxDepth);
+
+    if (!complete)
+    {
+        // Queue overflowed and events were dropped, retile to pick up windows we missed
+        QueueRelayout(Relayout::RequestKind::Snap, 0);
+    }
+}
+
+namespace
+{
+    LatencyHistogram s_keyboardHookLatency;
+
+    struct KeyboardHookTimer
+    {
+        ~KeyboardHookTimer()
+        {
+            s_keyboardHookLatency.Record(std::chrono::steady_clock::now() - start);
+        }
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+
+    uint8_t GetAsyncModifierMask() noexcept
+    {
+        uint8_t mask = KeyboardHook::Modifier::None;
+        if (GetAsyncKeyState(VK_LWIN) & 0x8000 || GetAsyncKeyState(VK_RWIN) & 0x8000)
         {
-            // Win+Up, Win+Down will cycle through Zones in the active ZoneSet when WM_PRIV_LOWLEVELKB's handled
-            PostMessageW(m_window, WM_PRIV_LOWLEVELKB, 0, info->vkCode);
-            return true;
+            mask |= KeyboardHook::Modifier::Win;
         }
-        else if ((info->vkCode == VK_RIGHT))
+        if (GetAsyncKeyState(VK_SHIFT) & 0x8000)
         {
-            // Mute
-            return true;
+            mask |= KeyboardHook::Modifier::Shift;
         }
-        else if ((info->vkCode >= '1') && (info->vkCode <= '9'))
+        if (GetAsyncKeyState(VK_CONTROL) & 0x8000)
         {
-            VirtualDesktopUtils::SwitchToVirtualDesktop(info->vkCode - '1');
-            return true;
+            mask |= KeyboardHook::Modifier::Ctrl;
         }
-    }
-    else if (win && shift)
-    {
-        if ((info->vkCode == VK_LEFT) || (info->vkCode == VK_RIGHT))
+        if (GetAsyncKeyState(VK_MENU) & 0x8000)
         {
-            // Win+Up, Win+Down will cycle through Zones in the active ZoneSet when WM_PRIV_LOWLEVELKB's handled
-            PostMessageW(m_window, WM_PRIV_LOWLEVELKB, 1, info->vkCode);
-            return true;
+            mask |= KeyboardHook::Modifier::Alt;
         }
+        return mask;
     }
+}
 
-    return false;
+const LatencyHistogram& KeyboardHookLatency() noexcept
+{
+    return s_keyboardHookLatency;
+}
+
+// IFancyZonesCallback
+IFACEMETHODIMP_(bool)
+FancyZones::OnKeyDown(PKBDLLHOOKSTRUCT info) noexcept
+{
+    const auto inputAt = LatencyTrace::Now();
+    KeyboardHookTimer timer;
+
+    // Only what's needed to replay hotkeys is recorded, the trace mustn't capture typing
+    if (KeyboardHook::ModifierState::IsModifier(info->vkCode) || m_keyActions.Lookup(m_modifierState.Mask(), info->vkCode) != KeyboardHook::KeyAction::PassThrough)
+    {
+        m_eventTrace.Append(EventTrace::EventKind::KeyDown, 0, info->vkCode);
+    }
+    return HandleKeyDown(info->vkCode, inputAt);
+}
+
+// IFancyZonesCallback
+IFACEMETHODIMP_(void)
+FancyZones::OnKeyUp(PKBDLLHOOKSTRUCT info) noexcept
+{
+    KeyboardHookTimer timer;
+    if (m_modifierState.Update(info->vkCode, false))
+    {
+        m_eventTrace.Append(EventTrace::EventKind::KeyUp, 0, info->vkCode);
+    }
+}
+
+bool FancyZones::HandleKeyDown(DWORD vkCode, LatencyTrace::TimePoint inputAt) noexcept
+{
+    // Return true to swallow the keyboard event
+    if (m_modifierState.Update(vkCode, true))
+    {
+        return false;
+    }
+
+    auto action = m_keyActions.Lookup(m_modifierState.Mask(), vkCode);
+    if (action == KeyboardHook::KeyAction::PassThrough)
+    {
+        return false;
+    }
+
+    // Transitions can be missed (keys held while the hook was installed, secure desktop),
+    // confirm hits against the actual state. Misses, which are the common case, never get here.
+    const uint8_t actualModifiers = GetAsyncModifierMask();
+    if (actualModifiers != m_modifierState.Mask())
+    {
+        m_modifierState.Resync(actualModifiers);
+        action = m_keyActions.Lookup(actualModifiers, vkCode);
+    }
+
+    switch (action)
+    {
+    case KeyboardHook::KeyAction::Snap:
+        // Win+Up, Win+Down will cycle through Zones in the active ZoneSet when WM_PRIV_LOWLEVELKB's handled
+        QueueRelayout(Relayout::RequestKind::Snap, vkCode, inputAt);
+        LatencyTrace::Record(LatencyTrace::Stage::KeyboardHook, inputAt, LatencyTrace::Now());
+        return true;
+    case KeyboardHook::KeyAction::MainZoneWidth:
+        // Win+Shift+Left, Win+Shift+Right will change width of the main zone when WM_PRIV_LOWLEVELKB's handled
+        QueueRelayout(Relayout::RequestKind::MainZoneWidth, vkCode, inputAt);
+        LatencyTrace::Record(LatencyTrace::Stage::KeyboardHook, inputAt, LatencyTrace::Now());
+        return true;
+    case KeyboardHook::KeyAction::MoveToVirtualDesktop:
+        // Only queued here, Explorer may take a while to answer. Retile once the window left this desktop.
+        m_virtualDesktopDispatcher.MoveWindowTo(PlatformInstance().ForegroundWindow(), vkCode - '1', [this](bool moved) {
+            if (moved)
+            {
+                QueueRelayout(Relayout::RequestKind::Snap, 0);
+            }
+        });
+        return true;
+    case KeyboardHook::KeyAction::SwitchToVirtualDesktop:
+        // Switch is picked up through VirtualDesktopChanged once Explorer made it
+        m_virtualDesktopDispatcher.SwitchTo(vkCode - '1');
+        return true;
+    case KeyboardHook::KeyAction::Swallow:
+        // Mute
+        return true;
+    default:
+        return false;
+    }
 }
 
 // IFancyZonesCallback
 void FancyZones::ToggleEditor() noexcept
 {
+    HANDLE terminateEditorEvent{};
     {
-        std::shared_lock readLock(m_lock);
-        if (m_terminateEditorEvent)
-        {
-            SetEvent(m_terminateEditorEvent.get());
-            return;
-        }
+        auto readLock = LockForRead(LockSite::ToggleEditor);
+        terminateEditorEvent = m_terminateEditorEvent.get();
+    }
+
+    if (terminateEditorEvent)
+    {
+        SetEvent(terminateEditorEvent);
+        return;
     }
 
+    wil::unique_handle newTerminateEditorEvent(CreateEvent(nullptr, true, false, nullptr));
+    terminateEditorEvent = newTerminateEditorEvent.get();
     {
-        std::unique_lock writeLock(m_lock);
-        m_terminateEditorEvent.reset(CreateEvent(nullptr, true, false, nullptr));
+        auto writeLock = LockForWrite(LockSite::ToggleEditor);
+        m_terminateEditorEvent = std::move(newTerminateEditorEvent);
     }
 
     HMONITOR monitor{};
@@ -363,11 +747,15 @@ void FancyZones::ToggleEditor() noexcept
         return;
     }
 
-    std::shared_lock readLock(m_lock);
-    auto iter = m_zoneWindowMap.find(monitor);
-    if (iter == m_zoneWindowMap.end())
+    winrt::com_ptr<IZoneWindow> zoneWindow;
     {
-        return;
+        auto readLock = LockForRead(LockSite::ToggleEditor);
+        auto iter = m_zoneWindowMap.find(monitor);
+        if (iter == m_zoneWindowMap.end())
+        {
+            return;
+        }
+        zoneWindow = iter->second;
     }
 
     MONITORINFOEX mi;
@@ -378,8 +766,6 @@ void FancyZones::ToggleEditor() noexcept
                       } })
         .wait();
 
-    auto zoneWindow = iter->second;
-
     const auto& fancyZonesData = JSONHelpers::FancyZonesDataInstance();
     fancyZonesData.CustomZoneSetsToJsonFile(ZoneWindowUtils::GetCustomZoneSetsTmpPath());
 
@@ -423,7 +809,7 @@ void FancyZones::ToggleEditor() noexcept
     // Launch the editor on a background thread
     // Wait for the editor's process to exit
     // Post back to the main thread to update
-    std::thread waitForEditorThread([window = m_window, processHandle = sei.hProcess, terminateEditorEvent = m_terminateEditorEvent.get()]() {
+    std::thread waitForEditorThread([window = m_window, processHandle = sei.hProcess, terminateEditorEvent]() {
         HANDLE waitEvents[2] = { processHandle, terminateEditorEvent };
         auto result = WaitForMultipleObjects(2, waitEvents, false, INFINITE);
         if (result == WAIT_OBJECT_0 + 0)
@@ -447,7 +833,52 @@ void FancyZones::ToggleEditor() noexcept
 
 void FancyZones::SettingsChanged() noexcept
 {
-    std::shared_lock readLock(m_lock);
+    HWND window{};
+    {
+        auto readLock = LockForRead(LockSite::SettingsChanged);
+        window = m_window;
+    }
+
+    // Settings are applied on the window thread, which owns the event trace file
+    if (window)
+    {
+        PostMessage(window, WM_PRIV_SETTINGS, 0, 0);
+    }
+}
+
+void FancyZones::DumpLatencyTrace() const noexcept
+{
+#if defined(FANCYZONES_LATENCY_TRACING)
+    const std::wstring path = PTSettingsHelper::get_module_save_folder_location(L"FancyZones") + L"\\" + LATENCY_TRACE_FILE;
+    std::ofstream file(path, std::ios::trunc);
+    if (file)
+    {
+        LatencyTrace::Global().WriteJson(file);
+    }
+#endif
+}
+
+void FancyZones::UpdateEventTrace() noexcept
+{
+    const bool enabled = m_settings->GetSettings()->recordEventTrace;
+    if (enabled == m_eventTrace.IsRecording())
+    {
+        return;
+    }
+
+    if (enabled)
+    {
+        const std::wstring path = PTSettingsHelper::get_module_save_folder_location(L"FancyZones") + L"\\" + EVENT_TRACE_FILE;
+        if (m_eventTrace.Start(path))
+        {
+            SetTimer(m_window, EVENT_TRACE_TIMER_ID, EVENT_TRACE_FLUSH_INTERVAL_MS, nullptr);
+        }
+    }
+    else
+    {
+        KillTimer(m_window, EVENT_TRACE_TIMER_ID);
+        m_eventTrace.Stop();
+    }
 }
 
 // IZoneWindowHost
@@ -477,47 +908,77 @@ LRESULT FancyZones::WndProc(HWND window, UINT message, WPARAM wparam, LPARAM lpa
     {
         if (wparam == SPI_SETWORKAREA)
         {
+            m_eventTrace.Append(EventTrace::EventKind::WorkAreaChange);
             OnDisplayChange(DisplayChangeType::WorkArea);
         }
+        else if (wparam == SPI_SETLOGICALDPIOVERRIDE)
+        {
+            // Scale changed without a display mode change, there's no WM_DISPLAYCHANGE for it
+            m_eventTrace.Append(EventTrace::EventKind::DisplayChange);
+            OnDisplayChange(DisplayChangeType::DisplayChange);
+        }
     }
     break;
 
     case WM_DISPLAYCHANGE:
     {
+        m_eventTrace.Append(EventTrace::EventKind::DisplayChange);
         OnDisplayChange(DisplayChangeType::DisplayChange);
     }
     break;
 
-    default:
+    case WM_TIMER:
     {
-        POINT ptScreen;
-        GetPhysicalCursorPos(&ptScreen);
+        if (wparam == WINDOW_CREATED_TIMER_ID)
+        {
+            KillTimer(window, WINDOW_CREATED_TIMER_ID);
+            OnWindowCreatedBurst();
+        }
+        else if (wparam == EVENT_TRACE_TIMER_ID)
+        {
+            m_eventTrace.Flush();
+        }
+    }
+    break;
 
+    default:
+    {
         if (message == WM_PRIV_LOWLEVELKB)
         {
-            if (wparam == 0)
-                OnSnapHotkey(static_cast<DWORD>(lparam));
-            else
-                OnWidthChangeHotkey(static_cast<DWORD>(lparam));
+            ProcessRelayoutRequests();
+        }
+        else if (message == WM_PRIV_LAYOUT)
+        {
+            CommitLayout();
         }
         else if (message == WM_PRIV_VD_INIT)
         {
-            OnDisplayChange(DisplayChangeType::Initialization);
+            {
+                Startup::PhaseTimer timer(Startup::Phase::ZoneWindows);
+                OnDisplayChange(DisplayChangeType::Initialization);
+            }
+            Metrics::Set(Metrics::Counter::StartupMicros, Startup::s_timeline.Elapsed().count());
+            PublishStats();
+            PublishDataFootprint();
         }
         else if (message == WM_PRIV_VD_SWITCH)
         {
+            m_eventTrace.Append(EventTrace::EventKind::DesktopSwitch);
             OnDisplayChange(DisplayChangeType::VirtualDesktop);
         }
         else if (message == WM_PRIV_VD_UPDATE)
         {
+            m_eventTrace.Append(EventTrace::EventKind::DesktopUpdate);
+            VirtualDesktopUtils::InvalidateVirtualDesktops();
             std::vector<GUID> ids{};
-            if (VirtualDesktopUtils::GetVirtualDesktopIds(ids))
+            if (PlatformInstance().GetDesktops(ids))
             {
                 RegisterVirtualDesktopUpdates(ids);
             }
         }
         else if (message == WM_PRIV_EDITOR)
         {
+            m_eventTrace.Append(EventTrace::EventKind::EditorExit, 0, static_cast<uint32_t>(lparam));
             if (lparam == static_cast<LPARAM>(EditorExitKind::Exit))
             {
                 OnEditorExitEvent();
@@ -525,14 +986,28 @@ LRESULT FancyZones::WndProc(HWND window, UINT message, WPARAM wparam, LPARAM lpa
 
             {
                 // Clean up the event either way
-                std::unique_lock writeLock(m_lock);
+                auto writeLock = LockForWrite(LockSite::EditorExit);
                 m_terminateEditorEvent.release();
             }
         }
         else if (message == WM_PRIV_WINDOWCREATED)
         {
-            auto hwnd = reinterpret_cast<HWND>(wparam);
-            WindowCreated(hwnd);
+            ProcessHookEvents();
+        }
+        else if (message == WM_PRIV_SETTINGS)
+        {
+            UpdateEventTrace();
+            JSONHelpers::FancyZonesDataInstance().SetAppZoneHistoryCapacity(m_settings->GetSettings()->appZoneHistoryCapacity);
+        }
+        else if (message == WM_PRIV_DUMP_LATENCY)
+        {
+            DumpLatencyTrace();
+            PublishStats();
+            PublishDataFootprint();
+        }
+        else if (message == WM_PRIV_DUMP_FLIGHT_RECORDER)
+        {
+            WriteFlightRecorder(s_flightRecorderPath);
         }
         else
         {
@@ -547,26 +1022,51 @@ LRESULT FancyZones::WndProc(HWND window, UINT message, WPARAM wparam, LPARAM lpa
 
 void FancyZones::OnDisplayChange(DisplayChangeType changeType) noexcept
 {
+    if (changeType != DisplayChangeType::VirtualDesktop)
+    {
+        MonitorTopologyInstance().Rebuild(PlatformInstance());
+    }
+
     if (changeType == DisplayChangeType::VirtualDesktop ||
         changeType == DisplayChangeType::Initialization)
     {
         GUID currentVirtualDesktopId{};
-        if (VirtualDesktopUtils::GetCurrentVirtualDesktopId(&currentVirtualDesktopId))
+        if (PlatformInstance().GetCurrentDesktop(currentVirtualDesktopId))
         {
             m_currentVirtualDesktopId = currentVirtualDesktopId;
         }
         if (changeType == DisplayChangeType::Initialization)
         {
-            std::vector<std::wstring> ids{};
-            if (VirtualDesktopUtils::GetVirtualDesktopIds(ids) && !ids.empty())
+            std::vector<GUID> ids{};
+            if (PlatformInstance().GetDesktops(ids) && !ids.empty())
             {
-                JSONHelpers::FancyZonesDataInstance().UpdatePrimaryDesktopData(ids[0]);
-                JSONHelpers::FancyZonesDataInstance().RemoveDeletedDesktops(ids);
+                // Desktops may have been deleted while we weren't running, persisted data is scanned
+                // for them once here. Later changes are applied incrementally.
+                std::vector<std::wstring> desktopIds;
+                for (const auto& id : ids)
+                {
+                    wil::unique_cotaskmem_string desktopId;
+                    if (SUCCEEDED(StringFromCLSID(id, &desktopId)))
+                    {
+                        desktopIds.push_back(desktopId.get());
+                    }
+                }
+
+                auto& fancyZonesData = JSONHelpers::FancyZonesDataInstance();
+                bool modified = !desktopIds.empty() && fancyZonesData.UpdatePrimaryDesktopData(desktopIds[0]);
+                modified |= !desktopIds.empty() && fancyZonesData.RemoveDeletedDesktops(desktopIds);
+                if (modified)
+                {
+                    fancyZonesData.SaveFancyZonesData();
+                }
+
+                RegisterVirtualDesktopUpdates(ids);
             }
         }
     }
 
     UpdateZoneWindows();
+    UpdateZoneNeighbors();
 
     if ((changeType == DisplayChangeType::WorkArea) || (changeType == DisplayChangeType::DisplayChange))
     {
@@ -579,24 +1079,36 @@ void FancyZones::OnDisplayChange(DisplayChangeType changeType) noexcept
 
 void FancyZones::AddZoneWindow(HMONITOR monitor, PCWSTR deviceId) noexcept
 {
-    std::unique_lock writeLock(m_lock);
     wil::unique_cotaskmem_string virtualDesktopId;
     if (SUCCEEDED_LOG(StringFromCLSID(m_currentVirtualDesktopId, &virtualDesktopId)))
     {
         std::wstring uniqueId = ZoneWindowUtils::GenerateUniqueId(monitor, deviceId, virtualDesktopId.get());
         JSONHelpers::FancyZonesDataInstance().SetActiveDeviceId(uniqueId);
 
-        const bool newWorkArea = IsNewWorkArea(m_currentVirtualDesktopId, monitor);
+        bool newWorkArea{};
+        {
+            auto readLock = LockForRead(LockSite::AddZoneWindow);
+            newWorkArea = IsNewWorkArea(m_currentVirtualDesktopId, monitor);
+        }
 
+        // Creates a window and calls back into GetParentZoneWindow, so it's made before taking the write lock
         auto zoneWindow = MakeZoneWindow(this, m_hinstance, monitor, uniqueId, false, newWorkArea);
-        if (zoneWindow)
         {
-            m_zoneWindowMap[monitor] = std::move(zoneWindow);
+            auto writeLock = LockForWrite(LockSite::AddZoneWindow);
+            if (zoneWindow)
+            {
+                m_zoneWindowMap[monitor] = std::move(zoneWindow);
+                m_zoneWindowMapVersion++;
+            }
+
+            if (newWorkArea)
+            {
+                RegisterNewWorkArea(m_currentVirtualDesktopId, monitor);
+            }
         }
 
         if (newWorkArea)
         {
-            RegisterNewWorkArea(m_currentVirtualDesktopId, monitor);
             JSONHelpers::FancyZonesDataInstance().SaveFancyZonesData();
         }
     }
@@ -618,48 +1130,19 @@ LRESULT CALLBACK FancyZones::s_WndProc(HWND window, UINT message, WPARAM wparam,
 
 void FancyZones::UpdateZoneWindows() noexcept
 {
-    auto callback = [](HMONITOR monitor, HDC, RECT*, LPARAM data) -> BOOL {
-        MONITORINFOEX mi;
-        mi.cbSize = sizeof(mi);
-        if (GetMonitorInfo(monitor, &mi))
+    const auto topology = MonitorTopologyInstance().Current(PlatformInstance());
+    for (const auto& monitor : topology->monitors)
+    {
+        if (monitor.zonable)
         {
-            DISPLAY_DEVICE displayDevice = { sizeof(displayDevice) };
-            PCWSTR deviceId = nullptr;
-
-            bool validMonitor = true;
-            if (EnumDisplayDevices(mi.szDevice, 0, &displayDevice, 1))
-            {
-                if (WI_IsFlagSet(displayDevice.StateFlags, DISPLAY_DEVICE_MIRRORING_DRIVER))
-                {
-                    validMonitor = FALSE;
-                }
-                else if (displayDevice.DeviceID[0] != L'\0')
-                {
-                    deviceId = displayDevice.DeviceID;
-                }
-            }
-
-            if (validMonitor)
-            {
-                if (!deviceId)
-                {
-                    deviceId = GetSystemMetrics(SM_REMOTESESSION) ?
-                                   L"\\\\?\\DISPLAY#REMOTEDISPLAY#" :
-                                   L"\\\\?\\DISPLAY#LOCALDISPLAY#";
-                }
-
-                auto strongThis = reinterpret_cast<FancyZones*>(data);
-                strongThis->AddZoneWindow(monitor, deviceId);
-            }
+            AddZoneWindow(monitor.handle, monitor.deviceId.c_str());
         }
-        return TRUE;
-    };
-
-    EnumDisplayMonitors(nullptr, nullptr, callback, reinterpret_cast<LPARAM>(this));
+    }
 }
 
 void FancyZones::UpdateWindowsPositions() noexcept
 {
+    using ZonedWindows = std::vector<std::pair<HWND, std::vector<int>>>;
     auto callback = [](HWND window, LPARAM data) -> BOOL {
         size_t bitmask = reinterpret_cast<size_t>(::GetProp(window, MULTI_ZONE_STAMP));
 
@@ -674,245 +1157,381 @@ void FancyZones::UpdateWindowsPositions() noexcept
                 }
             }
 
-            auto strongThis = reinterpret_cast<FancyZones*>(data);
-            std::unique_lock writeLock(strongThis->m_lock);
-            strongThis->m_windowMoveHandler.MoveWindowIntoZoneByIndexSet(window, nullptr, indexSet, strongThis->m_zoneWindowMap);
+            reinterpret_cast<ZonedWindows*>(data)->emplace_back(window, std::move(indexSet));
         }
         return TRUE;
     };
-    EnumWindows(callback, reinterpret_cast<LPARAM>(this));
-}
 
-void FancyZones::SettleWindowsPositions() noexcept
-{
-    int numHwnds = static_cast<int>(m_currentHwndList.size());
+    ZonedWindows zonedWindows;
+    EnumWindows(callback, reinterpret_cast<LPARAM>(&zonedWindows));
+
+    std::map<HMONITOR, winrt::com_ptr<IZoneWindow>> zoneWindowMap;
+    {
+        auto readLock = LockForRead(LockSite::UpdateWindowsPositions);
+        zoneWindowMap = m_zoneWindowMap;
+    }
 
-    std::unique_lock writeLock(m_lock);
-    for (int i = 0; i < numHwnds; i++)
+    PlacementTracker::OperationScope placementScope(PlacementOperation::UpdatePositions);
+    WindowAnimator::Batch animationBatch(m_windowAnimator, m_settings->GetSettings()->animateWindowMoves);
+    for (const auto& [window, indexSet] : zonedWindows)
     {
-        m_windowMoveHandler.MoveWindowIntoZoneByIndexSet(m_currentHwndList[i], NULL, { i }, m_zoneWindowMap);
+        m_windowMoveHandler.MoveWindowIntoZoneByIndexSet(window, nullptr, indexSet, zoneWindowMap);
     }
 }
 
-std::vector<HWND> FancyZones::GetWindowList(void) noexcept
+void FancyZones::GetWindowList(std::vector<HWND>& windows) noexcept
 {
-    std::vector<HWND> out;
     static auto excludedApp = m_settings->GetSettings()->excludedAppsArray;
-    static IVirtualDesktopManager* virtualDesktopManager = VirtualDesktopUtils::GetVirtualDesktopManager();
-    VirtualDesktopUtils::IApplicationViewCollection* applications = VirtualDesktopUtils::GetApplicationViewCollection();
-    
-    for (HWND hwnd = GetTopWindow(NULL); hwnd != NULL; hwnd = GetNextWindow(hwnd, GW_HWNDNEXT))
+
+    auto& platform = PlatformInstance();
+    platform.TopLevelWindows(m_topLevelWindows);
+    for (HWND hwnd : m_topLevelWindows)
     {
         if (!IsInterestingWindow(hwnd, excludedApp))
             continue;
 
-        VirtualDesktopUtils::IApplicationView* view = nullptr;
-        applications->GetViewForHwnd(hwnd, &view);
-        if (view == nullptr)
+        if (!platform.IsOnCurrentDesktop(hwnd))
             continue;
 
-        BOOL isVisible = FALSE;
-        view->GetVisibility(&isVisible);
-        if (!isVisible)
-            continue;
+        windows.push_back(hwnd);
+    }
+}
+
+void FancyZones::QueueRelayout(Relayout::RequestKind kind, DWORD vkCode, LatencyTrace::TimePoint inputAt) noexcept
+{
+    Metrics::Add(Metrics::Counter::RelayoutRequests);
 
-        out.push_back(hwnd);
+    // Only the first pending request wakes up the message loop, following ones are merged into it.
+    // If the wake-up can't be posted the requests stay queued and the next one tries again.
+    if (m_relayoutRequests.Submit(kind, vkCode, inputAt) && !Wake(WM_PRIV_LOWLEVELKB))
+    {
+        m_relayoutRequests.CancelWake();
     }
-    return out;
 }
 
-int nextIndex(DWORD vkCode, int oldIndex, int numZones) noexcept
+bool FancyZones::Wake(UINT message) const noexcept
+{
+    // PostMessage with no window would post to the calling thread, where nobody handles it
+    const HWND window = m_wakeWindow.load(std::memory_order_acquire);
+    return window && PostMessageW(window, message, 0, 0);
+}
+
+namespace
 {
-    if ((vkCode == VK_UP && oldIndex == 0) || (vkCode == VK_DOWN && oldIndex == numZones - 1))
+    Allocations::Action AllocationAction(const Relayout::Request& request) noexcept
     {
-        return vkCode == VK_UP ? numZones - 1 : 0;
+        if (request.kind == Relayout::RequestKind::MainZoneWidth)
+        {
+            return Allocations::Action::MainZoneWidth;
+        }
+        return request.vkCode == VK_LEFT ? Allocations::Action::Settle : Allocations::Action::Cycle;
     }
 
-    // We didn't reach the edge
-    if (vkCode == VK_UP)
+    Allocations::Action AllocationAction(PlacementOperation operation) noexcept
     {
-        return oldIndex - 1;
+        switch (operation)
+        {
+        case PlacementOperation::WidthChange:
+            return Allocations::Action::MainZoneWidth;
+        case PlacementOperation::Settle:
+            return Allocations::Action::Settle;
+        default:
+            return Allocations::Action::Cycle;
+        }
     }
 
-    return oldIndex + 1;
+    // Inputs and outcome of a computed layout, moves are recorded as they're issued.
+    void RecordLayoutDecision(const Layout::Snapshot& snapshot, const Layout::Result& result) noexcept
+    {
+        using FlightRecorder::Event;
+        FlightRecorder::Log(Event::LayoutDecision, result.generation, result.operation, result.monitor, snapshot.windows.size(), result.zones.size(), result.mainZoneWidth);
+        for (size_t i = 0; i < snapshot.windows.size(); i++)
+        {
+            FlightRecorder::Log(Event::LayoutWindow, result.generation, i, snapshot.windows[i], i < snapshot.zoneIndices.size() ? snapshot.zoneIndices[i] : -1);
+        }
+        for (size_t i = 0; i < result.zones.size(); i++)
+        {
+            const RECT& zone = result.zones[i];
+            FlightRecorder::Log(Event::LayoutZone, result.generation, i, zone.left, zone.top, zone.right, zone.bottom);
+        }
+    }
 }
 
-bool FancyZones::CycleWindows(DWORD vkCode, HMONITOR monitor, MONITORINFO mi)
+void FancyZones::ProcessRelayoutRequests() noexcept
 {
-    auto zoneWindow = m_zoneWindowMap[monitor];
-    const auto activeZoneSet = zoneWindow->ActiveZoneSet();
-    int numZones = static_cast<int>(activeZoneSet->GetZones().size());
+    const auto takenAt = LatencyTrace::Now();
+    auto& requests = m_snapshot.requests;
+    m_relayoutRequests.TakeAll(requests);
+    if (requests.empty())
+    {
+        return;
+    }
+
+    Metrics::Add(Metrics::Counter::Relayouts);
+    Metrics::Max(Metrics::Counter::RelayoutQueueDepthMax, requests.size());
+    Metrics::Set(Metrics::Counter::RelayoutRequestsDropped, m_relayoutRequests.Dropped());
 
-    std::vector<HWND> hwndList = GetWindowList();
-    int numHwnds = static_cast<int>(hwndList.size());
+    const auto action = AllocationAction(requests.back());
+    Allocations::CountAction(action);
+    Allocations::Scope allocationScope(action);
 
-    if (numHwnds != numZones)
+    // Requests are in submission order, the first one has waited the longest
+    LatencyTrace::Record(LatencyTrace::Stage::QueueWait, requests.front().queuedAt, takenAt);
+    if (!m_relayoutInputAt)
     {
-        activeZoneSet->KillZones();
-        activeZoneSet->CalculateZones(mi, numHwnds, 0);
-        numZones = numHwnds;
+        m_relayoutInputAt = requests.front().inputAt;
     }
-    else if (vkCode == 0)
+
+    if (!TakeLayoutSnapshot(m_snapshot))
     {
-        SettleWindowsPositions();
-        return true;
+        // Nothing to lay out for them, they still superseded whatever is in flight
+        Metrics::Add(Metrics::Counter::RelayoutRequestsDiscarded, requests.size());
+        m_relayoutInputAt.reset();
+        return;
     }
+    m_snapshot.submittedAt = LatencyTrace::Now();
+    LatencyTrace::Record(LatencyTrace::Stage::Snapshot, takenAt, m_snapshot.submittedAt);
 
-    m_currentHwndList = std::vector<HWND>(numZones, 0);
-
-    std::unique_lock writeLock(m_lock);
-    for (auto hwnd : hwndList)
+    // Older requests only advance the layout model, windows are placed for the newest one
     {
-        auto indexSet = activeZoneSet->GetZoneIndexSetFromWindow(hwnd);
-        int index = 0;
-        if (indexSet.size() != 0)
+        std::scoped_lock lock{ m_layoutLock };
+        if (m_snapshotPending)
         {
-            index = indexSet[0];
-            index = nextIndex(vkCode, index, numZones);
+            // The worker hasn't picked up the previous snapshot, the newer one replaces it but its requests still go first
+            requests.insert(requests.begin(), m_pendingSnapshot.requests.begin(), m_pendingSnapshot.requests.end());
         }
+        std::swap(m_snapshot, m_pendingSnapshot);
+        m_snapshotPending = true;
+    }
+    m_layoutWake.notify_one();
+}
 
-        while (m_currentHwndList[index] != 0)
-        {
-            index = nextIndex(vkCode, index, numZones);
-        }
-        m_currentHwndList[index] = hwnd;
-        m_windowMoveHandler.MoveWindowIntoZoneByIndexSet(hwnd, monitor, { index }, m_zoneWindowMap);
+bool FancyZones::TakeLayoutSnapshot(Layout::Snapshot& snapshot) noexcept
+{
+    auto& platform = PlatformInstance();
+    auto window = platform.ForegroundWindow();
+    if (!IsInterestingWindow(window, m_settings->GetSettings()->excludedAppsArray))
+    {
+        return false;
+    }
+
+    const HMONITOR monitor = platform.MonitorOfWindow(window);
+    const auto topology = MonitorTopologyInstance().Current(platform);
+    const auto info = topology->Find(monitor);
+    if (!info)
+    {
+        return false;
+    }
+
+    const auto& requests = snapshot.requests;
+    const bool snap = std::any_of(requests.begin(), requests.end(), [](const Relayout::Request& request) {
+        return request.kind == Relayout::RequestKind::Snap;
+    });
+
+    snapshot.generation = requests.back().generation;
+    snapshot.takenAt = std::chrono::steady_clock::now();
+    snapshot.monitor = monitor;
+    snapshot.workArea = info->workArea;
+    snapshot.foregroundWindow = window;
+    snapshot.cycleAcrossMonitors = topology->monitors.size() > 1 && m_settings->GetSettings()->moveWindowAcrossMonitors;
+    snapshot.windows.clear();
+    snapshot.zoneIndices.clear();
+
+    if (snap)
+    {
+        GetWindowList(snapshot.windows);
+        PlacementTrackerInstance().Prune();
     }
 
-    SetForegroundWindow(m_currentHwndList[0]);
+    auto readLock = LockForRead(LockSite::LayoutSnapshot);
+    auto zoneWindow = m_zoneWindowMap.find(monitor);
+    IZoneSet* activeZoneSet = zoneWindow != m_zoneWindowMap.end() ? zoneWindow->second->ActiveZoneSet() : nullptr;
+    if (!activeZoneSet)
+    {
+        return false;
+    }
 
+    snapshot.zoneCount = static_cast<int>(activeZoneSet->ZoneCount());
+    snapshot.mainZoneWidth = activeZoneSet->MainZoneWidth();
+    for (HWND hwnd : snapshot.windows)
+    {
+        snapshot.zoneIndices.push_back(activeZoneSet->GetZoneIndexFromWindow(hwnd));
+    }
     return true;
 }
 
-bool FancyZones::OnSnapHotkey(DWORD vkCode) noexcept
+void FancyZones::RunLayoutWorker() noexcept
 {
-    auto window = GetForegroundWindow();
-    if (IsInterestingWindow(window, m_settings->GetSettings()->excludedAppsArray))
+    // Swapped with the shared ones, so each buffer is reused by whichever side holds it
+    Layout::Snapshot snapshot;
+    Layout::Result result;
+
+    std::unique_lock lock{ m_layoutLock };
+    for (;;)
     {
-        const HMONITOR current = MonitorFromWindow(window, MONITOR_DEFAULTTONULL);
-        if (current)
+        m_layoutWake.wait(lock, [this] { return m_snapshotPending || m_stopLayoutWorker; });
+        if (m_stopLayoutWorker)
         {
-            std::vector<HMONITOR> monitorInfo = GetMonitorsSorted();
-            MONITORINFO mi;
-            mi.cbSize = sizeof(mi);
-            if (monitorInfo.size() > 1 && m_settings->GetSettings()->moveWindowAcrossMonitors)
-            {
-                // Multi monitor environment.
-                auto currMonitorInfo = std::find(std::begin(monitorInfo), std::end(monitorInfo), current);
-                do
-                {
-                    GetMonitorInfo(current, &mi);
-                    std::unique_lock writeLock(m_lock);
-                    if (CycleWindows(vkCode, current, mi))
-                    {
-                        return true;
-                    }
-                    // We iterated through all zones in current monitor zone layout, move on to next one (or previous depending on direction).
-                    if (vkCode == VK_DOWN)
-                    {
-                        currMonitorInfo = std::next(currMonitorInfo);
-                        if (currMonitorInfo == std::end(monitorInfo))
-                        {
-                            currMonitorInfo = std::begin(monitorInfo);
-                        }
-                    }
-                    else if (vkCode == VK_UP)
-                    {
-                        if (currMonitorInfo == std::begin(monitorInfo))
-                        {
-                            currMonitorInfo = std::end(monitorInfo);
-                        }
-                        currMonitorInfo = std::prev(currMonitorInfo);
-                    }
-                } while (*currMonitorInfo != current);
-            }
-            else
-            {
-                 // Single monitor environment.
-                GetMonitorInfo(current, &mi);
-                if (vkCode == VK_LEFT)
-                {
-                     HWND curr = GetForegroundWindow();
-                     auto& it = std::find(m_currentHwndList.begin(), m_currentHwndList.end(), curr);
-                     if (it != m_currentHwndList.end())
-                     {
-                         HWND begin = m_currentHwndList[0];
-                         m_currentHwndList[0] = *it;
-                         *it = begin;
-                     }
-                     SettleWindowsPositions();
-                }
-                else
-                {
-                    CycleWindows(vkCode, current, mi);
-                }
-            }
+            return;
         }
+        std::swap(snapshot, m_pendingSnapshot);
+        m_snapshotPending = false;
+        lock.unlock();
+
+        {
+            Allocations::Scope allocationScope(AllocationAction(snapshot.requests.back()));
+            const auto computeAt = LatencyTrace::Now();
+            LatencyTrace::Record(LatencyTrace::Stage::LayoutWait, snapshot.submittedAt, computeAt);
+            m_layoutModel.Compute(snapshot, result);
+            result.computedAt = LatencyTrace::Now();
+            LatencyTrace::Record(LatencyTrace::Stage::Compute, computeAt, result.computedAt);
+            RecordLayoutDecision(snapshot, result);
+        }
+
+        lock.lock();
+        std::swap(result, m_layoutResult);
+        m_resultPending = true;
+        lock.unlock();
+        Wake(WM_PRIV_LAYOUT);
+        lock.lock();
     }
-    return false;
 }
 
-bool FancyZones::OnWidthChangeHotkey(DWORD vkCode) noexcept
+void FancyZones::StopLayoutWorker() noexcept
 {
-    auto window = GetForegroundWindow();
-    if (IsInterestingWindow(window, m_settings->GetSettings()->excludedAppsArray))
     {
-        const HMONITOR current = MonitorFromWindow(window, MONITOR_DEFAULTTONULL);
-        MONITORINFO mi;
-        mi.cbSize = sizeof(mi);
-        GetMonitorInfo(current, &mi);
-        auto zoneWindow = m_zoneWindowMap[current];
-        const auto activeZoneSet = zoneWindow->ActiveZoneSet();
+        std::scoped_lock lock{ m_layoutLock };
+        m_stopLayoutWorker = true;
+    }
+    m_layoutWake.notify_one();
+}
 
-        int numHwnds = static_cast<int>(m_currentHwndList.size());
+void FancyZones::CommitLayout() noexcept
+{
+    {
+        std::scoped_lock lock{ m_layoutLock };
+        if (!m_resultPending)
+        {
+            return;
+        }
+        std::swap(m_commitResult, m_layoutResult);
+        m_resultPending = false;
+    }
 
-        activeZoneSet->ChangeMainZoneWidth(vkCode == VK_RIGHT);
-        activeZoneSet->KillZones();
-        activeZoneSet->CalculateZones(mi, numHwnds, 0);
+    // Superseded layouts are dropped, the model carries their effect into the newer one. Checked
+    // once, a layout that starts committing places all of its windows.
+    const auto& result = m_commitResult;
+    if (m_relayoutRequests.IsSuperseded(result.generation))
+    {
+        Metrics::Add(Metrics::Counter::RelayoutsSuperseded);
+        FlightRecorder::Log(FlightRecorder::Event::LayoutSuperseded, result.generation, 0);
+        return;
+    }
+    LatencyTrace::Record(LatencyTrace::Stage::CommitWait, result.computedAt, LatencyTrace::Now());
+    Allocations::Scope allocationScope(AllocationAction(result.operation));
 
-        std::unique_lock writeLock(m_lock);
-        for (int i = 0; i < numHwnds; i++)
+    const auto& zoneWindowMap = PlacementZoneWindows();
+    if (result.zonesChanged)
+    {
+        auto zoneWindow = zoneWindowMap.find(result.monitor);
+        if (zoneWindow != zoneWindowMap.end() && zoneWindow->second->ActiveZoneSet())
         {
-            m_windowMoveHandler.MoveWindowIntoZoneByIndexSet(m_currentHwndList[i], current, { i }, m_zoneWindowMap);
+            zoneWindow->second->ActiveZoneSet()->ReplaceZones(result.zones, result.mainZoneWidth);
+            UpdateZoneNeighbors(result.monitor, zoneWindow->second.get());
         }
-        return true;
     }
 
-    return false;
+    PlacementTracker::OperationScope placementScope(result.operation);
+    WindowAnimator::Batch animationBatch(m_windowAnimator, m_settings->GetSettings()->animateWindowMoves);
+    const HMONITOR monitor = result.placeOnWindowMonitor ? nullptr : result.monitor;
+    // A move across monitors leaves the other windows where they are, unless the zones changed
+    const int placements = result.moveSteps == 0 || result.zonesChanged ? static_cast<int>(result.order.size()) : 0;
+    for (int i = 0; i < placements; i++)
+    {
+        const auto placementAt = LatencyTrace::Now();
+        FlightRecorder::Log(FlightRecorder::Event::LayoutMove, result.generation, result.order[i], i);
+        m_placementIndexSet.assign(1, i);
+        m_windowMoveHandler.MoveWindowIntoZoneByIndexSet(result.order[i], monitor, m_placementIndexSet, zoneWindowMap);
+        LatencyTrace::Record(LatencyTrace::Stage::Placement, placementAt, LatencyTrace::Now());
+    }
+
+    if (result.moveSteps > 0)
+    {
+        // Zone on the left on whichever monitor it is, one lookup per step in the neighbor index
+        const auto placementAt = LatencyTrace::Now();
+        const HMONITOR windowMonitor = PlatformInstance().MonitorOfWindow(result.movedWindow);
+        m_windowMoveHandler.MoveWindowIntoZoneByDirection(windowMonitor, result.movedWindow, VK_LEFT, result.moveSteps, m_zoneNeighbors, zoneWindowMap);
+        LatencyTrace::Record(LatencyTrace::Stage::Placement, placementAt, LatencyTrace::Now());
+    }
+
+    if (result.activateFirst && !result.order.empty())
+    {
+        SetForegroundWindow(result.order[0]);
+    }
+
+    if (m_relayoutInputAt)
+    {
+        LatencyTrace::Record(LatencyTrace::Stage::EndToEnd, *m_relayoutInputAt, LatencyTrace::Now());
+        m_relayoutInputAt.reset();
+    }
+
+    // Tunes how long bursts of created windows are held back
+    m_windowCreatedBurst.RecordLatency(std::chrono::steady_clock::now() - result.snapshotTakenAt);
+    PublishStats();
+}
+
+// Zone windows to place windows in, copied again only when the zone window map changed.
+const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& FancyZones::PlacementZoneWindows() noexcept
+{
+    auto readLock = LockForRead(LockSite::CommitLayout);
+    if (m_placementZoneWindowsVersion != m_zoneWindowMapVersion)
+    {
+        m_placementZoneWindows = m_zoneWindowMap;
+        m_placementZoneWindowsVersion = m_zoneWindowMapVersion;
+        Metrics::Add(Metrics::Counter::ZoneWindowMapMisses);
+    }
+    else
+    {
+        Metrics::Add(Metrics::Counter::ZoneWindowMapHits);
+    }
+    return m_placementZoneWindows;
 }
 
 void FancyZones::RegisterVirtualDesktopUpdates(std::vector<GUID>& ids) noexcept
 {
-    std::unordered_set<GUID> activeVirtualDesktops(std::begin(ids), std::end(ids));
-    std::unique_lock writeLock(m_lock);
-    bool modified{ false };
-    for (auto it = std::begin(m_processedWorkAreas); it != std::end(m_processedWorkAreas);)
+    const auto delta = m_desktopTopology.Update(ids);
+    if (delta.empty())
     {
-        auto iter = activeVirtualDesktops.find(it->first);
-        if (iter == activeVirtualDesktops.end())
+        // Registry key also changes on every desktop switch
+        return;
+    }
+
+    {
+        auto writeLock = LockForWrite(LockSite::VirtualDesktopUpdates);
+        for (const auto& id : delta.removed)
         {
-            // if we couldn't find the GUID in currentVirtualDesktopIds, we must remove it from both m_processedWorkAreas and deviceInfoMap
-            wil::unique_cotaskmem_string virtualDesktopId;
-            if (SUCCEEDED_LOG(StringFromCLSID(it->first, &virtualDesktopId)))
-            {
-                modified |= JSONHelpers::FancyZonesDataInstance().RemoveDevicesByVirtualDesktopId(virtualDesktopId.get());
-            }
-            it = m_processedWorkAreas.erase(it);
+            m_processedWorkAreas.erase(id);
         }
-        else
+        // register new virtual desktops
+        for (const auto& id : delta.added)
         {
-            activeVirtualDesktops.erase(it->first); // virtual desktop already in map, skip it
-            ++it;
+            m_processedWorkAreas.try_emplace(id);
         }
     }
-    if (modified)
+
+    // deleted virtual desktops must be removed from deviceInfoMap as well
+    std::vector<std::wstring> deletedDesktopIds;
+    for (const auto& id : delta.removed)
     {
-        JSONHelpers::FancyZonesDataInstance().SaveFancyZonesData();
+        wil::unique_cotaskmem_string virtualDesktopId;
+        if (SUCCEEDED_LOG(StringFromCLSID(id, &virtualDesktopId)))
+        {
+            deletedDesktopIds.push_back(virtualDesktopId.get());
+        }
     }
-    // register new virtual desktops, if any
-    for (const auto& id : activeVirtualDesktops)
+    if (JSONHelpers::FancyZonesDataInstance().RemoveDevicesByVirtualDesktopIds(deletedDesktopIds))
     {
-        m_processedWorkAreas[id] = std::vector<HMONITOR>();
+        JSONHelpers::FancyZonesDataInstance().SaveFancyZonesData();
     }
 }
 
@@ -947,9 +1566,15 @@ void FancyZones::OnEditorExitEvent() noexcept
     JSONHelpers::FancyZonesDataInstance().ParseCustomZoneSetFromTmpFile(ZoneWindowUtils::GetAppliedZoneSetTmpPath());
     JSONHelpers::FancyZonesDataInstance().SaveFancyZonesData();
     // Update zone sets for currently active work areas.
-    for (auto& [monitor, zoneWindow] : m_zoneWindowMap)
+    std::map<HMONITOR, winrt::com_ptr<IZoneWindow>> zoneWindowMap;
+    {
+        auto readLock = LockForRead(LockSite::EditorExit);
+        zoneWindowMap = m_zoneWindowMap;
+    }
+    for (auto& [monitor, zoneWindow] : zoneWindowMap)
     {
         zoneWindow->UpdateActiveZoneSet();
+        UpdateZoneNeighbors(monitor, zoneWindow.get());
     }
     if (m_settings->GetSettings()->zoneSetChange_moveWindows)
     {
@@ -961,7 +1586,8 @@ bool FancyZones::ProcessSnapHotkey() noexcept
 {
     if (m_settings->GetSettings()->overrideSnapHotkeys)
     {
-        const HMONITOR monitor = MonitorFromWindow(GetForegroundWindow(), MONITOR_DEFAULTTONULL);
+        auto& platform = PlatformInstance();
+        const HMONITOR monitor = platform.MonitorOfWindow(platform.ForegroundWindow());
         if (monitor)
         {
             auto zoneWindow = m_zoneWindowMap.find(monitor);
@@ -975,33 +1601,38 @@ bool FancyZones::ProcessSnapHotkey() noexcept
     return false;
 }
 
-std::vector<HMONITOR> FancyZones::GetMonitorsSorted() noexcept
+// Only the monitor's own zones are ranked again, and the zones they were neighbors of.
+void FancyZones::UpdateZoneNeighbors(HMONITOR monitor, IZoneWindow* zoneWindow) noexcept
 {
-    std::shared_lock readLock(m_lock);
-
-    auto monitorInfo = GetRawMonitorData();
-    OrderMonitors(monitorInfo);
-    std::vector<HMONITOR> output;
-    std::transform(std::begin(monitorInfo), std::end(monitorInfo), std::back_inserter(output), [](const auto& info) { return info.first; });
-    return output;
+    const auto topology = MonitorTopologyInstance().Current(PlatformInstance());
+    const auto info = topology->Find(monitor);
+    IZoneSet* zoneSet = zoneWindow ? zoneWindow->ActiveZoneSet() : nullptr;
+    m_neighborZoneRects.clear();
+    if (info && zoneSet)
+    {
+        // Zone rects are relative to the work area
+        for (const auto& zone : zoneSet->GetZones())
+        {
+            RECT rect = zone->GetZoneRect();
+            OffsetRect(&rect, info->workArea.left, info->workArea.top);
+            m_neighborZoneRects.push_back(rect);
+        }
+    }
+    m_zoneNeighbors.SetMonitorZones(monitor, m_neighborZoneRects);
 }
 
-std::vector<std::pair<HMONITOR, RECT>> FancyZones::GetRawMonitorData() noexcept
+// Monitors which went away keep their zone window, they're dropped from the index as they have no geometry.
+void FancyZones::UpdateZoneNeighbors() noexcept
 {
-    std::shared_lock readLock(m_lock);
-
-    std::vector<std::pair<HMONITOR, RECT>> monitorInfo;
-    for (const auto& [monitor, window] : m_zoneWindowMap)
+    std::map<HMONITOR, winrt::com_ptr<IZoneWindow>> zoneWindowMap;
     {
-        if (window->ActiveZoneSet() != nullptr)
-        {
-            MONITORINFOEX mi;
-            mi.cbSize = sizeof(mi);
-            GetMonitorInfo(monitor, &mi);
-            monitorInfo.push_back({ monitor, mi.rcMonitor });
-        }
+        auto readLock = LockForRead(LockSite::MonitorData);
+        zoneWindowMap = m_zoneWindowMap;
+    }
+    for (const auto& [monitor, zoneWindow] : zoneWindowMap)
+    {
+        UpdateZoneNeighbors(monitor, zoneWindow.get());
     }
-    return monitorInfo;
 }
 
 winrt::com_ptr<IFancyZones> MakeFancyZones(HINSTANCE hinstance, const winrt::com_ptr<IFancyZonesSettings>& settings) noexcept
@@ -5,6 +5,7 @@ interface IFancyZonesSettings;
 interface IZoneSet;
 
 struct WinHookEvent;
+class LatencyHistogram;
 
 interface __declspec(uuid("{50D3F0F5-736E-4186-BDF4-3D6BEE150C3A}")) IFancyZones : public IUnknown
 {
@@ -41,6 +42,12 @@ interface __declspec(uuid("{2CB37E8F-87E6-4AEC-B4B2-E0FDC873343F}")) IFancyZones
      *          in event chain, or should it be suppressed.
      */
     IFACEMETHOD_(bool, OnKeyDown)(PKBDLLHOOKSTRUCT info) = 0;
+    /**
+     * Process key release, used to keep track of modifier keys.
+     *
+     * @param   info Information about low level keyboard event.
+     */
+    IFACEMETHOD_(void, OnKeyUp)(PKBDLLHOOKSTRUCT info) = 0;
     /**
      * Toggle FancyZones editor application.
      */
@@ -66,4 +73,9 @@ interface __declspec(uuid("{5C8D99D6-34B2-4F4A-A8E5-7483F6869775}")) IZoneWindow
     IFACEMETHOD_(IZoneWindow*, GetParentZoneWindow) (HMONITOR monitor) = 0;
 };
 
+/**
+ * @returns Time spent handling low level keyboard events, in nanoseconds.
+ */
+const LatencyHistogram& KeyboardHookLatency() noexcept;
+
 winrt::com_ptr<IFancyZones> MakeFancyZones(HINSTANCE hinstance, const winrt::com_ptr<IFancyZonesSettings>& settings) noexcept;
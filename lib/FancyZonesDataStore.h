@@ -0,0 +1,162 @@
+#pragma once
+
+#include "AppZoneHistory.h"
+#include "LockProfiler.h"
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace JSONHelpers
+{
+    constexpr wchar_t DEFAULT_GUID[] = L"{00000000-0000-0000-0000-000000000000}";
+
+    inline std::wstring ExtractVirtualDesktopId(const std::wstring& deviceId)
+    {
+        // Format: <device-id>_<resolution>_<virtual-desktop-id>
+        return deviceId.substr(deviceId.rfind('_') + 1);
+    }
+
+    // Kinds of access to FancyZonesData, each one has its own contention counters. Persist holds
+    // the lock across file or registry access.
+    enum class DataLockSite : uint8_t
+    {
+        Read,
+        Write,
+        Persist,
+        Count
+    };
+
+    constexpr const wchar_t* DataLockSiteNames[] = {
+        L"Read",
+        L"Write",
+        L"Persist",
+    };
+    static_assert(std::size(DataLockSiteNames) == static_cast<size_t>(DataLockSite::Count));
+
+    // The in-memory part of FancyZonesData and its lock, without winrt so benchmarks can drive it.
+    // DeviceInfo has an activeZoneSet whose type is Blank until a layout is applied, saving is left
+    // to FancyZonesData.
+    template<typename DeviceInfo, typename CustomZoneSet>
+    class FancyZonesDataStore
+    {
+    protected:
+        using DataLock = ProfiledLock<std::unique_lock<std::recursive_mutex>>;
+
+        // Nested acquisitions by the owning thread count as uncontended, their hold time is also
+        // part of the outer one's
+        DataLock LockData(DataLockSite site) const noexcept
+        {
+            return DataLock(dataLock, dataLockStats[static_cast<size_t>(site)]);
+        }
+
+    public:
+        virtual ~FancyZonesDataStore() = default;
+
+        // Called with the write lock of the change held
+        virtual void SaveFancyZonesData() const = 0;
+
+        std::optional<DeviceInfo> FindDeviceInfo(const std::wstring& zoneWindowId) const
+        {
+            auto lock = LockData(DataLockSite::Read);
+            auto it = deviceInfoMap.find(zoneWindowId);
+            return it != end(deviceInfoMap) ? std::optional{ it->second } : std::nullopt;
+        }
+
+        std::optional<CustomZoneSet> FindCustomZoneSet(const std::wstring& guuid) const
+        {
+            auto lock = LockData(DataLockSite::Read);
+            auto it = customZoneSetsMap.find(guuid);
+            return it != end(customZoneSetsMap) ? std::optional{ it->second } : std::nullopt;
+        }
+
+        // Returns true if persisted data was modified, saving it is left to the caller.
+        bool RemoveDevicesByVirtualDesktopIds(const std::vector<std::wstring>& virtualDesktopIds)
+        {
+            std::unordered_set<std::wstring> removed(std::begin(virtualDesktopIds), std::end(virtualDesktopIds));
+            removed.erase(DEFAULT_GUID);
+            if (removed.empty())
+            {
+                return false;
+            }
+
+            auto lock = LockData(DataLockSite::Write);
+            bool modified{ false };
+            for (auto it = deviceInfoMap.begin(); it != deviceInfoMap.end();)
+            {
+                if (removed.contains(ExtractVirtualDesktopId(it->first)))
+                {
+                    it = deviceInfoMap.erase(it);
+                    modified = true;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            return modified;
+        }
+
+        void CloneDeviceInfo(const std::wstring& source, const std::wstring& destination)
+        {
+            if (source == destination)
+            {
+                return;
+            }
+            auto lock = LockData(DataLockSite::Write);
+
+            // The source virtual desktop is deleted, simply ignore it.
+            if (!deviceInfoMap.contains(source))
+            {
+                return;
+            }
+
+            // Clone information from source device if destination device is uninitialized (Blank).
+            using LayoutType = decltype(DeviceInfo{}.activeZoneSet.type);
+            auto& destInfo = deviceInfoMap[destination];
+            if (destInfo.activeZoneSet.type == LayoutType::Blank)
+            {
+                destInfo = deviceInfoMap[source];
+            }
+        }
+
+        std::vector<int> GetAppLastZoneIndexSet(std::wstring_view processPath, std::wstring_view deviceId, std::wstring_view zoneSetId) const
+        {
+            auto lock = LockData(DataLockSite::Read);
+            const auto history = appZoneHistory.Find(processPath);
+            if (history && appZoneHistory.ZoneSetUuid(*history) == zoneSetId && appZoneHistory.DeviceId(*history) == deviceId)
+            {
+                return history->zoneIndexSet;
+            }
+            return {};
+        }
+
+        void SetAppLastZones(std::wstring_view processPath, const std::wstring& deviceId, const std::wstring& zoneSetId, const std::vector<int>& zoneIndexSet)
+        {
+            auto lock = LockData(DataLockSite::Write);
+            appZoneHistory.Set(processPath, zoneSetId, deviceId, zoneIndexSet);
+            SaveFancyZonesData();
+        }
+
+        inline const LockSiteStats& GetLockStats(DataLockSite site) const noexcept
+        {
+            return dataLockStats[static_cast<size_t>(site)];
+        }
+
+    protected:
+        mutable AppZoneHistory appZoneHistory{}; // Looking applications up updates their recency
+        std::unordered_map<std::wstring, DeviceInfo> deviceInfoMap{};
+        std::unordered_map<std::wstring, CustomZoneSet> customZoneSetsMap{};
+
+    private:
+        mutable std::recursive_mutex dataLock;
+        mutable std::array<LockSiteStats, static_cast<size_t>(DataLockSite::Count)> dataLockStats;
+    };
+}
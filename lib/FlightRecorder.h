@@ -0,0 +1,388 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Always-on record of what FancyZones decided and what went wrong, to look at after the fact.
+//
+// Every thread appends fixed-size binary records to a ring of its own, without locks or
+// allocations, and formatting is deferred until a dump is read back. A ring keeps the latest
+// RING_CAPACITY records of its thread and outlives it, so a dump taken on demand or from a crash
+// handler holds the recent past of every thread.
+//
+// Dump layout, native endianness:
+//     FileHeader
+//     uint16_t length, char format[length]    * formatCount, by event
+//     Record                                  * n, ring after ring, oldest first within a ring
+// Formats use {} for a signed decimal, {x} for hex and {s} for text packed into the remaining
+// arguments. They're stored in the dump, so dumps of older builds read back as they were written.
+namespace FlightRecorder
+{
+    enum class Event : uint16_t
+    {
+        Failure, // hr, line, file name
+        LayoutDecision, // generation, operation, monitor, windows, zones, main zone width
+        LayoutWindow, // generation, index, window, zone before the relayout
+        LayoutZone, // generation, index, left, top, right, bottom
+        LayoutMove, // generation, window, zone
+        LayoutSuperseded, // generation, windows moved before it was
+        Count
+    };
+
+    inline constexpr const char* EVENT_FORMATS[] = {
+        "failure {x} at line {} of {s}",
+        "layout {}: operation {} on monitor {x}, {} windows, {} zones, main zone width {}",
+        "layout {}: window {} {x} was in zone {}",
+        "layout {}: zone {} ({}, {}, {}, {})",
+        "layout {}: moved {x} to zone {}",
+        "layout {}: superseded after {} moves",
+    };
+    static_assert(std::size(EVENT_FORMATS) == static_cast<size_t>(Event::Count));
+
+    inline constexpr size_t ARG_COUNT = 6;
+    inline constexpr size_t RING_CAPACITY = 1024; // Power of two
+    inline constexpr size_t MAX_THREADS = 32; // Records of threads beyond that are dropped
+    static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0);
+
+    struct FileHeader
+    {
+        char magic[4]{ 'F', 'T', 'F', 'R' };
+        uint32_t version{ 1 };
+        uint32_t recordSize{};
+        uint32_t formatCount{};
+        uint64_t dropped{}; // Records not kept for lack of a ring
+    };
+    static_assert(sizeof(FileHeader) == 24);
+
+    struct Record
+    {
+        int64_t timeNs{}; // steady_clock
+        Event event{};
+        uint16_t reserved{};
+        uint32_t thread{};
+        uint64_t args[ARG_COUNT]{};
+    };
+    static_assert(sizeof(Record) == 64);
+
+    // Single writer, the thread which owns it. Readers may copy records at any time, a slot is
+    // only taken when its sequence is the same before and after the copy. Records are stored as
+    // relaxed atomic words, which are plain moves on x86 and x64, so such copies aren't data races.
+    class Ring
+    {
+    public:
+        explicit Ring(uint32_t thread) noexcept :
+            m_thread(thread)
+        {
+        }
+
+        uint32_t Thread() const noexcept
+        {
+            return m_thread;
+        }
+
+        void Append(const Record& record) noexcept
+        {
+            const uint64_t position = m_head.load(std::memory_order_relaxed);
+            auto& slot = m_slots[position & (RING_CAPACITY - 1)];
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            uint64_t words[WORDS];
+            std::memcpy(words, &record, sizeof(record));
+            for (size_t i = 0; i < WORDS; i++)
+            {
+                slot.words[i].store(words[i], std::memory_order_relaxed);
+            }
+            slot.sequence.store(position + 1, std::memory_order_release);
+            m_head.store(position + 1, std::memory_order_release);
+        }
+
+        // Oldest first. Records overwritten or being written while this runs are skipped.
+        template<typename Visitor>
+        void ForEach(Visitor&& visitor) const noexcept
+        {
+            const uint64_t head = m_head.load(std::memory_order_acquire);
+            for (uint64_t position = head > RING_CAPACITY ? head - RING_CAPACITY : 0; position < head; position++)
+            {
+                const auto& slot = m_slots[position & (RING_CAPACITY - 1)];
+                if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+                {
+                    continue;
+                }
+                uint64_t words[WORDS];
+                for (size_t i = 0; i < WORDS; i++)
+                {
+                    words[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == position + 1)
+                {
+                    Record record;
+                    std::memcpy(&record, words, sizeof(record));
+                    visitor(record);
+                }
+            }
+        }
+
+    private:
+        static constexpr size_t WORDS = sizeof(Record) / sizeof(uint64_t);
+
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence{ 0 }; // Position in the ring plus one, 0 while written
+            std::atomic<uint64_t> words[WORDS]{};
+        };
+
+        const uint32_t m_thread;
+        std::atomic<uint64_t> m_head{ 0 };
+        std::array<Slot, RING_CAPACITY> m_slots{};
+    };
+
+    // Rings are never freed: a dump may be taken after their threads exited, or while crashing.
+    inline std::array<std::atomic<Ring*>, MAX_THREADS> s_rings{};
+    inline std::atomic<size_t> s_ringCount{ 0 };
+    inline std::atomic<uint64_t> s_dropped{ 0 };
+    inline thread_local Ring* t_ring = nullptr;
+    inline thread_local bool t_noRing = false;
+
+    inline uint32_t CurrentThreadId(size_t ordinal) noexcept
+    {
+#if defined(_WIN32)
+        (void)ordinal;
+        return GetCurrentThreadId();
+#else
+        return static_cast<uint32_t>(ordinal + 1);
+#endif
+    }
+
+    // The first record of a thread allocates its ring.
+    inline Ring* CurrentRing() noexcept
+    {
+        if (t_ring || t_noRing)
+        {
+            return t_ring;
+        }
+
+        const size_t ordinal = s_ringCount.fetch_add(1, std::memory_order_relaxed);
+        if (ordinal >= MAX_THREADS)
+        {
+            t_noRing = true;
+            return nullptr;
+        }
+        t_ring = new (std::nothrow) Ring(CurrentThreadId(ordinal));
+        t_noRing = t_ring == nullptr;
+        s_rings[ordinal].store(t_ring, std::memory_order_release);
+        return t_ring;
+    }
+
+    template<typename T>
+    constexpr uint64_t ToArg(T value) noexcept
+    {
+        if constexpr (std::is_pointer_v<T>)
+        {
+            return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            return static_cast<uint64_t>(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else
+        {
+            return static_cast<uint64_t>(value);
+        }
+    }
+
+    inline int64_t Now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    template<typename... Args>
+    inline void Log(Event event, Args... args) noexcept
+    {
+        static_assert(sizeof...(Args) <= ARG_COUNT);
+        Ring* ring = CurrentRing();
+        if (!ring)
+        {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring->Append(Record{ Now(), event, 0, ring->Thread(), { ToArg(args)... } });
+    }
+
+    // The end of the file name is kept if it doesn't fit.
+    inline void LogFailure(int32_t hr, uint32_t line, std::string_view file) noexcept
+    {
+        constexpr size_t textArgs = ARG_COUNT - 2;
+        file = file.substr(file.find_last_of("\\/") + 1);
+        file = file.substr(file.size() > textArgs * sizeof(uint64_t) ? file.size() - textArgs * sizeof(uint64_t) : 0);
+
+        Ring* ring = CurrentRing();
+        if (!ring)
+        {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Record record{ Now(), Event::Failure, 0, ring->Thread(), { static_cast<uint32_t>(hr), line } };
+        std::memcpy(&record.args[2], file.data(), file.size());
+        ring->Append(record);
+    }
+
+    // write(const void* data, size_t size) is called with consecutive parts of the dump. Doesn't
+    // allocate, so it can run in a crash handler.
+    template<typename Write>
+    void Dump(Write&& write) noexcept
+    {
+        FileHeader header{};
+        header.recordSize = sizeof(Record);
+        header.formatCount = static_cast<uint32_t>(Event::Count);
+        header.dropped = s_dropped.load(std::memory_order_relaxed);
+        write(&header, sizeof(header));
+
+        for (const char* format : EVENT_FORMATS)
+        {
+            const auto length = static_cast<uint16_t>(std::strlen(format));
+            write(&length, sizeof(length));
+            write(format, length);
+        }
+
+        std::array<Record, 32> batch;
+        size_t count = 0;
+        const size_t rings = (std::min)(s_ringCount.load(std::memory_order_acquire), MAX_THREADS);
+        for (size_t i = 0; i < rings; i++)
+        {
+            const Ring* ring = s_rings[i].load(std::memory_order_acquire);
+            if (!ring)
+            {
+                continue;
+            }
+            ring->ForEach([&](const Record& record) {
+                batch[count++] = record;
+                if (count == batch.size())
+                {
+                    write(batch.data(), count * sizeof(Record));
+                    count = 0;
+                }
+            });
+        }
+        if (count > 0)
+        {
+            write(batch.data(), count * sizeof(Record));
+        }
+    }
+
+    struct Contents
+    {
+        std::vector<std::string> formats; // By event
+        std::vector<Record> records; // By time, across threads
+        uint64_t dropped{};
+    };
+
+    // Returns false if the stream isn't a dump, a truncated last record is ignored.
+    inline bool Read(std::istream& stream, Contents& contents)
+    {
+        FileHeader header{};
+        const FileHeader expected{};
+        if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+            header.version != expected.version ||
+            header.recordSize != sizeof(Record))
+        {
+            return false;
+        }
+        contents.dropped = header.dropped;
+
+        for (uint32_t i = 0; i < header.formatCount; i++)
+        {
+            uint16_t length = 0;
+            if (!stream.read(reinterpret_cast<char*>(&length), sizeof(length)))
+            {
+                return false;
+            }
+            std::string format(length, '\0');
+            if (!stream.read(format.data(), length))
+            {
+                return false;
+            }
+            contents.formats.push_back(std::move(format));
+        }
+
+        Record record{};
+        while (stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        {
+            contents.records.push_back(record);
+        }
+        std::stable_sort(contents.records.begin(), contents.records.end(), [](const Record& a, const Record& b) {
+            return a.timeNs < b.timeNs;
+        });
+        return true;
+    }
+
+    // Missing arguments format as 0, unknown placeholders are copied as they are.
+    inline std::string Format(std::string_view format, const Record& record)
+    {
+        std::string text;
+        size_t arg = 0;
+        for (size_t i = 0; i < format.size(); i++)
+        {
+            const auto placeholder = format.substr(i, 3);
+            const uint64_t value = arg < ARG_COUNT ? record.args[arg] : 0;
+            char number[24]{};
+            if (placeholder.starts_with("{}"))
+            {
+                text += std::to_string(static_cast<int64_t>(value));
+                arg++;
+                i += 1;
+            }
+            else if (placeholder == "{x}")
+            {
+                std::snprintf(number, sizeof(number), "%#llx", static_cast<unsigned long long>(value));
+                text += number;
+                arg++;
+                i += 2;
+            }
+            else if (placeholder == "{s}")
+            {
+                const size_t offset = (std::min)(arg, ARG_COUNT) * sizeof(uint64_t);
+                const auto bytes = reinterpret_cast<const char*>(record.args);
+                const std::string_view packed(bytes + offset, sizeof(record.args) - offset);
+                text += packed.substr(0, packed.find('\0'));
+                arg = ARG_COUNT;
+                i += 2;
+            }
+            else
+            {
+                text += format[i];
+            }
+        }
+        return text;
+    }
+
+    // "time thread text" lines, time in microseconds since the first record.
+    inline void WriteText(std::ostream& stream, const Contents& contents)
+    {
+        const int64_t origin = contents.records.empty() ? 0 : contents.records.front().timeNs;
+        for (const auto& record : contents.records)
+        {
+            const auto event = static_cast<size_t>(record.event);
+            stream << (record.timeNs - origin) / 1000 << " " << record.thread << " "
+                   << (event < contents.formats.size() ? Format(contents.formats[event], record) : "unknown event " + std::to_string(event)) << "\n";
+        }
+        if (contents.dropped > 0)
+        {
+            stream << contents.dropped << " records dropped\n";
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Platform independent frame pacing used by the animated window placement mode.
+// Window, Rect, Clock and Backend are template parameters so the scheduler and its
+// frame-drop policy can be driven by a fake clock and a fake window backend.
+//
+// Clock requirements:
+//     typename Clock::duration, typename Clock::time_point
+//     time_point now()
+//     void sleep_until(time_point)
+//
+// Backend requirements:
+//     void PresentFrame(const std::vector<std::pair<Window, Rect>>& frame)   // intermediate, batched step
+//     void CommitFrame(const std::vector<std::pair<Window, Rect>>& frame)    // final placement
+namespace FrameScheduling
+{
+    template<typename Window, typename Rect>
+    struct AnimationTarget
+    {
+        Window window;
+        Rect from;
+        Rect to;
+    };
+
+    struct FrameStats
+    {
+        size_t framesPresented{};
+        size_t framesDropped{};
+        bool cancelled{};
+    };
+
+    // Ease-out cubic, fast start and gentle landing.
+    inline double Ease(double t) noexcept
+    {
+        const double inv = 1.0 - t;
+        return 1.0 - inv * inv * inv;
+    }
+
+    // Frame interval of a refresh rate given as a fraction in Hz, e.g. 60000/1001 for 59.94 Hz. Rounded
+    // to the nearest tick rather than truncated to whole Hz, so frames don't drift off refresh.
+    template<typename Duration>
+    Duration FrameInterval(uint64_t rateNumerator, uint64_t rateDenominator, Duration fallback) noexcept
+    {
+        if (rateNumerator == 0 || rateDenominator == 0)
+        {
+            return fallback;
+        }
+        const std::chrono::duration<double> interval{ static_cast<double>(rateDenominator) / static_cast<double>(rateNumerator) };
+        const auto rounded = std::chrono::round<Duration>(interval);
+        return rounded > Duration::zero() ? rounded : fallback;
+    }
+
+    template<typename Rect>
+    Rect Interpolate(const Rect& from, const Rect& to, double t) noexcept
+    {
+        auto lerp = [t](auto a, auto b) {
+            return static_cast<decltype(a)>(std::lround(a + (b - a) * t));
+        };
+
+        Rect result = to;
+        result.left = lerp(from.left, to.left);
+        result.top = lerp(from.top, to.top);
+        result.right = lerp(from.right, to.right);
+        result.bottom = lerp(from.bottom, to.bottom);
+        return result;
+    }
+
+    template<typename Window, typename Rect, typename Clock, typename Backend>
+    class FrameScheduler
+    {
+    public:
+        using duration = typename Clock::duration;
+        using time_point = typename Clock::time_point;
+        using Frame = std::vector<std::pair<Window, Rect>>;
+
+        FrameScheduler(Clock& clock, Backend& backend, duration frameInterval, duration animationLength) noexcept :
+            m_clock(clock),
+            m_backend(backend),
+            m_frameInterval(frameInterval > duration::zero() ? frameInterval : duration{ 1 }),
+            m_frameCount(FrameCount(m_frameInterval, animationLength))
+        {
+        }
+
+        size_t FrameCountPerAnimation() const noexcept { return m_frameCount; }
+
+        // Frame k (1-based) is due at start + (k - 1) * frameInterval and shows progress k / frameCount.
+        // Whenever presentation falls behind, every frame whose deadline already passed is dropped and
+        // the scheduler jumps straight to the latest due frame. If a single frame costs more than the
+        // whole frame budget, interpolation is abandoned and the final rects are committed immediately.
+        // The final frame is always committed unless the animation is cancelled (superseded).
+        FrameStats Run(const std::vector<AnimationTarget<Window, Rect>>& targets, const std::function<bool()>& cancelled = {})
+        {
+            FrameStats stats{};
+            if (targets.empty())
+            {
+                return stats;
+            }
+
+            const time_point start = m_clock.now();
+            size_t frame = 1;
+            while (frame < m_frameCount)
+            {
+                if (cancelled && cancelled())
+                {
+                    stats.cancelled = true;
+                    return stats;
+                }
+
+                const size_t due = DueFrame(m_clock.now() - start);
+                if (due > frame)
+                {
+                    stats.framesDropped += due - frame;
+                    frame = due;
+                    if (frame >= m_frameCount)
+                    {
+                        break;
+                    }
+                }
+
+                const time_point frameStart = m_clock.now();
+                m_backend.PresentFrame(BuildFrame(targets, Ease(static_cast<double>(frame) / m_frameCount)));
+                stats.framesPresented++;
+
+                if (m_clock.now() - frameStart > m_frameInterval)
+                {
+                    // Placement alone is slower than the refresh rate, animating would only add latency.
+                    stats.framesDropped += m_frameCount - 1 - frame;
+                    break;
+                }
+
+                frame++;
+                m_clock.sleep_until(start + m_frameInterval * static_cast<typename duration::rep>(frame - 1));
+            }
+
+            if (cancelled && cancelled())
+            {
+                stats.cancelled = true;
+                return stats;
+            }
+
+            m_backend.CommitFrame(BuildFrame(targets, 1.0));
+            stats.framesPresented++;
+            return stats;
+        }
+
+    private:
+        static size_t FrameCount(duration frameInterval, duration animationLength) noexcept
+        {
+            if (animationLength <= frameInterval)
+            {
+                return 1;
+            }
+            return static_cast<size_t>((animationLength + frameInterval - duration{ 1 }) / frameInterval);
+        }
+
+        size_t DueFrame(duration elapsed) const noexcept
+        {
+            const auto due = static_cast<size_t>(elapsed / m_frameInterval) + 1;
+            return (std::min)(due, m_frameCount);
+        }
+
+        static Frame BuildFrame(const std::vector<AnimationTarget<Window, Rect>>& targets, double progress)
+        {
+            Frame frame;
+            frame.reserve(targets.size());
+            for (const auto& target : targets)
+            {
+                frame.emplace_back(target.window, progress >= 1.0 ? target.to : Interpolate(target.from, target.to, progress));
+            }
+            return frame;
+        }
+
+        Clock& m_clock;
+        Backend& m_backend;
+        const duration m_frameInterval;
+        const size_t m_frameCount;
+    };
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hand-off of WinEvent hook notifications to the FancyZones message loop. Hook callbacks push
+// compact records into a bounded lock-free ring, and only the push which finds no wake-up pending
+// has to post a message. The consumer drains everything queued at once and dispatches a single
+// record per window and event.
+namespace HookEvents
+{
+    // Bounded multi-producer single-consumer ring, after Dmitry Vyukov's bounded MPMC queue.
+    // Every cell carries a sequence number, producers claim a slot with a single CAS and the
+    // consumer never writes shared state other than the cell it releases.
+    template<typename T, size_t Capacity>
+    class MpscRing
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        MpscRing() noexcept
+        {
+            for (size_t i = 0; i < Capacity; i++)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing&) = delete;
+        MpscRing& operator=(const MpscRing&) = delete;
+
+        // Returns false if the ring is full.
+        bool TryPush(const T& value) noexcept
+        {
+            size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;)
+            {
+                cell = &m_cells[position & (Capacity - 1)];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0)
+                {
+                    if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->value = value;
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Single consumer only.
+        bool TryPop(T& value) noexcept
+        {
+            Cell& cell = m_cells[m_dequeuePosition & (Capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(m_dequeuePosition + 1) < 0)
+            {
+                return false;
+            }
+
+            value = cell.value;
+            cell.sequence.store(m_dequeuePosition + Capacity, std::memory_order_release);
+            m_dequeuePosition++;
+            return true;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        Cell m_cells[Capacity];
+        alignas(64) std::atomic<size_t> m_enqueuePosition{ 0 };
+        alignas(64) size_t m_dequeuePosition{ 0 };
+    };
+
+    template<typename Window>
+    struct EventRecord
+    {
+        Window window{};
+        uint32_t event{};
+
+        bool operator==(const EventRecord&) const = default;
+    };
+
+    struct QueueStats
+    {
+        uint64_t received{};
+        uint64_t coalesced{};
+        uint64_t dropped{};
+        uint64_t batches{};
+        uint64_t maxDepth{}; // Most events popped by one drain, before coalescing
+    };
+
+    template<typename Window, size_t Capacity>
+    class EventQueue
+    {
+    public:
+        EventQueue()
+        {
+            m_batch.reserve(Capacity);
+        }
+
+        // Safe to call from any thread. Returns true if the consumer has to be woken up, which
+        // happens once per batch. A full ring drops the event and flags the batch as incomplete.
+        bool Push(Window window, uint32_t event) noexcept
+        {
+            m_received.fetch_add(1, std::memory_order_relaxed);
+            if (!m_ring.TryPush(EventRecord<Window>{ window, event }))
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                m_overflowed.store(true, std::memory_order_release);
+            }
+            return !m_wakePending.exchange(true);
+        }
+
+        // Call when waking the consumer failed, so the next push tries again.
+        void CancelWake() noexcept
+        {
+            m_wakePending.store(false);
+        }
+
+        // Consumer side. Handler is called once for each distinct window and event, in order of
+        // first arrival. Returns false if events were dropped since the previous drain.
+        template<typename Handler>
+        bool Drain(Handler&& handler) noexcept
+        {
+            // Pushes from now on wake the consumer again, whatever is already queued is handled below
+            m_wakePending.store(false);
+
+            m_batch.clear();
+            uint64_t depth = 0;
+            EventRecord<Window> record;
+            while (m_ring.TryPop(record))
+            {
+                depth++;
+                // Batches are short, a linear scan beats hashing here
+                if (std::find(m_batch.begin(), m_batch.end(), record) == m_batch.end())
+                {
+                    m_batch.push_back(record);
+                }
+                else
+                {
+                    m_coalesced.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            m_batches.fetch_add(1, std::memory_order_relaxed);
+            if (depth > m_maxDepth.load(std::memory_order_relaxed))
+            {
+                m_maxDepth.store(depth, std::memory_order_relaxed);
+            }
+
+            for (const auto& event : m_batch)
+            {
+                handler(event);
+            }
+            return !m_overflowed.exchange(false, std::memory_order_acq_rel);
+        }
+
+        QueueStats GetStats() const noexcept
+        {
+            return QueueStats{
+                .received = m_received.load(std::memory_order_relaxed),
+                .coalesced = m_coalesced.load(std::memory_order_relaxed),
+                .dropped = m_dropped.load(std::memory_order_relaxed),
+                .batches = m_batches.load(std::memory_order_relaxed),
+                .maxDepth = m_maxDepth.load(std::memory_order_relaxed)
+            };
+        }
+
+    private:
+        MpscRing<EventRecord<Window>, Capacity> m_ring;
+        std::vector<EventRecord<Window>> m_batch; // Only touched by the consumer, capacity is reserved upfront
+
+        std::atomic<bool> m_wakePending{ false };
+        std::atomic<bool> m_overflowed{ false };
+        std::atomic<uint64_t> m_received{ 0 };
+        std::atomic<uint64_t> m_coalesced{ 0 };
+        std::atomic<uint64_t> m_dropped{ 0 };
+        std::atomic<uint64_t> m_batches{ 0 };
+        std::atomic<uint64_t> m_maxDepth{ 0 }; // Only written by the consumer
+    };
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Simulated desktop: monitors, virtual desktops and top-level windows only exist in memory, and
+// placing a window just updates its rect. Handles are small integers disguised as pointers.
+class InMemoryPlatform : public Platform::Backend
+{
+public:
+    using WindowHandle = Platform::WindowHandle;
+    using MonitorHandle = Platform::MonitorHandle;
+    using Rect = Platform::Rect;
+    using DesktopId = Platform::DesktopId;
+
+    struct Window
+    {
+        std::wstring processPath;
+        Rect rect{};
+        size_t desktop{}; // Index of the virtual desktop the window is on
+        bool zonable{ true };
+    };
+
+    struct Monitor
+    {
+        Rect rect{};
+        Rect workArea{};
+        unsigned dpi{ 96 };
+        std::wstring deviceId; // Generated from the index if empty
+        bool mirroring{};
+    };
+
+    struct Stats
+    {
+        uint64_t windowEnumerations{};
+        uint64_t windowQueries{};
+        uint64_t placements{};
+        uint64_t monitorQueries{};
+        uint64_t desktopQueries{};
+    };
+
+    // Monitors side by side, windows spread round-robin over monitors and desktops.
+    static InMemoryPlatform Generate(size_t monitorCount, size_t desktopCount, size_t windowCount, int32_t width = 1920, int32_t height = 1080)
+    {
+        InMemoryPlatform platform;
+        for (size_t i = 0; i < monitorCount; i++)
+        {
+            const int32_t left = static_cast<int32_t>(i) * width;
+            platform.AddMonitor(Rect{ left, 0, left + width, height }, Rect{ left, 0, left + width, height - 40 });
+        }
+        for (size_t i = 1; i < desktopCount; i++)
+        {
+            platform.AddDesktop();
+        }
+        for (size_t i = 0; i < windowCount && monitorCount > 0; i++)
+        {
+            const int32_t left = static_cast<int32_t>(i % monitorCount) * width + 100;
+            platform.AddWindow(Window{
+                .processPath = L"C:\\APPS\\APP" + std::to_wstring(i % 50) + L".EXE",
+                .rect = Rect{ left, 100, left + 800, 700 },
+                .desktop = i % platform.DesktopCount(),
+            });
+        }
+        return platform;
+    }
+
+    MonitorHandle AddMonitor(const Rect& rect, const Rect& workArea, unsigned dpi = 96)
+    {
+        m_monitors.push_back(Monitor{ rect, workArea, dpi, {}, false });
+        return ToMonitor(m_monitors.size() - 1);
+    }
+
+    size_t AddDesktop()
+    {
+        return m_desktopCount++;
+    }
+
+    size_t DesktopCount() const noexcept
+    {
+        return m_desktopCount;
+    }
+
+    // New windows are activated, like they would be when opened.
+    WindowHandle AddWindow(Window window)
+    {
+        const WindowHandle handle = reinterpret_cast<WindowHandle>(m_nextWindow++);
+        m_windows.emplace(handle, std::move(window));
+        m_zOrder.insert(m_zOrder.begin(), handle);
+        m_foreground = handle;
+        return handle;
+    }
+
+    void RemoveWindow(WindowHandle window)
+    {
+        m_windows.erase(window);
+        m_zOrder.erase(std::remove(m_zOrder.begin(), m_zOrder.end(), window), m_zOrder.end());
+        if (m_foreground == window)
+        {
+            m_foreground = m_zOrder.empty() ? nullptr : m_zOrder.front();
+        }
+    }
+
+    void Activate(WindowHandle window)
+    {
+        const auto it = std::find(m_zOrder.begin(), m_zOrder.end(), window);
+        if (it != m_zOrder.end())
+        {
+            std::rotate(m_zOrder.begin(), it, it + 1);
+            m_foreground = window;
+        }
+    }
+
+    void SwitchDesktop(size_t desktop) noexcept
+    {
+        m_currentDesktop = desktop < m_desktopCount ? desktop : m_currentDesktop;
+    }
+
+    const Window* WindowInfo(WindowHandle window) const
+    {
+        const auto it = m_windows.find(window);
+        return it != m_windows.end() ? &it->second : nullptr;
+    }
+
+    const Stats& GetStats() const noexcept
+    {
+        return m_stats;
+    }
+
+    // Platform::Backend
+    void TopLevelWindows(std::vector<WindowHandle>& windows) noexcept override
+    {
+        m_stats.windowEnumerations++;
+        windows.assign(m_zOrder.begin(), m_zOrder.end());
+    }
+
+    WindowHandle ForegroundWindow() noexcept override
+    {
+        return m_foreground;
+    }
+
+    bool GetZonableWindowProcess(WindowHandle window, std::wstring& processPath) noexcept override
+    {
+        m_stats.windowQueries++;
+        const auto it = m_windows.find(window);
+        if (it == m_windows.end() || !it->second.zonable)
+        {
+            return false;
+        }
+        processPath = it->second.processPath;
+        return true;
+    }
+
+    bool IsOnCurrentDesktop(WindowHandle window) noexcept override
+    {
+        m_stats.windowQueries++;
+        const auto it = m_windows.find(window);
+        return it != m_windows.end() && it->second.desktop == m_currentDesktop;
+    }
+
+    void PlaceWindow(WindowHandle window, const Rect& rect) noexcept override
+    {
+        m_stats.placements++;
+        const auto it = m_windows.find(window);
+        if (it != m_windows.end())
+        {
+            it->second.rect = rect;
+        }
+    }
+
+    void Monitors(std::vector<MonitorHandle>& monitors) noexcept override
+    {
+        m_stats.monitorQueries++;
+        monitors.clear();
+        for (size_t i = 0; i < m_monitors.size(); i++)
+        {
+            monitors.push_back(ToMonitor(i));
+        }
+    }
+
+    size_t MonitorCount() noexcept override
+    {
+        return m_monitors.size();
+    }
+
+    // Monitor with the largest intersection, like MonitorFromWindow.
+    MonitorHandle MonitorOfWindow(WindowHandle window) noexcept override
+    {
+        m_stats.monitorQueries++;
+        const auto it = m_windows.find(window);
+        if (it == m_windows.end())
+        {
+            return nullptr;
+        }
+
+        MonitorHandle best{};
+        int64_t bestArea = 0;
+        for (size_t i = 0; i < m_monitors.size(); i++)
+        {
+            const int64_t area = IntersectionArea(it->second.rect, m_monitors[i].rect);
+            if (area > bestArea)
+            {
+                best = ToMonitor(i);
+                bestArea = area;
+            }
+        }
+        return best;
+    }
+
+    bool GetMonitorRects(MonitorHandle monitor, Rect& monitorRect, Rect& workArea) noexcept override
+    {
+        m_stats.monitorQueries++;
+        const Monitor* info = FindMonitor(monitor);
+        if (!info)
+        {
+            return false;
+        }
+        monitorRect = info->rect;
+        workArea = info->workArea;
+        return true;
+    }
+
+    unsigned MonitorDpi(MonitorHandle monitor) noexcept override
+    {
+        m_stats.monitorQueries++;
+        const Monitor* info = FindMonitor(monitor);
+        return info ? info->dpi : 96;
+    }
+
+    bool MonitorDeviceId(MonitorHandle monitor, std::wstring& deviceId) noexcept override
+    {
+        m_stats.monitorQueries++;
+        const Monitor* info = FindMonitor(monitor);
+        if (!info || info->mirroring)
+        {
+            return false;
+        }
+        deviceId = info->deviceId.empty() ? L"\\\\?\\DISPLAY#MEMORY" + std::to_wstring(reinterpret_cast<uintptr_t>(monitor)) + L"#" : info->deviceId;
+        return true;
+    }
+
+    bool GetCurrentDesktop(DesktopId& desktop) noexcept override
+    {
+        m_stats.desktopQueries++;
+        desktop = ToDesktopId(m_currentDesktop);
+        return true;
+    }
+
+    bool GetDesktops(std::vector<DesktopId>& desktops) noexcept override
+    {
+        m_stats.desktopQueries++;
+        for (size_t i = 0; i < m_desktopCount; i++)
+        {
+            desktops.push_back(ToDesktopId(i));
+        }
+        return true;
+    }
+
+private:
+    static MonitorHandle ToMonitor(size_t index) noexcept
+    {
+        return reinterpret_cast<MonitorHandle>(index + 1);
+    }
+
+    const Monitor* FindMonitor(MonitorHandle monitor) const noexcept
+    {
+        const auto index = reinterpret_cast<uintptr_t>(monitor);
+        return index > 0 && index <= m_monitors.size() ? &m_monitors[index - 1] : nullptr;
+    }
+
+    static DesktopId ToDesktopId(size_t index) noexcept
+    {
+        DesktopId id{};
+        id.Data1 = static_cast<uint32_t>(index + 1);
+        return id;
+    }
+
+    static int64_t IntersectionArea(const Rect& a, const Rect& b) noexcept
+    {
+        const int64_t width = static_cast<int64_t>((std::min)(a.right, b.right)) - (std::max)(a.left, b.left);
+        const int64_t height = static_cast<int64_t>((std::min)(a.bottom, b.bottom)) - (std::max)(a.top, b.top);
+        return width > 0 && height > 0 ? width * height : 0;
+    }
+
+    std::unordered_map<WindowHandle, Window> m_windows;
+    std::vector<WindowHandle> m_zOrder; // Topmost first
+    std::vector<Monitor> m_monitors;
+    size_t m_desktopCount{ 1 };
+    size_t m_currentDesktop{};
+    WindowHandle m_foreground{};
+    uintptr_t m_nextWindow{ 1 };
+    Stats m_stats;
+};
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "JsonHelpers.h"
+#include "DeviceIdUtils.h"
 #include "ZoneSet.h"
+#include "MetricsBlock.h"
 
 #include <common/common.h>
 
@@ -8,7 +10,6 @@
 #include <filesystem>
 #include <fstream>
 #include <regex>
-#include <sstream>
 #include <unordered_set>
 
 namespace
@@ -23,14 +24,7 @@ namespace
 
     const wchar_t* FANCY_ZONES_DATA_FILE = L"zones-settings.json";
     const wchar_t* FANCY_ZONES_APP_ZONE_HISTORY_FILE = L"app-zone-history.json";
-    const wchar_t* DEFAULT_GUID = L"{00000000-0000-0000-0000-000000000000}";
     const wchar_t* REG_SETTINGS = L"Software\\FancyTiling";
-
-    std::wstring ExtractVirtualDesktopId(const std::wstring& deviceId)
-    {
-        // Format: <device-id>_<resolution>_<virtual-desktop-id>
-        return deviceId.substr(deviceId.rfind('_') + 1);
-    }
 }
 
 namespace JSONHelpers
@@ -43,74 +37,7 @@ namespace JSONHelpers
 
     bool isValidDeviceId(const std::wstring& str)
     {
-        std::wstring monitorName;
-        std::wstring temp;
-        std::vector<std::wstring> parts;
-        std::wstringstream wss(str);
-
-        /* 
-         Important fix for device info that contains a '_' in the name:
-         1. first search for '#'
-         2. Then split the remaining string by '_' 
-        */
-
-        // Step 1: parse the name until the #, then to the '_'
-        if (str.find(L'#') != std::string::npos)
-        {
-            std::getline(wss, temp, L'#');
-
-            monitorName = temp;
-
-            if (!std::getline(wss, temp, L'_'))
-            {
-                return false;
-            }
-
-            monitorName += L"#" + temp;
-            parts.push_back(monitorName);
-        }
-
-        // Step 2: parse the rest of the id
-        while (std::getline(wss, temp, L'_'))
-        {
-            parts.push_back(temp);
-        }
-
-        if (parts.size() != 4)
-        {
-            return false;
-        }
-
-        /*
-         Refer to ZoneWindowUtils::GenerateUniqueId parts contain:
-         1. monitor id [string]
-         2. width of device [int]
-         3. height of device [int]
-         4. virtual desktop id (GUID) [string]
-        */
-        try
-        {
-            //check if resolution contain only digits
-            for (const auto& c : parts[1])
-            {
-                std::stoi(std::wstring(&c));
-            }
-            for (const auto& c : parts[2])
-            {
-                std::stoi(std::wstring(&c));
-            }
-        }
-        catch (const std::exception&)
-        {
-            return false;
-        }
-
-        if (!isValidGuid(parts[3]) || parts[0].empty())
-        {
-            return false;
-        }
-
-        return true;
+        return DeviceIdUtils::IsValidDeviceId(str, isValidGuid);
     }
 
     json::JsonArray NumVecToJsonArray(const std::vector<int>& vec)
@@ -165,7 +92,7 @@ namespace JSONHelpers
 
     json::JsonObject FancyZonesData::GetPersistFancyZonesJSON()
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Persist);
 
         std::wstring save_file_path = GetPersistFancyZonesJSONPath();
 
@@ -192,23 +119,9 @@ namespace JSONHelpers
         }
     }
 
-    std::optional<DeviceInfoData> FancyZonesData::FindDeviceInfo(const std::wstring& zoneWindowId) const
-    {
-        std::scoped_lock lock{ dataLock };
-        auto it = deviceInfoMap.find(zoneWindowId);
-        return it != end(deviceInfoMap) ? std::optional{ it->second } : std::nullopt;
-    }
-
-    std::optional<CustomZoneSetData> FancyZonesData::FindCustomZoneSet(const std::wstring& guuid) const
-    {
-        std::scoped_lock lock{ dataLock };
-        auto it = customZoneSetsMap.find(guuid);
-        return it != end(customZoneSetsMap) ? std::optional{ it->second } : std::nullopt;
-    }
-
     void FancyZonesData::AddDevice(const std::wstring& deviceId)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         if (!deviceInfoMap.contains(deviceId))
         {
             // Creates default entry in map when ZoneWindow is created
@@ -216,52 +129,7 @@ namespace JSONHelpers
         }
     }
 
-    bool FancyZonesData::RemoveDevicesByVirtualDesktopId(const std::wstring& virtualDesktopId)
-    {
-        std::scoped_lock lock{ dataLock };
-        if (virtualDesktopId == DEFAULT_GUID)
-        {
-            return false;
-        }
-        bool modified{ false };
-        for (auto it = deviceInfoMap.begin(); it != deviceInfoMap.end();)
-        {
-            if (ExtractVirtualDesktopId(it->first) == virtualDesktopId)
-            {
-                it = deviceInfoMap.erase(it);
-                modified = true;
-            }
-            else
-            {
-                ++it;
-            }
-        }
-        return modified;
-    }
-
-    void FancyZonesData::CloneDeviceInfo(const std::wstring& source, const std::wstring& destination)
-    {
-        if (source == destination)
-        {
-            return;
-        }
-        std::scoped_lock lock{ dataLock };
-
-        // The source virtual desktop is deleted, simply ignore it.
-        if (!deviceInfoMap.contains(source))
-        {
-            return;
-        }
-
-        // Clone information from source device if destination device is uninitialized (Blank).
-        auto& destInfo = deviceInfoMap[destination];
-        if (destInfo.activeZoneSet.type == ZoneSetLayoutType::Blank)
-        {
-            destInfo = deviceInfoMap[source];
-        }
-    }
-
-    void FancyZonesData::UpdatePrimaryDesktopData(const std::wstring& desktopId)
+    bool FancyZonesData::UpdatePrimaryDesktopData(const std::wstring& desktopId)
     {
         // Explorer persists current virtual desktop identifier to registry on a per session basis,
         // but only after first virtual desktop switch happens. If the user hasn't switched virtual
@@ -272,14 +140,11 @@ namespace JSONHelpers
         auto replaceDesktopId = [&desktopId](const std::wstring& deviceId) {
             return deviceId.substr(0, deviceId.rfind('_') + 1) + desktopId;
         };
-        std::scoped_lock lock{ dataLock };
-        for (auto& [path, data] : appZoneHistoryMap)
-        {
-            if (ExtractVirtualDesktopId(data.deviceId) == DEFAULT_GUID)
-            {
-                data.deviceId = replaceDesktopId(data.deviceId);
-            }
-        }
+        auto lock = LockData(DataLockSite::Write);
+        bool modified = appZoneHistory.UpdateDeviceIds([&](std::wstring_view deviceId) {
+            const std::wstring id(deviceId);
+            return ExtractVirtualDesktopId(id) == DEFAULT_GUID ? replaceDesktopId(id) : id;
+        });
         std::vector<std::wstring> toReplace{};
         for (const auto& [id, data] : deviceInfoMap)
         {
@@ -298,43 +163,36 @@ namespace JSONHelpers
         {
             activeDeviceId = replaceDesktopId(activeDeviceId);
         }
-        SaveFancyZonesData();
+        return modified || !toReplace.empty();
     }
 
-    void FancyZonesData::RemoveDeletedDesktops(const std::vector<std::wstring>& activeDesktops)
+    bool FancyZonesData::RemoveDeletedDesktops(const std::vector<std::wstring>& activeDesktops)
     {
         std::unordered_set<std::wstring> active(std::begin(activeDesktops), std::end(activeDesktops));
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
+        bool modified{ false };
         for (auto it = std::begin(deviceInfoMap); it != std::end(deviceInfoMap);)
         {
             auto foundId = active.find(ExtractVirtualDesktopId(it->first));
             if (foundId == std::end(active))
             {
                 it = deviceInfoMap.erase(it);
+                modified = true;
             }
             else
             {
                 ++it;
             }
         }
-        SaveFancyZonesData();
+        return modified;
     }
 
     std::vector<int> FancyZonesData::GetAppLastZoneIndexSet(HWND window, const std::wstring_view& deviceId, const std::wstring_view& zoneSetId) const
     {
-        std::scoped_lock lock{ dataLock };
         auto processPath = get_process_path(window);
         if (!processPath.empty())
         {
-            auto history = appZoneHistoryMap.find(processPath);
-            if (history != appZoneHistoryMap.end())
-            {
-                const auto& data = history->second;
-                if (data.zoneSetUuid == zoneSetId && data.deviceId == deviceId)
-                {
-                    return history->second.zoneIndexSet;
-                }
-            }
+            return Store::GetAppLastZoneIndexSet(processPath, deviceId, zoneSetId);
         }
 
         return {};
@@ -342,20 +200,16 @@ namespace JSONHelpers
 
     bool FancyZonesData::RemoveAppLastZone(HWND window, const std::wstring_view& deviceId, const std::wstring_view& zoneSetId)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         auto processPath = get_process_path(window);
         if (!processPath.empty())
         {
-            auto history = appZoneHistoryMap.find(processPath);
-            if (history != appZoneHistoryMap.end())
+            const auto history = appZoneHistory.Find(processPath);
+            if (history && appZoneHistory.ZoneSetUuid(*history) == zoneSetId && appZoneHistory.DeviceId(*history) == deviceId)
             {
-                const auto& data = history->second;
-                if (data.zoneSetUuid == zoneSetId && data.deviceId == deviceId)
-                {
-                    appZoneHistoryMap.erase(processPath);
-                    SaveFancyZonesData();
-                    return true;
-                }
+                appZoneHistory.Erase(processPath);
+                SaveFancyZonesData();
+                return true;
             }
         }
 
@@ -364,21 +218,19 @@ namespace JSONHelpers
 
     bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId, const std::wstring& zoneSetId, const std::vector<int>& zoneIndexSet)
     {
-        std::scoped_lock lock{ dataLock };
         auto processPath = get_process_path(window);
         if (processPath.empty())
         {
             return false;
         }
 
-        appZoneHistoryMap[processPath] = AppZoneHistoryData{ .zoneSetUuid = zoneSetId, .deviceId = deviceId, .zoneIndexSet = zoneIndexSet };
-        SaveFancyZonesData();
+        Store::SetAppLastZones(processPath, deviceId, zoneSetId, zoneIndexSet);
         return true;
     }
 
     void FancyZonesData::SetActiveZoneSet(const std::wstring& deviceId, const ZoneSetData& data)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         auto it = deviceInfoMap.find(deviceId);
         if (it != deviceInfoMap.end())
         {
@@ -388,14 +240,14 @@ namespace JSONHelpers
 
     void FancyZonesData::SerializeDeviceInfoToTmpFile(const DeviceInfoJSON& deviceInfo, std::wstring_view tmpFilePath) const
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Persist);
         json::JsonObject deviceInfoJson = DeviceInfoJSON::ToJson(deviceInfo);
         json::to_file(tmpFilePath, deviceInfoJson);
     }
 
     void FancyZonesData::ParseDeviceInfoFromTmpFile(std::wstring_view tmpFilePath)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         if (std::filesystem::exists(tmpFilePath))
         {
             if (auto zoneSetJson = json::from_file(tmpFilePath); zoneSetJson.has_value())
@@ -416,7 +268,7 @@ namespace JSONHelpers
 
     bool FancyZonesData::ParseCustomZoneSetFromTmpFile(std::wstring_view tmpFilePath)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         bool res = true;
         if (std::filesystem::exists(tmpFilePath))
         {
@@ -442,7 +294,7 @@ namespace JSONHelpers
 
     bool FancyZonesData::ParseDeletedCustomZoneSetsFromTmpFile(std::wstring_view tmpFilePath)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         bool res = true;
         if (std::filesystem::exists(tmpFilePath))
         {
@@ -469,7 +321,7 @@ namespace JSONHelpers
 
     bool FancyZonesData::ParseAppZoneHistory(const json::JsonObject& fancyZonesDataJSON)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         try
         {
             auto appLastZones = fancyZonesDataJSON.GetNamedArray(L"app-zone-history");
@@ -477,9 +329,11 @@ namespace JSONHelpers
             for (uint32_t i = 0; i < appLastZones.Size(); ++i)
             {
                 json::JsonObject appLastZone = appLastZones.GetObjectAt(i);
-                if (auto appZoneHistory = AppZoneHistoryJSON::FromJson(appLastZone); appZoneHistory.has_value())
+                if (auto appLastZoneData = AppZoneHistoryJSON::FromJson(appLastZone); appLastZoneData.has_value())
                 {
-                    appZoneHistoryMap[appZoneHistory->appPath] = std::move(appZoneHistory->data);
+                    // Written least recently used first, so the history comes back in the same order
+                    const auto& data = appLastZoneData->data;
+                    appZoneHistory.Set(appLastZoneData->appPath, data.zoneSetUuid, data.deviceId, data.zoneIndexSet);
                 }
                 else
                 {
@@ -497,20 +351,20 @@ namespace JSONHelpers
 
     json::JsonArray FancyZonesData::SerializeAppZoneHistory() const
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Read);
         json::JsonArray appHistoryArray;
 
-        for (const auto& [appPath, appZoneHistoryData] : appZoneHistoryMap)
-        {
-            appHistoryArray.Append(AppZoneHistoryJSON::ToJson(AppZoneHistoryJSON{ appPath, appZoneHistoryData }));
-        }
+        appZoneHistory.ForEach([&](std::wstring appPath, std::wstring_view zoneSetUuid, std::wstring_view deviceId, const std::vector<int>& zoneIndexSet) {
+            const AppZoneHistoryData data{ .zoneSetUuid = std::wstring(zoneSetUuid), .deviceId = std::wstring(deviceId), .zoneIndexSet = zoneIndexSet };
+            appHistoryArray.Append(AppZoneHistoryJSON::ToJson(AppZoneHistoryJSON{ std::move(appPath), data }));
+        });
 
         return appHistoryArray;
     }
 
     bool FancyZonesData::ParseDeviceInfos(const json::JsonObject& fancyZonesDataJSON)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         try
         {
             auto devices = fancyZonesDataJSON.GetNamedArray(L"devices");
@@ -537,7 +391,7 @@ namespace JSONHelpers
 
     json::JsonArray FancyZonesData::SerializeDeviceInfos() const
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Read);
         json::JsonArray DeviceInfosJSON{};
 
         for (const auto& [deviceID, deviceData] : deviceInfoMap)
@@ -553,7 +407,7 @@ namespace JSONHelpers
 
     bool FancyZonesData::ParseCustomZoneSets(const json::JsonObject& fancyZonesDataJSON)
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Write);
         try
         {
             auto customZoneSets = fancyZonesDataJSON.GetNamedArray(L"custom-zone-sets");
@@ -576,7 +430,7 @@ namespace JSONHelpers
 
     json::JsonArray FancyZonesData::SerializeCustomZoneSets() const
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Read);
         json::JsonArray customZoneSetsJSON{};
 
         for (const auto& [zoneSetId, zoneSetData] : customZoneSetsMap)
@@ -589,7 +443,7 @@ namespace JSONHelpers
 
     void FancyZonesData::CustomZoneSetsToJsonFile(std::wstring_view filePath) const
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Persist);
         const auto& customZoneSetsJson = SerializeCustomZoneSets();
         json::JsonObject root{};
         root.SetNamedValue(L"custom-zone-sets", customZoneSetsJson);
@@ -598,7 +452,7 @@ namespace JSONHelpers
 
     void FancyZonesData::LoadFancyZonesData()
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Persist);
         std::wstring jsonFilePath = GetPersistFancyZonesJSONPath();
 
         if (!std::filesystem::exists(jsonFilePath))
@@ -619,7 +473,7 @@ namespace JSONHelpers
 
     void FancyZonesData::SaveFancyZonesData() const
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Persist);
         json::JsonObject root{};
         json::JsonObject appZoneHistoryRoot{};
 
@@ -631,11 +485,67 @@ namespace JSONHelpers
 
         json::to_file(jsonFilePath, root);
         json::to_file(appZoneHistoryFilePath, appZoneHistoryRoot);
+
+        uint64_t bytesSaved = 0;
+        for (const auto& path : { std::wstring_view{ jsonFilePath }, std::wstring_view{ appZoneHistoryFilePath } })
+        {
+            std::error_code error;
+            const auto size = std::filesystem::file_size(path, error);
+            bytesSaved += error ? 0 : size;
+        }
+        Metrics::Add(Metrics::Counter::DataSaves);
+        Metrics::Add(Metrics::Counter::DataBytesSaved, bytesSaved);
+    }
+
+    std::array<FancyZonesData::SectionFootprint, 3> FancyZonesData::GetMemoryFootprint() const
+    {
+        // Hash map node: key, value and a link, plus a bucket pointer per bucket
+        const auto mapBytes = [](const auto& map) {
+            using Node = typename std::remove_reference_t<decltype(map)>::value_type;
+            size_t bytes = map.bucket_count() * sizeof(void*) + map.size() * (sizeof(Node) + sizeof(void*));
+            for (const auto& [key, value] : map)
+            {
+                bytes += StringPool::StringBytes(key);
+            }
+            return bytes;
+        };
+
+        auto lock = LockData(DataLockSite::Read);
+        size_t deviceInfoBytes = mapBytes(deviceInfoMap);
+        for (const auto& [id, data] : deviceInfoMap)
+        {
+            deviceInfoBytes += StringPool::StringBytes(data.activeZoneSet.uuid);
+        }
+
+        size_t customZoneSetsBytes = mapBytes(customZoneSetsMap);
+        for (const auto& [id, data] : customZoneSetsMap)
+        {
+            customZoneSetsBytes += StringPool::StringBytes(data.name);
+            if (const auto canvas = std::get_if<CanvasLayoutInfo>(&data.info))
+            {
+                customZoneSetsBytes += canvas->zones.capacity() * sizeof(CanvasLayoutInfo::Rect);
+            }
+            else if (const auto grid = std::get_if<GridLayoutInfo>(&data.info))
+            {
+                customZoneSetsBytes += (grid->rowsPercents().capacity() + grid->columnsPercents().capacity()) * sizeof(int);
+                customZoneSetsBytes += grid->cellChildMap().capacity() * sizeof(std::vector<int>);
+                for (const auto& row : grid->cellChildMap())
+                {
+                    customZoneSetsBytes += row.capacity() * sizeof(int);
+                }
+            }
+        }
+
+        return { {
+            { L"app-zone-history", appZoneHistory.Size(), appZoneHistory.Bytes() },
+            { L"devices", deviceInfoMap.size(), deviceInfoBytes },
+            { L"custom-zone-sets", customZoneSetsMap.size(), customZoneSetsBytes },
+        } };
     }
 
     void FancyZonesData::MigrateCustomZoneSetsFromRegistry()
     {
-        std::scoped_lock lock{ dataLock };
+        auto lock = LockData(DataLockSite::Persist);
         wchar_t key[256];
         StringCchPrintf(key, ARRAYSIZE(key), L"%s\\%s", REG_SETTINGS, L"Layouts");
         HKEY hkey;
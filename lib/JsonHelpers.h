@@ -4,6 +4,9 @@
 #include <common/json.h>
 #include <mutex>
 
+#include "FancyZonesDataStore.h"
+
+#include <array>
 #include <string>
 #include <strsafe.h>
 #include <unordered_map>
@@ -163,9 +166,9 @@ namespace JSONHelpers
         static std::optional<DeviceInfoJSON> FromJson(const json::JsonObject& device);
     };
 
-    class FancyZonesData
+    class FancyZonesData : public FancyZonesDataStore<DeviceInfoData, CustomZoneSetData>
     {
-        mutable std::recursive_mutex dataLock;
+        using Store = FancyZonesDataStore<DeviceInfoData, CustomZoneSetData>;
 
     public:
         FancyZonesData();
@@ -182,38 +185,50 @@ namespace JSONHelpers
 
         json::JsonObject GetPersistFancyZonesJSON();
 
-        std::optional<DeviceInfoData> FindDeviceInfo(const std::wstring& zoneWindowId) const;
-
-        std::optional<CustomZoneSetData> FindCustomZoneSet(const std::wstring& guuid) const;
-
         inline const std::wstring GetActiveDeviceId() const
         {
-            std::scoped_lock lock{ dataLock };
+            auto lock = LockData(DataLockSite::Read);
             return activeDeviceId;
         }
 
         inline const std::unordered_map<std::wstring, DeviceInfoData>& GetDeviceInfoMap() const
         {
-            std::scoped_lock lock{ dataLock };
+            auto lock = LockData(DataLockSite::Read);
             return deviceInfoMap;
         }
 
         inline const std::unordered_map<std::wstring, CustomZoneSetData>& GetCustomZoneSetsMap() const
         {
-            std::scoped_lock lock{ dataLock };
+            auto lock = LockData(DataLockSite::Read);
             return customZoneSetsMap;
         }
 
-        inline const std::unordered_map<std::wstring, AppZoneHistoryData>& GetAppZoneHistoryMap() const
+        inline const AppZoneHistory& GetAppZoneHistory() const
+        {
+            auto lock = LockData(DataLockSite::Read);
+            return appZoneHistory;
+        }
+
+        // Applications beyond the capacity are forgotten, least recently used first.
+        inline void SetAppZoneHistoryCapacity(size_t capacity)
         {
-            std::scoped_lock lock{ dataLock };
-            return appZoneHistoryMap;
+            auto lock = LockData(DataLockSite::Write);
+            appZoneHistory.SetCapacity(capacity);
         }
 
+        struct SectionFootprint
+        {
+            const wchar_t* name;
+            size_t entries;
+            size_t bytes; // Estimate of the heap memory used
+        };
+
+        std::array<SectionFootprint, 3> GetMemoryFootprint() const;
+
 #if defined(UNIT_TESTS)
         inline void clear_data()
         {
-            appZoneHistoryMap.clear();
+            appZoneHistory.Clear();
             deviceInfoMap.clear();
             customZoneSetsMap.clear();
             activeDeviceId.clear();
@@ -227,7 +242,7 @@ namespace JSONHelpers
 
         inline void SetActiveDeviceId(const std::wstring& deviceId)
         {
-            std::scoped_lock lock{ dataLock };
+            auto lock = LockData(DataLockSite::Write);
             activeDeviceId = deviceId;
         }
 
@@ -237,10 +252,9 @@ namespace JSONHelpers
         }
 
         void AddDevice(const std::wstring& deviceId);
-        bool RemoveDevicesByVirtualDesktopId(const std::wstring& virtualDesktopId);
-        void CloneDeviceInfo(const std::wstring& source, const std::wstring& destination);
-        void UpdatePrimaryDesktopData(const std::wstring& desktopId);
-        void RemoveDeletedDesktops(const std::vector<std::wstring>& activeDesktops);
+        // Following return true if persisted data was modified, saving it is left to the caller.
+        bool UpdatePrimaryDesktopData(const std::wstring& desktopId);
+        bool RemoveDeletedDesktops(const std::vector<std::wstring>& activeDesktops);
 
         std::vector<int> GetAppLastZoneIndexSet(HWND window, const std::wstring_view& deviceId, const std::wstring_view& zoneSetId) const;
         bool RemoveAppLastZone(HWND window, const std::wstring_view& deviceId, const std::wstring_view& zoneSetId);
@@ -263,15 +277,11 @@ namespace JSONHelpers
         void CustomZoneSetsToJsonFile(std::wstring_view filePath) const;
 
         void LoadFancyZonesData();
-        void SaveFancyZonesData() const;
+        void SaveFancyZonesData() const override;
 
     private:
         void MigrateCustomZoneSetsFromRegistry();
 
-        std::unordered_map<std::wstring, AppZoneHistoryData> appZoneHistoryMap{};
-        std::unordered_map<std::wstring, DeviceInfoData> deviceInfoMap{};
-        std::unordered_map<std::wstring, CustomZoneSetData> customZoneSetsMap{};
-
         std::wstring activeDeviceId;
         std::wstring jsonFilePath;
         std::wstring appZoneHistoryFilePath;
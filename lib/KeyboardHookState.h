@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+
+// Keyboard hook decision logic. Modifier state is tracked from the hook's own key down / key up
+// stream instead of querying the system on every key press, and the action for a key is a single
+// lookup in a table indexed by the modifier combination and virtual key code.
+namespace KeyboardHook
+{
+    // Virtual key codes, same values as the VK_* constants in WinUser.h.
+    namespace VirtualKey
+    {
+        constexpr uint32_t Shift = 0x10;
+        constexpr uint32_t Control = 0x11;
+        constexpr uint32_t Menu = 0x12;
+        constexpr uint32_t Left = 0x25;
+        constexpr uint32_t Up = 0x26;
+        constexpr uint32_t Right = 0x27;
+        constexpr uint32_t Down = 0x28;
+        constexpr uint32_t LWin = 0x5B;
+        constexpr uint32_t RWin = 0x5C;
+        constexpr uint32_t LShift = 0xA0;
+        constexpr uint32_t RShift = 0xA1;
+        constexpr uint32_t LControl = 0xA2;
+        constexpr uint32_t RControl = 0xA3;
+        constexpr uint32_t LMenu = 0xA4;
+        constexpr uint32_t RMenu = 0xA5;
+    }
+
+    enum Modifier : uint8_t
+    {
+        None = 0,
+        Win = 1 << 0,
+        Shift = 1 << 1,
+        Ctrl = 1 << 2,
+        Alt = 1 << 3,
+    };
+
+    constexpr uint8_t MODIFIER_COMBINATIONS = 16;
+    constexpr uint32_t KEY_COUNT = 256;
+
+    enum class KeyAction : uint8_t
+    {
+        PassThrough = 0,
+        Swallow,
+        Snap,
+        MainZoneWidth,
+        MoveToVirtualDesktop,
+        SwitchToVirtualDesktop,
+    };
+
+    class ModifierState
+    {
+    public:
+        // Returns true if the key is a modifier, in which case it never maps to an action.
+        bool Update(uint32_t vkCode, bool down) noexcept
+        {
+            const uint16_t key = KeyBit(vkCode);
+            if (key == 0)
+            {
+                return false;
+            }
+
+            m_keys = down ? (m_keys | key) : (m_keys & ~key);
+            return true;
+        }
+
+        static bool IsModifier(uint32_t vkCode) noexcept
+        {
+            return KeyBit(vkCode) != 0;
+        }
+
+        uint8_t Mask() const noexcept
+        {
+            uint8_t mask = Modifier::None;
+            mask |= (m_keys & (LeftWin | RightWin)) ? Modifier::Win : 0;
+            mask |= (m_keys & (LeftShift | RightShift)) ? Modifier::Shift : 0;
+            mask |= (m_keys & (LeftCtrl | RightCtrl)) ? Modifier::Ctrl : 0;
+            mask |= (m_keys & (LeftAlt | RightAlt)) ? Modifier::Alt : 0;
+            return mask;
+        }
+
+        // Overwrite tracked state with the actual one, when key transitions were missed.
+        void Resync(uint8_t mask) noexcept
+        {
+            m_keys = 0;
+            m_keys |= (mask & Modifier::Win) ? LeftWin : 0;
+            m_keys |= (mask & Modifier::Shift) ? LeftShift : 0;
+            m_keys |= (mask & Modifier::Ctrl) ? LeftCtrl : 0;
+            m_keys |= (mask & Modifier::Alt) ? LeftAlt : 0;
+        }
+
+    private:
+        enum Key : uint16_t
+        {
+            LeftWin = 1 << 0,
+            RightWin = 1 << 1,
+            LeftShift = 1 << 2,
+            RightShift = 1 << 3,
+            LeftCtrl = 1 << 4,
+            RightCtrl = 1 << 5,
+            LeftAlt = 1 << 6,
+            RightAlt = 1 << 7,
+        };
+
+        static uint16_t KeyBit(uint32_t vkCode) noexcept
+        {
+            switch (vkCode)
+            {
+            case VirtualKey::LWin:
+                return LeftWin;
+            case VirtualKey::RWin:
+                return RightWin;
+            case VirtualKey::Shift: // Injected input may use the side-less codes
+            case VirtualKey::LShift:
+                return LeftShift;
+            case VirtualKey::RShift:
+                return RightShift;
+            case VirtualKey::Control:
+            case VirtualKey::LControl:
+                return LeftCtrl;
+            case VirtualKey::RControl:
+                return RightCtrl;
+            case VirtualKey::Menu:
+            case VirtualKey::LMenu:
+                return LeftAlt;
+            case VirtualKey::RMenu:
+                return RightAlt;
+            default:
+                return 0;
+            }
+        }
+
+        uint16_t m_keys{};
+    };
+
+    class ActionTable
+    {
+    public:
+        void Set(uint8_t modifiers, uint32_t vkCode, KeyAction action) noexcept
+        {
+            if (vkCode < KEY_COUNT)
+            {
+                m_actions[modifiers % MODIFIER_COMBINATIONS][vkCode] = action;
+            }
+        }
+
+        KeyAction Lookup(uint8_t modifiers, uint32_t vkCode) const noexcept
+        {
+            return vkCode < KEY_COUNT ? m_actions[modifiers % MODIFIER_COMBINATIONS][vkCode] : KeyAction::PassThrough;
+        }
+
+        // FancyZones hotkeys:
+        //     Win+Left, Win+Up, Win+Down    snap / cycle windows through zones
+        //     Win+Right                     muted
+        //     Win+1..9                      switch to virtual desktop
+        //     Win+Ctrl+1..9                 move foreground window to virtual desktop
+        //     Win+Shift(+Ctrl)+Left/Right   change width of the main zone
+        // Combinations with Alt are left alone: with Alt down keys arrive as WM_SYSKEYDOWN, which the
+        // hotkeys never handled.
+        static ActionTable FancyZonesDefaults() noexcept
+        {
+            ActionTable table;
+            table.Set(Modifier::Win, VirtualKey::Left, KeyAction::Snap);
+            table.Set(Modifier::Win, VirtualKey::Up, KeyAction::Snap);
+            table.Set(Modifier::Win, VirtualKey::Down, KeyAction::Snap);
+            table.Set(Modifier::Win, VirtualKey::Right, KeyAction::Swallow);
+            for (uint32_t vkCode = '1'; vkCode <= '9'; vkCode++)
+            {
+                table.Set(Modifier::Win, vkCode, KeyAction::SwitchToVirtualDesktop);
+                table.Set(Modifier::Win | Modifier::Ctrl, vkCode, KeyAction::MoveToVirtualDesktop);
+            }
+            for (uint8_t modifiers : { Modifier::Win | Modifier::Shift, Modifier::Win | Modifier::Shift | Modifier::Ctrl })
+            {
+                table.Set(modifiers, VirtualKey::Left, KeyAction::MainZoneWidth);
+                table.Set(modifiers, VirtualKey::Right, KeyAction::MainZoneWidth);
+            }
+            return table;
+        }
+
+    private:
+        KeyAction m_actions[MODIFIER_COMBINATIONS][KEY_COUNT]{};
+    };
+}
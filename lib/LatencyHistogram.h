@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear latency histogram. Values below 2^SUB_BUCKET_BITS get a bucket each, every power of
+// two above is split into 2^SUB_BUCKET_BITS linear sub-buckets, which bounds the relative error of
+// any reported value to 1/2^SUB_BUCKET_BITS. Recording is wait-free, so it's safe to use inside
+// hooks and from several threads at once; readers get a consistent enough view without locking.
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 3;
+    static constexpr unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void Record(std::chrono::nanoseconds latency) noexcept
+    {
+        RecordValue(latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0);
+    }
+
+    void RecordValue(uint64_t value) noexcept
+    {
+        m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    uint64_t Count() const noexcept
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Max() const noexcept
+    {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket holding the given percentile (0-100), 0 if nothing was recorded.
+    uint64_t ValueAtPercentile(double percentile) const noexcept
+    {
+        const uint64_t count = Count();
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        const auto target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count) + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target && seen > 0)
+            {
+                const uint64_t upper = BucketLowerBound(i + 1) - 1;
+                return upper < Max() ? upper : Max();
+            }
+        }
+        return Max();
+    }
+
+    // Calls callback(lowerBound, upperBound, count) for every non-empty bucket, in ascending order.
+    template<typename Callback>
+    void ForEachBucket(Callback&& callback) const
+    {
+        for (size_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            const uint64_t count = m_buckets[i].load(std::memory_order_relaxed);
+            if (count != 0)
+            {
+                callback(BucketLowerBound(i), BucketLowerBound(i + 1) - 1, count);
+            }
+        }
+    }
+
+    void Reset() noexcept
+    {
+        for (auto& bucket : m_buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    static constexpr size_t BucketIndex(uint64_t value) noexcept
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return static_cast<size_t>(value);
+        }
+
+        const unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+        const uint64_t subBucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + static_cast<size_t>(subBucket);
+    }
+
+    static constexpr uint64_t BucketLowerBound(size_t index) noexcept
+    {
+        if (index < SUB_BUCKETS)
+        {
+            return index;
+        }
+        if (index >= BUCKET_COUNT)
+        {
+            return UINT64_MAX;
+        }
+
+        const unsigned exponent = static_cast<unsigned>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+        const uint64_t subBucket = index % SUB_BUCKETS;
+        return (SUB_BUCKETS + subBucket) << (exponent - SUB_BUCKET_BITS);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets{};
+    std::atomic<uint64_t> m_count{ 0 };
+    std::atomic<uint64_t> m_max{ 0 };
+};
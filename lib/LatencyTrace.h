@@ -0,0 +1,128 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Latency of hotkey relayouts, per stage:
+//     key down in the keyboard hook -> relayout queued -> taken by the window thread -> snapshot
+//     -> picked up by the layout thread -> computed -> picked up for commit -> windows placed
+//
+// Only built with FANCYZONES_LATENCY_TRACING defined. Otherwise time points are empty and every
+// call is an inline no-op, so instrumented code compiles to what it was without it.
+namespace LatencyTrace
+{
+    enum class Stage : uint8_t
+    {
+        KeyboardHook, // Key down to relayout queued
+        QueueWait, // Relayout queued to taken by the window thread
+        Snapshot, // Capturing windows and zone state
+        LayoutWait, // Snapshot taken to picked up by the layout thread
+        Compute, // Layout model and zone calculation
+        CommitWait, // Layout computed to picked up by the window thread
+        Placement, // Placing a single window
+        EndToEnd, // Oldest key down of a relayout to its last window placed
+        Count
+    };
+
+    inline constexpr const char* STAGE_NAMES[] = {
+        "keyboardHook",
+        "queueWait",
+        "snapshot",
+        "layoutWait",
+        "compute",
+        "commitWait",
+        "placement",
+        "endToEnd",
+    };
+    static_assert(std::size(STAGE_NAMES) == static_cast<size_t>(Stage::Count));
+
+    // Histogram of every stage, recorded into from any thread.
+    class Stages
+    {
+    public:
+        void Record(Stage stage, std::chrono::nanoseconds latency) noexcept
+        {
+            m_histograms[static_cast<size_t>(stage)].Record(latency);
+        }
+
+        const LatencyHistogram& Histogram(Stage stage) const noexcept
+        {
+            return m_histograms[static_cast<size_t>(stage)];
+        }
+
+        void Reset() noexcept
+        {
+            for (auto& histogram : m_histograms)
+            {
+                histogram.Reset();
+            }
+        }
+
+        // {"unit":"ns","stages":[{"name":..,"count":..,"max":..,"p50":..,"p90":..,"p99":..,"p999":..,
+        //  "buckets":[[lowerBound,upperBound,count],..]},..]}
+        void WriteJson(std::ostream& stream) const
+        {
+            stream << "{\"unit\":\"ns\",\"stages\":[";
+            for (size_t i = 0; i < m_histograms.size(); i++)
+            {
+                const auto& histogram = m_histograms[i];
+                stream << (i ? "," : "") << "{\"name\":\"" << STAGE_NAMES[i] << "\""
+                       << ",\"count\":" << histogram.Count()
+                       << ",\"max\":" << histogram.Max()
+                       << ",\"p50\":" << histogram.ValueAtPercentile(50)
+                       << ",\"p90\":" << histogram.ValueAtPercentile(90)
+                       << ",\"p99\":" << histogram.ValueAtPercentile(99)
+                       << ",\"p999\":" << histogram.ValueAtPercentile(99.9)
+                       << ",\"buckets\":[";
+                bool first = true;
+                histogram.ForEachBucket([&](uint64_t lowerBound, uint64_t upperBound, uint64_t count) {
+                    stream << (first ? "" : ",") << "[" << lowerBound << "," << upperBound << "," << count << "]";
+                    first = false;
+                });
+                stream << "]}";
+            }
+            stream << "]}";
+        }
+
+    private:
+        std::array<LatencyHistogram, static_cast<size_t>(Stage::Count)> m_histograms;
+    };
+
+#if defined(FANCYZONES_LATENCY_TRACING)
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    inline TimePoint Now() noexcept
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    inline Stages& Global() noexcept
+    {
+        static Stages stages;
+        return stages;
+    }
+
+    inline void Record(Stage stage, TimePoint start, TimePoint end) noexcept
+    {
+        Global().Record(stage, end - start);
+    }
+#else
+    struct TimePoint
+    {
+    };
+
+    inline TimePoint Now() noexcept
+    {
+        return {};
+    }
+
+    inline void Record(Stage, TimePoint, TimePoint) noexcept
+    {
+    }
+#endif
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "KeyboardHookState.h"
+#include "LatencyTrace.h"
+#include "PlacementOperation.h"
+#include "Platform.h"
+#include "RelayoutRequests.h"
+#include "ZoneSetUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// Hotkey and window-created relayouts run in three stages:
+//   1. snapshot - the FancyZones window thread captures windows, monitor and zone set state,
+//   2. compute  - the layout worker advances the layout model and calculates zone rects,
+//   3. commit   - the window thread places windows through the placement layer, unless a newer
+//                 relayout was requested in the meantime.
+// The window thread only runs the first and last stage, so it keeps draining hook events while
+// the layout is computed. Snapshots and results are swapped between the threads rather than
+// made anew, so once their vectors have grown a relayout on an unchanged desktop doesn't allocate.
+// The model only sees platform types, so it runs against InMemoryPlatform too.
+namespace Layout
+{
+    using Platform::MonitorHandle;
+    using Platform::Rect;
+    using Platform::WindowHandle;
+
+    // Input of a relayout, not modified once it's handed to the layout worker.
+    struct Snapshot
+    {
+        uint64_t generation{};
+        std::chrono::steady_clock::time_point takenAt{};
+        LatencyTrace::TimePoint submittedAt{};
+        std::vector<Relayout::Request> requests;
+
+        MonitorHandle monitor{}; // Monitor of the foreground window
+        Rect workArea{};
+        WindowHandle foregroundWindow{};
+        bool cycleAcrossMonitors{}; // moveWindowAcrossMonitors is on and there are other monitors
+
+        std::vector<WindowHandle> windows; // Interesting windows, in z-order. Only taken when requests contain a snap.
+        std::vector<int> zoneIndices; // Zone of each window in the active zone set, -1 if not assigned
+        int zoneCount{}; // Zones in the active zone set
+        int mainZoneWidth{}; // Main zone width of the active zone set
+    };
+
+    struct Result
+    {
+        uint64_t generation{};
+        std::chrono::steady_clock::time_point snapshotTakenAt{};
+        LatencyTrace::TimePoint computedAt{};
+        PlacementOperation operation{ PlacementOperation::Other };
+
+        MonitorHandle monitor{}; // Zone set to update and to place windows in
+        bool placeOnWindowMonitor{}; // Place every window in the zone set of its own monitor instead
+        std::vector<WindowHandle> order; // Window assigned to each zone
+
+        bool zonesChanged{};
+        std::vector<Rect> zones; // Relative to the work area, valid when zonesChanged
+        int mainZoneWidth{};
+
+        bool activateFirst{}; // Bring window in the main zone to the foreground
+
+        // Moves of the foreground window to the zone on its left, on any monitor. Other monitors'
+        // zones aren't in the snapshot, the window thread looks them up.
+        WindowHandle movedWindow{};
+        uint32_t moveSteps{};
+    };
+
+    // Layout state carried from one relayout to the next. It's only touched by the layout worker, so
+    // relayouts which are computed but never committed (superseded) still advance it.
+    class Model
+    {
+    public:
+        // Overwrites every field of result, reusing its buffers.
+        void Compute(const Snapshot& snapshot, Result& result)
+        {
+            result.generation = snapshot.generation;
+            result.snapshotTakenAt = snapshot.takenAt;
+            result.operation = PlacementOperation::Other;
+            result.monitor = snapshot.monitor;
+            result.placeOnWindowMonitor = false;
+            result.activateFirst = false;
+            result.movedWindow = nullptr;
+            result.moveSteps = 0;
+
+            auto mainZoneWidth = m_mainZoneWidth.try_emplace(snapshot.monitor, snapshot.mainZoneWidth).first;
+            int zoneCount = snapshot.zoneCount;
+            bool recalculate = false;
+
+            // Every request advances the model, the last one decides how windows are placed
+            for (const auto& request : snapshot.requests)
+            {
+                result.placeOnWindowMonitor = false;
+                result.activateFirst = false;
+                result.moveSteps = 0;
+                if (request.kind == Relayout::RequestKind::MainZoneWidth)
+                {
+                    for (uint32_t step = 0; step < request.repeat; step++)
+                    {
+                        mainZoneWidth->second = ZoneSetUtils::ChangeMainZoneWidth(mainZoneWidth->second, request.vkCode == KeyboardHook::VirtualKey::Right);
+                    }
+                    zoneCount = static_cast<int>(m_order.size());
+                    recalculate = true;
+                    result.operation = PlacementOperation::WidthChange;
+                }
+                else if (request.vkCode == KeyboardHook::VirtualKey::Left && snapshot.cycleAcrossMonitors)
+                {
+                    result.operation = PlacementOperation::Settle;
+                    result.movedWindow = snapshot.foregroundWindow;
+                    result.moveSteps = request.repeat;
+                }
+                else if (request.vkCode == KeyboardHook::VirtualKey::Left)
+                {
+                    BringToFront(snapshot.foregroundWindow);
+                    result.operation = PlacementOperation::Settle;
+                    result.placeOnWindowMonitor = true;
+                }
+                else
+                {
+                    Cycle(snapshot, request, zoneCount, recalculate, result);
+                }
+            }
+
+            result.order = m_order;
+            result.mainZoneWidth = mainZoneWidth->second;
+
+            // Width differs from the zone set's if the relayout which changed it was superseded
+            result.zonesChanged = recalculate || mainZoneWidth->second != snapshot.mainZoneWidth;
+            const int width = snapshot.workArea.right - snapshot.workArea.left;
+            const int height = snapshot.workArea.bottom - snapshot.workArea.top;
+            result.zones.clear();
+            if (result.zonesChanged && zoneCount > 0 && width != 0 && height != 0)
+            {
+                ZoneSetUtils::CalculateMainZoneLayout(width, height, zoneCount, 0, mainZoneWidth->second, result.zones);
+            }
+        }
+
+    private:
+        static int NextIndex(uint32_t vkCode, int oldIndex, int numZones) noexcept
+        {
+            // Number of zones may have shrunk since the window was placed
+            oldIndex = std::clamp(oldIndex, 0, numZones - 1);
+            if ((vkCode == KeyboardHook::VirtualKey::Up && oldIndex == 0) || (vkCode != KeyboardHook::VirtualKey::Up && oldIndex == numZones - 1))
+            {
+                return vkCode == KeyboardHook::VirtualKey::Up ? numZones - 1 : 0;
+            }
+
+            // We didn't reach the edge
+            if (vkCode == KeyboardHook::VirtualKey::Up)
+            {
+                return oldIndex - 1;
+            }
+
+            return oldIndex + 1;
+        }
+
+        void Cycle(const Snapshot& snapshot, const Relayout::Request& request, int& zoneCount, bool& recalculate, Result& result)
+        {
+            const uint32_t vkCode = request.vkCode;
+            const int numHwnds = static_cast<int>(snapshot.windows.size());
+            if (numHwnds != zoneCount)
+            {
+                zoneCount = numHwnds;
+                recalculate = true;
+            }
+            else if (vkCode == 0)
+            {
+                // Same windows as before, settle them into their zones
+                result.operation = PlacementOperation::Settle;
+                result.placeOnWindowMonitor = true;
+                return;
+            }
+
+            result.operation = PlacementOperation::Cycle;
+            if (zoneCount == 0)
+            {
+                m_order.clear();
+                return;
+            }
+
+            // The model knows about relayouts which were computed but never placed, the zone set doesn't
+            auto& indices = m_indices;
+            indices.assign(numHwnds, -1);
+            for (int i = 0; i < numHwnds; i++)
+            {
+                auto it = std::find(m_order.begin(), m_order.end(), snapshot.windows[i]);
+                indices[i] = it != m_order.end() ? static_cast<int>(std::distance(m_order.begin(), it)) : snapshot.zoneIndices[i];
+            }
+
+            // Auto-repeated presses are merged into one request, cycle once per press but place windows once
+            const uint32_t steps = vkCode == 0 ? 1 : request.repeat;
+            for (uint32_t step = 0; step < steps; step++)
+            {
+                m_order.assign(zoneCount, nullptr);
+                for (int i = 0; i < numHwnds; i++)
+                {
+                    int index = 0;
+                    if (indices[i] != -1)
+                    {
+                        index = NextIndex(vkCode, indices[i], zoneCount);
+                    }
+
+                    while (m_order[index] != nullptr)
+                    {
+                        index = NextIndex(vkCode, index, zoneCount);
+                    }
+                    m_order[index] = snapshot.windows[i];
+                    indices[i] = index;
+                }
+            }
+
+            result.activateFirst = true;
+        }
+
+        void BringToFront(WindowHandle window) noexcept
+        {
+            auto it = std::find(m_order.begin(), m_order.end(), window);
+            if (it != m_order.end())
+            {
+                std::iter_swap(m_order.begin(), it);
+            }
+        }
+
+        std::vector<WindowHandle> m_order; // Window assigned to each zone, index 0 is the main zone
+        std::vector<int> m_indices; // Zone of each snapshot window while cycling, kept for its buffer
+        std::map<MonitorHandle, int> m_mainZoneWidth;
+    };
+}
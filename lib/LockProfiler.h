@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+// Contention counters of a single place in code which takes a lock.
+struct LockSiteStats
+{
+    std::atomic<uint64_t> acquisitions{ 0 };
+    std::atomic<uint64_t> contended{ 0 }; // Acquisitions which had to wait for the lock
+    std::atomic<uint64_t> waitNs{ 0 };
+    std::atomic<uint64_t> holdNs{ 0 };
+    std::atomic<uint64_t> maxWaitNs{ 0 };
+    std::atomic<uint64_t> maxHoldNs{ 0 };
+
+    void RecordWait(std::chrono::nanoseconds wait) noexcept
+    {
+        contended.fetch_add(1, std::memory_order_relaxed);
+        Add(waitNs, maxWaitNs, wait);
+    }
+
+    void RecordHold(std::chrono::nanoseconds hold) noexcept
+    {
+        acquisitions.fetch_add(1, std::memory_order_relaxed);
+        Add(holdNs, maxHoldNs, hold);
+    }
+
+private:
+    static void Add(std::atomic<uint64_t>& total, std::atomic<uint64_t>& max, std::chrono::nanoseconds duration) noexcept
+    {
+        const uint64_t value = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+        total.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t current = max.load(std::memory_order_relaxed);
+        while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+};
+
+// std::unique_lock / std::shared_lock which records how long it waited for and held the mutex.
+// Uncontended acquisitions only cost a try-lock and two clock reads.
+template<typename Lock>
+class ProfiledLock : public Lock
+{
+public:
+    using mutex_type = typename Lock::mutex_type;
+
+    ProfiledLock(mutex_type& mutex, LockSiteStats& stats) noexcept :
+        Lock(mutex, std::try_to_lock),
+        m_stats(stats)
+    {
+        if (!this->owns_lock())
+        {
+            const auto start = std::chrono::steady_clock::now();
+            Lock::lock();
+            m_acquired = std::chrono::steady_clock::now();
+            m_stats.RecordWait(m_acquired - start);
+        }
+        else
+        {
+            m_acquired = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ProfiledLock()
+    {
+        if (this->owns_lock())
+        {
+            m_stats.RecordHold(std::chrono::steady_clock::now() - m_acquired);
+        }
+    }
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    void unlock()
+    {
+        m_stats.RecordHold(std::chrono::steady_clock::now() - m_acquired);
+        Lock::unlock();
+    }
+
+private:
+    LockSiteStats& m_stats;
+    std::chrono::steady_clock::time_point m_acquired{};
+};
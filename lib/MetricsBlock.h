@@ -0,0 +1,474 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <ostream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Live counters in a named shared memory region, so tools can watch a running FancyZones without
+// attaching a debugger or asking it anything. Every counter is an independent lock-free 64-bit
+// atomic, writers update them with relaxed ordering and readers copy whatever is there.
+//
+// Layout, native endianness:
+//     Header
+//     uint64_t values[counterCount]
+// Counters are only ever appended, readers use the ones both sides know about. VERSION only
+// changes when the meaning of an existing counter does.
+namespace Metrics
+{
+    enum class Counter : uint32_t
+    {
+        HookEventsReceived,
+        HookEventsCoalesced,
+        HookEventsDropped,
+        HookQueueDepthMax, // Most hook events queued at once, before coalescing
+        RelayoutRequests,
+        Relayouts,
+        RelayoutsSuperseded,
+        RelayoutQueueDepthMax, // Most requests taken at once, after merging
+        PlacementsIssued,
+        PlacementsSkipped, // Window already had the rect
+        DataSaves,
+        DataBytesSaved,
+        ZoneWindowMapHits, // Commits placing with the cached zone window map
+        ZoneWindowMapMisses,
+        DesktopListHits, // Virtual desktop lookups served from the cached list
+        DesktopListMisses,
+        StartupMicros, // Module constructed to zone windows created
+        MonitorTopologyRebuilds,
+        MonitorEnumerations, // Asked from the system, only expected on topology rebuilds
+        MonitorDpiQueries,
+        OtherOperations, // Per placement operation, in PlacementOperation order
+        OtherPlacementsIssued,
+        OtherPlacementsSkipped,
+        SettleOperations,
+        SettlePlacementsIssued,
+        SettlePlacementsSkipped,
+        CycleOperations,
+        CyclePlacementsIssued,
+        CyclePlacementsSkipped,
+        WidthChangeOperations,
+        WidthChangePlacementsIssued,
+        WidthChangePlacementsSkipped,
+        UpdatePositionsOperations,
+        UpdatePositionsPlacementsIssued,
+        UpdatePositionsPlacementsSkipped,
+        PlacementTrackerEntries,
+        RelayoutRequestsDropped, // Relayout ring was full
+        RelayoutRequestsDiscarded, // Taken when the foreground window couldn't be laid out
+        WindowCreatedEvents, // Interesting windows created, held back in bursts
+        WindowCreatedBursts, // Relayouts for them
+        WindowCreatedFolded, // Events which didn't cause a relayout of their own
+        WindowCreatedQuietPeriodMillis, // Current wait for more windows of a burst
+        KeyboardHookEvents,
+        KeyboardHookP99Nanos,
+        KeyboardHookMaxNanos,
+        EventTraceDropped,
+        LockAcquisitions, // FancyZones lock, all sites
+        LockContended,
+        LockWaitNanos,
+        LockMaxWaitNanos,
+        DataLockAcquisitions, // FancyZonesData lock, all sites
+        DataLockContended,
+        DataLockWaitNanos,
+        DataLockMaxWaitNanos,
+        TrackedAllocations, // Only counted when built with allocation tracking
+        TrackedAllocationBytes,
+        DataEntries, // Persisted data held in memory
+        DataBytes, // Estimate of its heap memory
+        StartupDataLoadMicros, // Per startup phase, in Startup::Phase order
+        StartupHooksMicros,
+        StartupDataWaitMicros,
+        StartupWindowMicros,
+        StartupWorkersMicros,
+        StartupZoneWindowsMicros,
+        StartupShellServicesMicros,
+        Count
+    };
+
+    inline constexpr const char* COUNTER_NAMES[] = {
+        "hookEventsReceived",
+        "hookEventsCoalesced",
+        "hookEventsDropped",
+        "hookQueueDepthMax",
+        "relayoutRequests",
+        "relayouts",
+        "relayoutsSuperseded",
+        "relayoutQueueDepthMax",
+        "placementsIssued",
+        "placementsSkipped",
+        "dataSaves",
+        "dataBytesSaved",
+        "zoneWindowMapHits",
+        "zoneWindowMapMisses",
+        "desktopListHits",
+        "desktopListMisses",
+        "startupMicros",
+        "monitorTopologyRebuilds",
+        "monitorEnumerations",
+        "monitorDpiQueries",
+        "otherOperations",
+        "otherPlacementsIssued",
+        "otherPlacementsSkipped",
+        "settleOperations",
+        "settlePlacementsIssued",
+        "settlePlacementsSkipped",
+        "cycleOperations",
+        "cyclePlacementsIssued",
+        "cyclePlacementsSkipped",
+        "widthChangeOperations",
+        "widthChangePlacementsIssued",
+        "widthChangePlacementsSkipped",
+        "updatePositionsOperations",
+        "updatePositionsPlacementsIssued",
+        "updatePositionsPlacementsSkipped",
+        "placementTrackerEntries",
+        "relayoutRequestsDropped",
+        "relayoutRequestsDiscarded",
+        "windowCreatedEvents",
+        "windowCreatedBursts",
+        "windowCreatedFolded",
+        "windowCreatedQuietPeriodMillis",
+        "keyboardHookEvents",
+        "keyboardHookP99Nanos",
+        "keyboardHookMaxNanos",
+        "eventTraceDropped",
+        "lockAcquisitions",
+        "lockContended",
+        "lockWaitNanos",
+        "lockMaxWaitNanos",
+        "dataLockAcquisitions",
+        "dataLockContended",
+        "dataLockWaitNanos",
+        "dataLockMaxWaitNanos",
+        "trackedAllocations",
+        "trackedAllocationBytes",
+        "dataEntries",
+        "dataBytes",
+        "startupDataLoadMicros",
+        "startupHooksMicros",
+        "startupDataWaitMicros",
+        "startupWindowMicros",
+        "startupWorkersMicros",
+        "startupZoneWindowsMicros",
+        "startupShellServicesMicros",
+    };
+    static_assert(std::size(COUNTER_NAMES) == static_cast<size_t>(Counter::Count));
+
+    inline constexpr uint32_t MAGIC = 0x424d5446; // "FTMB"
+    inline constexpr uint32_t VERSION = 1;
+#if defined(_WIN32)
+    inline constexpr wchar_t REGION_NAME[] = L"Local\\FancyTilingMetrics";
+#else
+    inline constexpr char REGION_NAME[] = "/fancytiling-metrics";
+#endif
+
+    struct Header
+    {
+        std::atomic<uint32_t> magic; // Stored last, readers ignore the block until it's set
+        uint32_t version;
+        uint32_t counterCount;
+        uint32_t processId;
+    };
+
+    struct Block
+    {
+        Header header;
+        std::atomic<uint64_t> values[static_cast<size_t>(Counter::Count)];
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free);
+    static_assert(sizeof(Header) == 16 && sizeof(Block) == sizeof(Header) + sizeof(uint64_t) * static_cast<size_t>(Counter::Count));
+
+    // Named shared memory mapping, created read-write by the publisher and opened read-only by readers.
+    // The name goes away when the creating region is closed.
+    class SharedRegion
+    {
+    public:
+        SharedRegion() = default;
+        SharedRegion(const SharedRegion&) = delete;
+        SharedRegion& operator=(const SharedRegion&) = delete;
+
+        ~SharedRegion()
+        {
+            Close();
+        }
+
+        bool Create(size_t size) noexcept
+        {
+            Close();
+#if defined(_WIN32)
+            m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), REGION_NAME);
+            m_data = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+#else
+            const int fd = shm_open(REGION_NAME, O_CREAT | O_RDWR, 0644);
+            if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) == 0)
+            {
+                m_data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                m_data = m_data == MAP_FAILED ? nullptr : m_data;
+            }
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            m_owner = true;
+#endif
+            m_size = size;
+            if (!m_data)
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        bool Open() noexcept
+        {
+            Close();
+#if defined(_WIN32)
+            m_mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, REGION_NAME);
+            m_data = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            MEMORY_BASIC_INFORMATION info{};
+            m_size = m_data && VirtualQuery(m_data, &info, sizeof(info)) ? info.RegionSize : 0;
+#else
+            const int fd = shm_open(REGION_NAME, O_RDONLY, 0);
+            struct stat info{};
+            if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                m_size = static_cast<size_t>(info.st_size);
+                m_data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+                m_data = m_data == MAP_FAILED ? nullptr : m_data;
+            }
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+#endif
+            if (!m_data)
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        void Close() noexcept
+        {
+#if defined(_WIN32)
+            if (m_data)
+            {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mapping)
+            {
+                CloseHandle(m_mapping);
+            }
+            m_mapping = nullptr;
+#else
+            if (m_data)
+            {
+                munmap(m_data, m_size);
+            }
+            if (m_owner)
+            {
+                shm_unlink(REGION_NAME);
+            }
+            m_owner = false;
+#endif
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        void* Data() const noexcept
+        {
+            return m_data;
+        }
+
+        size_t Size() const noexcept
+        {
+            return m_size;
+        }
+
+    private:
+#if defined(_WIN32)
+        HANDLE m_mapping{};
+#else
+        bool m_owner{};
+#endif
+        void* m_data{};
+        size_t m_size{};
+    };
+
+    // Counters go to a block in process memory until a publisher moves them to the shared region.
+    inline Block s_localBlock{};
+    inline std::atomic<Block*> s_block{ &s_localBlock };
+
+    inline void Add(Counter counter, uint64_t value = 1) noexcept
+    {
+        s_block.load(std::memory_order_acquire)->values[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // For counters kept elsewhere and published as they are.
+    inline void Set(Counter counter, uint64_t value) noexcept
+    {
+        s_block.load(std::memory_order_acquire)->values[static_cast<size_t>(counter)].store(value, std::memory_order_relaxed);
+    }
+
+    inline void Max(Counter counter, uint64_t value) noexcept
+    {
+        auto& current = s_block.load(std::memory_order_acquire)->values[static_cast<size_t>(counter)];
+        uint64_t seen = current.load(std::memory_order_relaxed);
+        while (seen < value && !current.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Shared block of the publisher. Writers load s_block without a lock, so one may still write to
+    // the shared block after Stop swapped it out: once mapped, it stays mapped until the module is
+    // unloaded, after every thread updating counters is gone. Stop only unpublishes it.
+    inline SharedRegion s_sharedRegion;
+
+    // Updates racing with Start or Stop may be lost, they aren't worth a lock on every update.
+    // One publisher at a time.
+    class Publisher
+    {
+    public:
+        Publisher() = default;
+        Publisher(const Publisher&) = delete;
+        Publisher& operator=(const Publisher&) = delete;
+
+        ~Publisher()
+        {
+            Stop();
+        }
+
+        bool Start(uint32_t processId) noexcept
+        {
+            Stop();
+            if (!s_sharedRegion.Data())
+            {
+                if (!s_sharedRegion.Create(sizeof(Block)))
+                {
+                    return false;
+                }
+                new (s_sharedRegion.Data()) Block{};
+            }
+
+            const auto block = static_cast<Block*>(s_sharedRegion.Data());
+            for (size_t i = 0; i < static_cast<size_t>(Counter::Count); i++)
+            {
+                block->values[i].store(s_localBlock.values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            block->header.version = VERSION;
+            block->header.counterCount = static_cast<uint32_t>(Counter::Count);
+            block->header.processId = processId;
+            block->header.magic.store(MAGIC, std::memory_order_release);
+            s_block.store(block, std::memory_order_release);
+            m_started = true;
+            return true;
+        }
+
+        void Stop() noexcept
+        {
+            if (!m_started)
+            {
+                return;
+            }
+
+            m_started = false;
+            const auto block = static_cast<Block*>(s_sharedRegion.Data());
+            s_block.store(&s_localBlock, std::memory_order_release);
+            for (size_t i = 0; i < static_cast<size_t>(Counter::Count); i++)
+            {
+                s_localBlock.values[i].store(block->values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            block->header.magic.store(0, std::memory_order_release);
+        }
+
+    private:
+        bool m_started{};
+    };
+
+    struct Sample
+    {
+        uint32_t version{};
+        uint32_t processId{};
+        uint32_t counterCount{}; // Counters known to both the publisher and this reader
+        uint64_t values[static_cast<size_t>(Counter::Count)]{};
+
+        uint64_t operator[](Counter counter) const noexcept
+        {
+            return values[static_cast<size_t>(counter)];
+        }
+    };
+
+    class Reader
+    {
+    public:
+        // False if no FancyZones is publishing.
+        bool Open() noexcept
+        {
+            return m_region.Open();
+        }
+
+        // False if the region doesn't hold a block (anymore) or one of a different version.
+        bool Read(Sample& sample) const noexcept
+        {
+            if (m_region.Size() < sizeof(Header))
+            {
+                return false;
+            }
+
+            const auto block = static_cast<const Block*>(m_region.Data());
+            if (block->header.magic.load(std::memory_order_acquire) != MAGIC || block->header.version != VERSION)
+            {
+                return false;
+            }
+
+            const size_t mapped = (m_region.Size() - sizeof(Header)) / sizeof(uint64_t);
+            size_t count = (std::min)(static_cast<size_t>(block->header.counterCount), static_cast<size_t>(Counter::Count));
+            count = (std::min)(count, mapped);
+
+            sample = Sample{ .version = block->header.version, .processId = block->header.processId, .counterCount = static_cast<uint32_t>(count) };
+            for (size_t i = 0; i < count; i++)
+            {
+                sample.values[i] = block->values[i].load(std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+    private:
+        SharedRegion m_region;
+    };
+
+    // "name value" lines, followed by the hit rate of each cache in percent.
+    inline void WriteText(std::ostream& stream, const Sample& sample)
+    {
+        stream << "processId " << sample.processId << "\n";
+        for (size_t i = 0; i < sample.counterCount; i++)
+        {
+            stream << COUNTER_NAMES[i] << " " << sample.values[i] << "\n";
+        }
+
+        const auto hitRate = [&](const char* name, Counter hits, Counter misses) {
+            const size_t last = static_cast<size_t>((std::max)(hits, misses));
+            const uint64_t total = sample[hits] + sample[misses];
+            if (last < sample.counterCount && total > 0)
+            {
+                stream << name << " " << (sample[hits] * 100.0 / total) << "\n";
+            }
+        };
+        hitRate("placementSkipRate", Counter::PlacementsSkipped, Counter::PlacementsIssued);
+        hitRate("zoneWindowMapHitRate", Counter::ZoneWindowMapHits, Counter::ZoneWindowMapMisses);
+        hitRate("desktopListHitRate", Counter::DesktopListHits, Counter::DesktopListMisses);
+    }
+}
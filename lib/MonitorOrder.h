@@ -0,0 +1,206 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Reading order of monitors. Monitor i blocks monitor j if i starts above j's bottom edge and left
+// of j's right edge, and a monitor goes after every monitor which blocks it. Among the monitors no
+// remaining monitor blocks, the one with the smallest (top, left) goes next, the earliest in the
+// input on ties. If every remaining monitor is blocked, which takes overlapping monitors, the
+// smallest remaining one goes next.
+namespace MonitorOrder
+{
+    using Entry = std::pair<Platform::MonitorHandle, Platform::Rect>;
+
+    // Kahn's algorithm with a heap of unblocked monitors, O(n log n + b) for b blocking pairs.
+    // Buffers are kept across calls.
+    class Sorter
+    {
+    public:
+        void Sort(std::vector<Entry>& monitors)
+        {
+            const auto count = static_cast<uint32_t>(monitors.size());
+            const auto less = [&](uint32_t a, uint32_t b) {
+                const auto& rectA = monitors[a].second;
+                const auto& rectB = monitors[b].second;
+                return std::tie(rectA.top, rectA.left, a) < std::tie(rectB.top, rectB.left, b);
+            };
+
+            // Monitors by (top, left, index). Blockers of a monitor are a prefix of it, as they
+            // start above its bottom edge, which the sweep finds with a binary search.
+            m_byKey.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                m_byKey[i] = i;
+            }
+            std::sort(m_byKey.begin(), m_byKey.end(), less);
+
+            m_blockedBy.assign(count, 0);
+            m_edgeStart.assign(count + 1, 0);
+            m_pairs.clear();
+            for (uint32_t j = 0; j < count; j++)
+            {
+                const auto& rectJ = monitors[j].second;
+                const auto end = std::partition_point(m_byKey.begin(), m_byKey.end(), [&](uint32_t i) {
+                    return monitors[i].second.top < rectJ.bottom;
+                });
+                for (auto it = m_byKey.begin(); it != end; ++it)
+                {
+                    if (*it != j && monitors[*it].second.left < rectJ.right)
+                    {
+                        m_pairs.emplace_back(*it, j);
+                        m_edgeStart[*it + 1]++;
+                        m_blockedBy[j]++;
+                    }
+                }
+            }
+
+            // Monitors blocked by each monitor, grouped by blocker
+            for (uint32_t i = 0; i < count; i++)
+            {
+                m_edgeStart[i + 1] += m_edgeStart[i];
+            }
+            m_edges.resize(m_pairs.size());
+            m_fill.assign(m_edgeStart.begin(), m_edgeStart.end() - 1);
+            for (const auto& [blocker, blocked] : m_pairs)
+            {
+                m_edges[m_fill[blocker]++] = blocked;
+            }
+
+            // Min-heap, the comparison is reversed
+            const auto greater = [&](uint32_t a, uint32_t b) { return less(b, a); };
+            m_heap.clear();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (m_blockedBy[i] == 0)
+                {
+                    m_heap.push_back(i);
+                }
+            }
+            std::make_heap(m_heap.begin(), m_heap.end(), greater);
+
+            m_used.assign(count, false);
+            m_sorted.clear();
+            size_t smallestUnused = 0;
+            for (uint32_t placed = 0; placed < count; placed++)
+            {
+                uint32_t next;
+                if (!m_heap.empty())
+                {
+                    std::pop_heap(m_heap.begin(), m_heap.end(), greater);
+                    next = m_heap.back();
+                    m_heap.pop_back();
+                }
+                else
+                {
+                    while (m_used[m_byKey[smallestUnused]])
+                    {
+                        smallestUnused++;
+                    }
+                    next = m_byKey[smallestUnused];
+                }
+
+                m_used[next] = true;
+                m_sorted.push_back(monitors[next]);
+                for (uint32_t e = m_edgeStart[next]; e < m_edgeStart[next + 1]; e++)
+                {
+                    const uint32_t blocked = m_edges[e];
+                    if (--m_blockedBy[blocked] == 0 && !m_used[blocked])
+                    {
+                        m_heap.push_back(blocked);
+                        std::push_heap(m_heap.begin(), m_heap.end(), greater);
+                    }
+                }
+            }
+
+            monitors.swap(m_sorted);
+        }
+
+    private:
+        std::vector<uint32_t> m_byKey;
+        std::vector<uint32_t> m_blockedBy; // Remaining monitors blocking each monitor
+        std::vector<std::pair<uint32_t, uint32_t>> m_pairs; // Blocker, blocked
+        std::vector<uint32_t> m_edgeStart;
+        std::vector<uint32_t> m_fill;
+        std::vector<uint32_t> m_edges;
+        std::vector<uint32_t> m_heap;
+        std::vector<bool> m_used;
+        std::vector<Entry> m_sorted;
+    };
+
+#if defined(UNIT_TESTS)
+    // The original ordering, O(n^3), for checking Sorter against.
+    inline void SortReference(std::vector<Entry>& monitorInfo)
+    {
+        const size_t nMonitors = monitorInfo.size();
+        std::vector<std::vector<bool>> blocking(nMonitors, std::vector<bool>(nMonitors, false));
+        std::vector<size_t> blockingCount(nMonitors, 0);
+        for (size_t i = 0; i < nMonitors; i++)
+        {
+            const auto& rectI = monitorInfo[i].second;
+            for (size_t j = 0; j < nMonitors; j++)
+            {
+                const auto& rectJ = monitorInfo[j].second;
+                blocking[i][j] = rectI.top < rectJ.bottom && rectI.left < rectJ.right && i != j;
+                if (blocking[i][j])
+                {
+                    blockingCount[j]++;
+                }
+            }
+        }
+
+        std::vector<bool> used(nMonitors, false);
+        std::vector<Entry> sortedMonitorInfo;
+        for (size_t iteration = 0; iteration < nMonitors; iteration++)
+        {
+            std::vector<size_t> candidates;
+            for (size_t i = 0; i < nMonitors; i++)
+            {
+                if (blockingCount[i] == 0 && !used[i])
+                {
+                    candidates.push_back(i);
+                }
+            }
+            if (candidates.empty())
+            {
+                for (size_t i = 0; i < nMonitors; i++)
+                {
+                    if (!used[i])
+                    {
+                        candidates.push_back(i);
+                    }
+                }
+            }
+
+            size_t smallest = candidates[0];
+            for (size_t j = 1; j < candidates.size(); j++)
+            {
+                const size_t current = candidates[j];
+                if (std::tie(monitorInfo[current].second.top, monitorInfo[current].second.left) <
+                    std::tie(monitorInfo[smallest].second.top, monitorInfo[smallest].second.left))
+                {
+                    smallest = current;
+                }
+            }
+
+            used[smallest] = true;
+            sortedMonitorInfo.push_back(monitorInfo[smallest]);
+            for (size_t i = 0; i < nMonitors; i++)
+            {
+                if (blocking[smallest][i])
+                {
+                    blockingCount[i]--;
+                }
+            }
+        }
+
+        monitorInfo = std::move(sortedMonitorInfo);
+    }
+#endif
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "MetricsBlock.h"
+#include "MonitorOrder.h"
+#include "Platform.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// What every monitor looks like, as of the last display, work area or DPI change. Geometry used to
+// be asked from the system on each window move and hotkey, now it's read from an immutable
+// snapshot which is only rebuilt when the system says something changed. Readers keep the snapshot
+// they got for as long as they need it, a rebuild publishes a new one next to it.
+namespace MonitorTopology
+{
+    struct Monitor
+    {
+        Platform::MonitorHandle handle{};
+        Platform::Rect rect{};
+        Platform::Rect workArea{};
+        unsigned dpi{ 96 };
+        std::wstring deviceId;
+        bool zonable{}; // False for mirroring drivers, which get no zone window
+    };
+
+    struct Snapshot
+    {
+        uint64_t version{}; // Increases with every rebuild, 0 before the first one
+        std::vector<Monitor> monitors; // Enumeration order
+        std::vector<Platform::MonitorHandle> sorted; // Zonable monitors in reading order, see MonitorOrder
+        bool uniformDpi{ true }; // Every monitor has the same DPI
+
+        // nullptr if the monitor isn't known, e.g. disconnected since the rebuild.
+        const Monitor* Find(Platform::MonitorHandle handle) const noexcept
+        {
+            for (const auto& monitor : monitors)
+            {
+                if (monitor.handle == handle)
+                {
+                    return &monitor;
+                }
+            }
+            return nullptr;
+        }
+
+        // Monitor with the largest intersection with the rect, or the nearest one, like MonitorFromRect.
+        const Monitor* FromRect(const Platform::Rect& rect) const noexcept
+        {
+            const Monitor* best{};
+            int64_t bestArea = 0;
+            int64_t bestDistance = INT64_MAX;
+            for (const auto& monitor : monitors)
+            {
+                const int64_t width = static_cast<int64_t>((std::min)(rect.right, monitor.rect.right)) - (std::max)(rect.left, monitor.rect.left);
+                const int64_t height = static_cast<int64_t>((std::min)(rect.bottom, monitor.rect.bottom)) - (std::max)(rect.top, monitor.rect.top);
+                if (width > 0 && height > 0)
+                {
+                    if (width * height > bestArea)
+                    {
+                        best = &monitor;
+                        bestArea = width * height;
+                    }
+                }
+                else if (bestArea == 0)
+                {
+                    const int64_t dx = (std::max)(static_cast<int64_t>(0), -width);
+                    const int64_t dy = (std::max)(static_cast<int64_t>(0), -height);
+                    if (dx * dx + dy * dy < bestDistance)
+                    {
+                        best = &monitor;
+                        bestDistance = dx * dx + dy * dy;
+                    }
+                }
+            }
+            return best;
+        }
+    };
+
+    class Service
+    {
+    public:
+        // Built on first use if no change was reported yet.
+        std::shared_ptr<const Snapshot> Current(Platform::Backend& platform)
+        {
+            std::scoped_lock lock{ m_lock };
+            if (!m_current)
+            {
+                RebuildLocked(platform);
+            }
+            return m_current;
+        }
+
+        // Called for display, work area and DPI changes.
+        std::shared_ptr<const Snapshot> Rebuild(Platform::Backend& platform)
+        {
+            std::scoped_lock lock{ m_lock };
+            RebuildLocked(platform);
+            return m_current;
+        }
+
+        uint64_t Version() const
+        {
+            std::scoped_lock lock{ m_lock };
+            return m_current ? m_current->version : 0;
+        }
+
+    private:
+        void RebuildLocked(Platform::Backend& platform)
+        {
+            auto snapshot = std::make_shared<Snapshot>();
+            snapshot->version = ++m_version;
+
+            platform.Monitors(m_handles);
+            snapshot->monitors.reserve(m_handles.size());
+            m_order.clear();
+            for (const auto handle : m_handles)
+            {
+                Monitor monitor{};
+                monitor.handle = handle;
+                if (!platform.GetMonitorRects(handle, monitor.rect, monitor.workArea))
+                {
+                    continue;
+                }
+                monitor.dpi = platform.MonitorDpi(handle);
+                monitor.zonable = platform.MonitorDeviceId(handle, monitor.deviceId);
+                if (monitor.zonable)
+                {
+                    m_order.emplace_back(handle, monitor.rect);
+                }
+                snapshot->uniformDpi &= snapshot->monitors.empty() || monitor.dpi == snapshot->monitors.front().dpi;
+                snapshot->monitors.push_back(std::move(monitor));
+            }
+
+            m_sorter.Sort(m_order);
+            snapshot->sorted.reserve(m_order.size());
+            for (const auto& [handle, rect] : m_order)
+            {
+                snapshot->sorted.push_back(handle);
+            }
+            m_current = std::move(snapshot);
+            Metrics::Add(Metrics::Counter::MonitorTopologyRebuilds);
+        }
+
+        mutable std::mutex m_lock;
+        std::shared_ptr<const Snapshot> m_current;
+        uint64_t m_version{};
+        std::vector<Platform::MonitorHandle> m_handles;
+        std::vector<MonitorOrder::Entry> m_order;
+        MonitorOrder::Sorter m_sorter;
+    };
+}
+
+MonitorTopology::Service& MonitorTopologyInstance();
@@ -0,0 +1,12 @@
+#pragma once
+
+// What a batch of window placements is for, placements are counted per operation.
+enum class PlacementOperation : int
+{
+    Other = 0,
+    Settle,
+    Cycle,
+    WidthChange,
+    UpdatePositions,
+    Count
+};
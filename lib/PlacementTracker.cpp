@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "PlacementTracker.h"
+
+#include "MetricsBlock.h"
+
+namespace
+{
+    thread_local PlacementTracker::OperationScope* t_activeScope = nullptr;
+
+    bool GetFrameBounds(HWND window, RECT& frameBounds) noexcept
+    {
+        return SUCCEEDED(DwmGetWindowAttribute(window, DWMWA_EXTENDED_FRAME_BOUNDS, &frameBounds, sizeof(frameBounds))) ||
+               GetWindowRect(window, &frameBounds);
+    }
+}
+
+PlacementTracker::OperationScope::OperationScope(PlacementOperation operation) noexcept :
+    m_operation(operation),
+    m_previous(t_activeScope)
+{
+    t_activeScope = this;
+}
+
+PlacementTracker::OperationScope::~OperationScope()
+{
+    t_activeScope = m_previous;
+    PlacementTrackerInstance().Account(*this);
+}
+
+bool PlacementTracker::IsAlreadyApplied(HWND window, const RECT& rect) noexcept
+{
+    // Windows we didn't place there can't be skipped, they don't cost any system calls
+    AppliedPlacement applied;
+    {
+        std::scoped_lock lock{ m_lock };
+        auto it = m_applied.find(window);
+        if (it == m_applied.end() || !EqualRect(&it->second.requested, &rect))
+        {
+            return false;
+        }
+        applied = it->second;
+    }
+
+    if (IsIconic(window) || IsZoomed(window))
+    {
+        return false;
+    }
+
+    RECT frameBounds{};
+    if (!GetFrameBounds(window, frameBounds))
+    {
+        return false;
+    }
+
+    if (applied.confirmed)
+    {
+        // Window was moved or resized by someone else since we placed it
+        return EqualRect(&applied.frameBounds, &frameBounds);
+    }
+
+    // Placement is asynchronous, confirm it landed before trusting the frame bounds.
+    WINDOWPLACEMENT placement{ sizeof(placement) };
+    if (!GetWindowPlacement(window, &placement) || !EqualRect(&placement.rcNormalPosition, &rect))
+    {
+        return false;
+    }
+
+    std::scoped_lock lock{ m_lock };
+    auto it = m_applied.find(window);
+    if (it != m_applied.end() && EqualRect(&it->second.requested, &rect))
+    {
+        it->second.frameBounds = frameBounds;
+        it->second.confirmed = true;
+    }
+    return true;
+}
+
+void PlacementTracker::RecordApplied(HWND window, const RECT& rect) noexcept
+{
+    std::scoped_lock lock{ m_lock };
+    m_applied[window] = AppliedPlacement{ .requested = rect, .frameBounds = {}, .confirmed = false };
+    Metrics::Set(Metrics::Counter::PlacementTrackerEntries, m_applied.size());
+}
+
+void PlacementTracker::CountIssued() noexcept
+{
+    if (t_activeScope)
+    {
+        t_activeScope->m_issued++;
+    }
+    else
+    {
+        m_counters[static_cast<int>(PlacementOperation::Other)].issued++;
+    }
+}
+
+void PlacementTracker::CountSkipped() noexcept
+{
+    if (t_activeScope)
+    {
+        t_activeScope->m_skipped++;
+    }
+    else
+    {
+        m_counters[static_cast<int>(PlacementOperation::Other)].skipped++;
+    }
+}
+
+void PlacementTracker::Forget(HWND window) noexcept
+{
+    std::scoped_lock lock{ m_lock };
+    if (m_applied.erase(window))
+    {
+        Metrics::Set(Metrics::Counter::PlacementTrackerEntries, m_applied.size());
+    }
+}
+
+void PlacementTracker::Prune() noexcept
+{
+    std::scoped_lock lock{ m_lock };
+    std::erase_if(m_applied, [](const auto& entry) { return !IsWindow(entry.first); });
+    Metrics::Set(Metrics::Counter::PlacementTrackerEntries, m_applied.size());
+}
+
+PlacementStats PlacementTracker::GetStats(PlacementOperation operation) const noexcept
+{
+    const auto& counters = m_counters[static_cast<int>(operation)];
+    return PlacementStats{ .operations = counters.operations, .issued = counters.issued, .skipped = counters.skipped };
+}
+
+void PlacementTracker::Account(const OperationScope& scope) noexcept
+{
+    auto& counters = m_counters[static_cast<int>(scope.m_operation)];
+    counters.operations++;
+    counters.issued += scope.m_issued;
+    counters.skipped += scope.m_skipped;
+
+    // Operations, issued and skipped counters of each operation are consecutive
+    const auto first = static_cast<uint32_t>(Metrics::Counter::OtherOperations) + 3 * static_cast<uint32_t>(scope.m_operation);
+    Metrics::Add(static_cast<Metrics::Counter>(first));
+    Metrics::Add(static_cast<Metrics::Counter>(first + 1), scope.m_issued);
+    Metrics::Add(static_cast<Metrics::Counter>(first + 2), scope.m_skipped);
+}
+
+PlacementTracker& PlacementTrackerInstance()
+{
+    static PlacementTracker instance;
+    return instance;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "PlacementOperation.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+struct PlacementStats
+{
+    uint64_t operations{};
+    uint64_t issued{};
+    uint64_t skipped{};
+};
+
+/**
+ * Remembers the last rect applied to each window, so layouts which don't change a window's
+ * position don't issue placement calls for it.
+ */
+class PlacementTracker
+{
+public:
+    /**
+     * Attributes placements issued on the calling thread to an operation, and accounts them when closed.
+     */
+    class OperationScope
+    {
+    public:
+        OperationScope(PlacementOperation operation) noexcept;
+        ~OperationScope();
+
+        OperationScope(const OperationScope&) = delete;
+        OperationScope& operator=(const OperationScope&) = delete;
+
+    private:
+        friend class PlacementTracker;
+
+        PlacementOperation m_operation;
+        OperationScope* m_previous{};
+        uint64_t m_issued{};
+        uint64_t m_skipped{};
+    };
+
+    /**
+     * Check if the rect was already applied to the window and the window is still there. Only if the
+     * tracker applied that rect last, it's confirmed against the actual window placement and DWM frame
+     * bounds, since placement is asynchronous and the user can move the window in the meantime.
+     *
+     * @param   window Window handle.
+     * @param   rect   Target rect, in workspace coordinates.
+     *
+     * @returns Boolean indicating if placement can be skipped.
+     */
+    bool IsAlreadyApplied(HWND window, const RECT& rect) noexcept;
+    void RecordApplied(HWND window, const RECT& rect) noexcept;
+    void CountIssued() noexcept;
+    void CountSkipped() noexcept;
+
+    /**
+     * Drop the entry of a destroyed window.
+     */
+    void Forget(HWND window) noexcept;
+
+    /**
+     * Drop entries of windows which don't exist anymore, for destroy events that were missed.
+     */
+    void Prune() noexcept;
+
+    PlacementStats GetStats(PlacementOperation operation) const noexcept;
+
+private:
+    struct AppliedPlacement
+    {
+        RECT requested{};
+        RECT frameBounds{};
+        bool confirmed{};
+    };
+
+    struct Counters
+    {
+        std::atomic<uint64_t> operations{};
+        std::atomic<uint64_t> issued{};
+        std::atomic<uint64_t> skipped{};
+    };
+
+    void Account(const OperationScope& scope) noexcept;
+
+    mutable std::mutex m_lock;
+    std::unordered_map<HWND, AppliedPlacement> m_applied;
+    Counters m_counters[static_cast<int>(PlacementOperation::Count)];
+};
+
+PlacementTracker& PlacementTrackerInstance();
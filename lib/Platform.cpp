@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "Platform.h"
+#include "MetricsBlock.h"
+#include "MonitorTopology.h"
+
+#include <common/common.h>
+
+#include "util.h"
+#include "VirtualDesktopUtils.h"
+
+namespace
+{
+    class Win32Backend : public Platform::Backend
+    {
+    public:
+        void TopLevelWindows(std::vector<HWND>& windows) noexcept override
+        {
+            windows.clear();
+            for (HWND window = GetTopWindow(nullptr); window != nullptr; window = GetNextWindow(window, GW_HWNDNEXT))
+            {
+                windows.push_back(window);
+            }
+        }
+
+        HWND ForegroundWindow() noexcept override
+        {
+            return GetForegroundWindow();
+        }
+
+        bool GetZonableWindowProcess(HWND window, std::wstring& processPath) noexcept override
+        {
+            auto filtered = get_fancyzones_filtered_window(window);
+            if (!filtered.zonable)
+            {
+                return false;
+            }
+            // Assigned rather than moved, the caller's buffer keeps its capacity
+            processPath.assign(filtered.process_path);
+            return true;
+        }
+
+        bool IsOnCurrentDesktop(HWND window) noexcept override
+        {
+            return VirtualDesktopUtils::IsApplicationViewVisible(window);
+        }
+
+        void PlaceWindow(HWND window, const RECT& rect) noexcept override
+        {
+            ApplyWindowPlacement(window, rect);
+        }
+
+        void Monitors(std::vector<HMONITOR>& monitors) noexcept override
+        {
+            Metrics::Add(Metrics::Counter::MonitorEnumerations);
+            monitors.clear();
+            EnumDisplayMonitors(nullptr, nullptr, [](HMONITOR monitor, HDC, LPRECT, LPARAM data) -> BOOL {
+                reinterpret_cast<std::vector<HMONITOR>*>(data)->push_back(monitor);
+                return TRUE;
+            }, reinterpret_cast<LPARAM>(&monitors));
+        }
+
+        size_t MonitorCount() noexcept override
+        {
+            return static_cast<size_t>(GetSystemMetrics(SM_CMONITORS));
+        }
+
+        HMONITOR MonitorOfWindow(HWND window) noexcept override
+        {
+            return MonitorFromWindow(window, MONITOR_DEFAULTTONULL);
+        }
+
+        bool GetMonitorRects(HMONITOR monitor, RECT& monitorRect, RECT& workArea) noexcept override
+        {
+            MONITORINFO mi{ sizeof(mi) };
+            if (!GetMonitorInfoW(monitor, &mi))
+            {
+                return false;
+            }
+            monitorRect = mi.rcMonitor;
+            workArea = mi.rcWork;
+            return true;
+        }
+
+        unsigned MonitorDpi(HMONITOR monitor) noexcept override
+        {
+            return GetDpiForMonitor(monitor);
+        }
+
+        bool MonitorDeviceId(HMONITOR monitor, std::wstring& deviceId) noexcept override
+        {
+            MONITORINFOEX mi{};
+            mi.cbSize = sizeof(mi);
+            if (!GetMonitorInfoW(monitor, &mi))
+            {
+                return false;
+            }
+
+            DISPLAY_DEVICE displayDevice = { sizeof(displayDevice) };
+            if (EnumDisplayDevicesW(mi.szDevice, 0, &displayDevice, 1))
+            {
+                if (WI_IsFlagSet(displayDevice.StateFlags, DISPLAY_DEVICE_MIRRORING_DRIVER))
+                {
+                    return false;
+                }
+                if (displayDevice.DeviceID[0] != L'\0')
+                {
+                    deviceId.assign(displayDevice.DeviceID);
+                    return true;
+                }
+            }
+
+            deviceId.assign(GetSystemMetrics(SM_REMOTESESSION) ?
+                                L"\\\\?\\DISPLAY#REMOTEDISPLAY#" :
+                                L"\\\\?\\DISPLAY#LOCALDISPLAY#");
+            return true;
+        }
+
+        bool GetCurrentDesktop(GUID& desktop) noexcept override
+        {
+            return VirtualDesktopUtils::GetCurrentVirtualDesktopId(&desktop);
+        }
+
+        bool GetDesktops(std::vector<GUID>& desktops) noexcept override
+        {
+            return VirtualDesktopUtils::GetVirtualDesktopIds(desktops);
+        }
+    };
+
+    Win32Backend s_win32Backend;
+    std::atomic<Platform::Backend*> s_backend{ &s_win32Backend };
+    MonitorTopology::Service s_monitorTopology;
+}
+
+Platform::Backend& PlatformInstance()
+{
+    return *s_backend.load(std::memory_order_acquire);
+}
+
+void SetPlatformInstance(Platform::Backend* backend) noexcept
+{
+    s_backend.store(backend ? backend : &s_win32Backend, std::memory_order_release);
+    // The snapshot described the previous backend's monitors
+    s_monitorTopology.Rebuild(PlatformInstance());
+}
+
+MonitorTopology::Service& MonitorTopologyInstance()
+{
+    return s_monitorTopology;
+}
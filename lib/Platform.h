@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything the tiling logic asks the OS about windows, monitors and virtual desktops. The Win32
+// backend makes the actual calls, InMemoryPlatform simulates a desktop, which lets the logic run
+// headless and on other platforms.
+namespace Platform
+{
+#if defined(_WIN32)
+    using WindowHandle = HWND;
+    using MonitorHandle = HMONITOR;
+    using Rect = RECT;
+    using DesktopId = GUID;
+#else
+    struct WindowTag;
+    struct MonitorTag;
+    using WindowHandle = WindowTag*;
+    using MonitorHandle = MonitorTag*;
+
+    struct Rect
+    {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+    };
+
+    // Same layout as GUID
+    struct DesktopId
+    {
+        uint32_t Data1;
+        uint16_t Data2;
+        uint16_t Data3;
+        uint8_t Data4[8];
+
+        bool operator==(const DesktopId&) const = default;
+    };
+#endif
+
+    class Backend
+    {
+    public:
+        virtual ~Backend() = default;
+
+        // Top-level windows in z-order, topmost first. Lists are filled into the caller's vector, which
+        // is cleared first, so callers on hot paths can keep reusing one.
+        virtual void TopLevelWindows(std::vector<WindowHandle>& windows) noexcept = 0;
+        virtual WindowHandle ForegroundWindow() noexcept = 0;
+        // False for windows that can't be zoned (tool windows, popups, ...), otherwise returns the window's process path.
+        virtual bool GetZonableWindowProcess(WindowHandle window, std::wstring& processPath) noexcept = 0;
+        virtual bool IsOnCurrentDesktop(WindowHandle window) noexcept = 0;
+        virtual void PlaceWindow(WindowHandle window, const Rect& rect) noexcept = 0;
+
+        virtual void Monitors(std::vector<MonitorHandle>& monitors) noexcept = 0;
+        virtual size_t MonitorCount() noexcept = 0;
+        // Monitor the window is mostly on, nullptr if it's on none.
+        virtual MonitorHandle MonitorOfWindow(WindowHandle window) noexcept = 0;
+        virtual bool GetMonitorRects(MonitorHandle monitor, Rect& monitorRect, Rect& workArea) noexcept = 0;
+        virtual unsigned MonitorDpi(MonitorHandle monitor) noexcept = 0;
+        // False for monitors which don't get zones (mirroring drivers), otherwise returns the display device id.
+        virtual bool MonitorDeviceId(MonitorHandle monitor, std::wstring& deviceId) noexcept = 0;
+
+        virtual bool GetCurrentDesktop(DesktopId& desktop) noexcept = 0;
+        virtual bool GetDesktops(std::vector<DesktopId>& desktops) noexcept = 0;
+    };
+}
+
+// Win32 backend unless replaced, e.g. by an in-memory one.
+Platform::Backend& PlatformInstance();
+void SetPlatformInstance(Platform::Backend* backend) noexcept;
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "HookEventQueue.h"
+#include "LatencyTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hotkey-driven relayout requests. The keyboard hook submits a request for every key press,
+// auto-repeats included, and the message loop takes everything pending at once. Submitting neither
+// locks nor allocates, requests go through a preallocated lock-free ring, so the hook can't stall or
+// throw. Consecutive requests for the same action are merged into a single one with a repeat count
+// when they're taken, so intermediate layouts are computed but never placed. Every submission bumps
+// the generation, which lets a relayout in flight notice it was superseded and stop issuing window moves.
+namespace Relayout
+{
+    enum class RequestKind : uint8_t
+    {
+        Snap,
+        MainZoneWidth
+    };
+
+    struct Request
+    {
+        uint64_t generation{};
+        RequestKind kind{};
+        uint32_t vkCode{};
+        uint32_t repeat{};
+        LatencyTrace::TimePoint inputAt{}; // Of the oldest request merged into this one
+        LatencyTrace::TimePoint queuedAt{};
+    };
+
+    class RequestQueue
+    {
+    public:
+        static constexpr size_t CAPACITY = 256;
+
+        // Safe to call from any thread. Returns true if the consumer has to be woken up, which happens
+        // once until the next TakeAll. If waking it fails, call CancelWake so the next submission
+        // tries again. A full ring drops the request, the newest one taken stands in for it.
+        bool Submit(RequestKind kind, uint32_t vkCode, LatencyTrace::TimePoint inputAt = {}) noexcept
+        {
+            const uint64_t generation = m_generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+            if (!m_ring.TryPush(Request{ .generation = generation, .kind = kind, .vkCode = vkCode, .repeat = 1, .inputAt = inputAt, .queuedAt = LatencyTrace::Now() }))
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                m_overflowed.store(true, std::memory_order_release);
+            }
+            return !m_wakePending.exchange(true, std::memory_order_acq_rel);
+        }
+
+        void CancelWake() noexcept
+        {
+            m_wakePending.store(false, std::memory_order_release);
+        }
+
+        // Consumer side. Replaces given requests with the pending ones, in submission order, the last
+        // one is the newest. Capacity for a full ring is reserved once, a consumer passing the same
+        // vector each time doesn't allocate.
+        void TakeAll(std::vector<Request>& requests)
+        {
+            requests.clear();
+            requests.reserve(CAPACITY);
+
+            // Submissions from now on wake the consumer again, whatever is already queued is taken below
+            m_wakePending.store(false, std::memory_order_release);
+
+            Request request;
+            while (m_ring.TryPop(request))
+            {
+                if (!requests.empty() && requests.back().kind == request.kind && requests.back().vkCode == request.vkCode)
+                {
+                    requests.back().generation = (std::max)(requests.back().generation, request.generation);
+                    requests.back().repeat += request.repeat;
+                }
+                else
+                {
+                    requests.push_back(request);
+                }
+            }
+
+            // Producers may push out of generation order, the newest request carries the newest generation
+            // taken. Dropped requests were newer than anything in the ring.
+            if (!requests.empty())
+            {
+                auto& newest = requests.back();
+                for (const auto& taken : requests)
+                {
+                    newest.generation = (std::max)(newest.generation, taken.generation);
+                }
+                if (m_overflowed.exchange(false, std::memory_order_acq_rel))
+                {
+                    newest.generation = m_generation.load(std::memory_order_acquire);
+                }
+            }
+        }
+
+        bool IsSuperseded(uint64_t generation) const noexcept
+        {
+            return m_generation.load(std::memory_order_acquire) != generation;
+        }
+
+        uint64_t Dropped() const noexcept
+        {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        HookEvents::MpscRing<Request, CAPACITY> m_ring;
+        std::atomic<bool> m_wakePending{ false };
+        std::atomic<bool> m_overflowed{ false };
+        std::atomic<uint64_t> m_generation{ 0 };
+        std::atomic<uint64_t> m_dropped{ 0 };
+    };
+}
@@ -35,16 +35,19 @@ private:
         PCWSTR name;
         bool* value;
         int resourceId;
-    } m_configBools[6] = {
+    } m_configBools[8] = {
         { L"fancyzones_overrideSnapHotkeys", &m_settings.overrideSnapHotkeys, IDS_SETTING_DESCRIPTION_OVERRIDE_SNAP_HOTKEYS },
         { L"fancyzones_moveWindowAcrossMonitors", &m_settings.moveWindowAcrossMonitors, IDS_SETTING_DESCRIPTION_MOVE_WINDOW_ACROSS_MONITORS },
         { L"fancyzones_displayChange_moveWindows", &m_settings.displayChange_moveWindows, IDS_SETTING_DESCRIPTION_DISPLAYCHANGE_MOVEWINDOWS },
         { L"fancyzones_zoneSetChange_moveWindows", &m_settings.zoneSetChange_moveWindows, IDS_SETTING_DESCRIPTION_ZONESETCHANGE_MOVEWINDOWS },
         { L"fancyzones_appLastZone_moveWindows", &m_settings.appLastZone_moveWindows, IDS_SETTING_DESCRIPTION_APPLASTZONE_MOVEWINDOWS },
         { L"fancyzones_show_on_all_monitors", &m_settings.showZonesOnAllMonitors, IDS_SETTING_DESCRIPTION_SHOW_FANCY_ZONES_ON_ALL_MONITORS},
+        { L"fancyzones_animateWindowMoves", &m_settings.animateWindowMoves, IDS_SETTING_DESCRIPTION_ANIMATE_WINDOW_MOVES },
+        { L"fancyzones_recordEventTrace", &m_settings.recordEventTrace, IDS_SETTING_DESCRIPTION_RECORD_EVENT_TRACE },
     };
 
     const std::wstring m_excludedAppsName = L"fancyzones_excluded_apps";
+    const std::wstring m_appZoneHistoryCapacityName = L"fancyzones_appZoneHistoryCapacity";
 };
 
 IFACEMETHODIMP_(bool) FancyZonesSettings::GetConfig(_Out_ PWSTR buffer, _Out_ int *buffer_size) noexcept
@@ -61,6 +64,7 @@ IFACEMETHODIMP_(bool) FancyZonesSettings::GetConfig(_Out_ PWSTR buffer, _Out_ in
     }
 
     settings.add_multiline_string(m_excludedAppsName, IDS_SETTING_EXCLCUDED_APPS_DESCRIPTION, m_settings.excludedApps);
+    settings.add_int_spinner(m_appZoneHistoryCapacityName, IDS_SETTING_DESCRIPTION_APP_ZONE_HISTORY_CAPACITY, m_settings.appZoneHistoryCapacity, 10, 100000, 10);
 
     return settings.serialize_to_buffer(buffer, buffer_size);
 }
@@ -103,6 +107,11 @@ void FancyZonesSettings::LoadSettings(PCWSTR config, bool fromFile) noexcept try
         }
     }
 
+    if (const auto val = values.get_int_value(m_appZoneHistoryCapacityName))
+    {
+        m_settings.appZoneHistoryCapacity = std::clamp(*val, 10, 100000);
+    }
+
     if (auto val = values.get_string_value(m_excludedAppsName))
     {
         m_settings.excludedApps = std::move(*val);
@@ -138,6 +147,7 @@ void FancyZonesSettings::SaveSettings() noexcept try
     }
 
     values.add_property(m_excludedAppsName, m_settings.excludedApps);
+    values.add_property(m_appZoneHistoryCapacityName, m_settings.appZoneHistoryCapacity);
 
     values.save_to_settings_file();
 }
@@ -13,6 +13,9 @@ struct Settings
     bool appLastZone_moveWindows = false;
     bool showZonesOnAllMonitors = false;
     bool use_cursorpos_editor_startupscreen = true;
+    bool animateWindowMoves = false;
+    bool recordEventTrace = false;
+    int appZoneHistoryCapacity = 1000;
     std::wstring excludedApps = L"";
     std::vector<std::wstring> excludedAppsArray;
 };
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "MetricsBlock.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+enum class ShellCallResult : uint8_t
+{
+    Succeeded,
+    Failed,
+    Disconnected, // Shell went away, e.g. Explorer restarted
+};
+
+// Owns the connection to the shell's services and the list of virtual desktops fetched through it.
+// The connection is made on first use and kept until a call reports it's gone, in which case it's
+// re-established and the call retried once. The desktop list is cached until the desktop list
+// generation changes, which is bumped whenever desktops are created, deleted or reordered.
+//
+// Provider requirements:
+//     typename Provider::Connection   interfaces obtained from the shell, default constructible
+//     typename Provider::Desktop      handle of a virtual desktop
+//     ShellCallResult Connect(Connection& connection)
+//     ShellCallResult ListDesktops(Connection& connection, std::vector<Desktop>& desktops)
+template<typename Provider>
+class ShellServiceBroker
+{
+public:
+    using Connection = typename Provider::Connection;
+    using Desktop = typename Provider::Desktop;
+
+    struct Stats
+    {
+        uint64_t connects{};
+        uint64_t disconnects{};
+        uint64_t desktopListFetches{};
+        uint64_t desktopListHits{};
+    };
+
+    explicit ShellServiceBroker(const std::atomic<uint64_t>& desktopListGeneration, Provider provider = Provider{}) :
+        m_provider(std::move(provider)),
+        m_desktopListGeneration(desktopListGeneration)
+    {
+    }
+
+    ShellServiceBroker(const ShellServiceBroker&) = delete;
+    ShellServiceBroker& operator=(const ShellServiceBroker&) = delete;
+
+    // Runs call(connection) and returns its result, connecting first if needed.
+    template<typename Call>
+    ShellCallResult Invoke(Call&& call)
+    {
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            if (!m_connection)
+            {
+                Connection connection{};
+                if (m_provider.Connect(connection) != ShellCallResult::Succeeded)
+                {
+                    return ShellCallResult::Failed;
+                }
+                m_connection.emplace(std::move(connection));
+                m_stats.connects++;
+            }
+
+            const ShellCallResult result = call(*m_connection);
+            if (result != ShellCallResult::Disconnected)
+            {
+                return result;
+            }
+            Disconnect();
+        }
+        return ShellCallResult::Disconnected;
+    }
+
+    // Desktop with given index, from the cached list. Only valid inside Invoke, with its connection.
+    ShellCallResult DesktopAt(Connection& connection, size_t index, Desktop& desktop)
+    {
+        const uint64_t generation = m_desktopListGeneration.load(std::memory_order_acquire);
+        if (!m_desktopsValid || m_desktopsGeneration != generation)
+        {
+            std::vector<Desktop> desktops;
+            const ShellCallResult result = m_provider.ListDesktops(connection, desktops);
+            if (result != ShellCallResult::Succeeded)
+            {
+                return result;
+            }
+            m_desktops = std::move(desktops);
+            m_desktopsGeneration = generation;
+            m_desktopsValid = true;
+            m_stats.desktopListFetches++;
+            Metrics::Add(Metrics::Counter::DesktopListMisses);
+        }
+        else
+        {
+            m_stats.desktopListHits++;
+            Metrics::Add(Metrics::Counter::DesktopListHits);
+        }
+
+        if (index >= m_desktops.size())
+        {
+            return ShellCallResult::Failed;
+        }
+        desktop = m_desktops[index];
+        return ShellCallResult::Succeeded;
+    }
+
+    // Drop the connection and everything obtained through it.
+    void Disconnect() noexcept
+    {
+        if (m_connection)
+        {
+            m_stats.disconnects++;
+        }
+        m_desktops.clear();
+        m_desktopsValid = false;
+        m_connection.reset();
+    }
+
+    bool IsConnected() const noexcept
+    {
+        return m_connection.has_value();
+    }
+
+    const Stats& GetStats() const noexcept
+    {
+        return m_stats;
+    }
+
+private:
+    Provider m_provider;
+    const std::atomic<uint64_t>& m_desktopListGeneration;
+    std::optional<Connection> m_connection;
+    std::vector<Desktop> m_desktops;
+    uint64_t m_desktopsGeneration{};
+    bool m_desktopsValid{};
+    Stats m_stats;
+};
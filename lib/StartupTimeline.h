@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// When each phase of startup ran, relative to the module being constructed. DataLoad runs on its
+// own thread while FancyZones is created and the hooks are installed, the window waits for it:
+//
+//     Hooks -> DataWait -> Window -> Workers -> ZoneWindows
+//     DataLoad ---------^
+//
+// ShellServices isn't on that path, it's recorded whenever the shell is first needed.
+//
+// Phases are recorded from any thread. Only the first run of a phase is kept, so enabling the
+// module again or reconnecting to the shell doesn't overwrite startup.
+namespace Startup
+{
+    enum class Phase : uint8_t
+    {
+        DataLoad, // Parsing persisted zone data, concurrent with creating FancyZones and the hooks
+        Hooks, // Keyboard and window event hooks
+        DataWait, // Waiting for persisted data, hook events are let through meanwhile
+        Window, // Registering the class and creating the message window
+        Workers, // Starting the background threads
+        ZoneWindows, // Virtual desktops and a zone window per monitor
+        ShellServices, // First connection to the shell's virtual desktop services
+        Count
+    };
+
+    inline constexpr const char* PHASE_NAMES[] = {
+        "dataLoad",
+        "hooks",
+        "dataWait",
+        "window",
+        "workers",
+        "zoneWindows",
+        "shellServices",
+    };
+    static_assert(std::size(PHASE_NAMES) == static_cast<size_t>(Phase::Count));
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Span
+    {
+        bool recorded{};
+        std::chrono::microseconds begin{}; // Since the origin
+        std::chrono::microseconds end{};
+
+        std::chrono::microseconds Duration() const noexcept
+        {
+            return end - begin;
+        }
+    };
+
+    class Timeline
+    {
+    public:
+        // Called once before any phase starts, the threads running phases are started after it.
+        void Start(Clock::time_point origin = Clock::now()) noexcept
+        {
+            m_origin = origin;
+            for (auto& entry : m_entries)
+            {
+                entry.state.store(Empty, std::memory_order_relaxed);
+            }
+        }
+
+        void Record(Phase phase, Clock::time_point begin, Clock::time_point end) noexcept
+        {
+            auto& entry = m_entries[static_cast<size_t>(phase)];
+            uint8_t expected = Empty;
+            if (!entry.state.compare_exchange_strong(expected, Writing, std::memory_order_acquire))
+            {
+                return;
+            }
+            entry.begin = std::chrono::duration_cast<std::chrono::microseconds>(begin - m_origin);
+            entry.end = std::chrono::duration_cast<std::chrono::microseconds>(end - m_origin);
+            entry.state.store(Recorded, std::memory_order_release);
+        }
+
+        Span Get(Phase phase) const noexcept
+        {
+            const auto& entry = m_entries[static_cast<size_t>(phase)];
+            if (entry.state.load(std::memory_order_acquire) != Recorded)
+            {
+                return Span{};
+            }
+            return Span{ true, entry.begin, entry.end };
+        }
+
+        // Origin to the end of the last phase recorded so far.
+        std::chrono::microseconds Elapsed() const noexcept
+        {
+            std::chrono::microseconds elapsed{};
+            for (size_t i = 0; i < static_cast<size_t>(Phase::Count); i++)
+            {
+                const Span span = Get(static_cast<Phase>(i));
+                elapsed = span.recorded && span.end > elapsed ? span.end : elapsed;
+            }
+            return elapsed;
+        }
+
+        // "name begin end duration" lines in microseconds, for recorded phases.
+        void WriteText(std::ostream& stream) const
+        {
+            for (size_t i = 0; i < static_cast<size_t>(Phase::Count); i++)
+            {
+                const Span span = Get(static_cast<Phase>(i));
+                if (span.recorded)
+                {
+                    stream << PHASE_NAMES[i] << " " << span.begin.count() << " " << span.end.count() << " " << span.Duration().count() << "\n";
+                }
+            }
+        }
+
+    private:
+        static constexpr uint8_t Empty = 0;
+        static constexpr uint8_t Writing = 1;
+        static constexpr uint8_t Recorded = 2;
+
+        struct Entry
+        {
+            std::atomic<uint8_t> state{ Empty };
+            std::chrono::microseconds begin{};
+            std::chrono::microseconds end{};
+        };
+
+        Clock::time_point m_origin{ Clock::now() };
+        std::array<Entry, static_cast<size_t>(Phase::Count)> m_entries{};
+    };
+
+    inline Timeline s_timeline{};
+
+    // Records the enclosing scope as a phase.
+    class PhaseTimer
+    {
+    public:
+        explicit PhaseTimer(Phase phase) noexcept :
+            m_phase(phase), m_begin(Clock::now())
+        {
+        }
+
+        ~PhaseTimer()
+        {
+            s_timeline.Record(m_phase, m_begin, Clock::now());
+        }
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    private:
+        const Phase m_phase;
+        const Clock::time_point m_begin;
+    };
+}
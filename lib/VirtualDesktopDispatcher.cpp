@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "VirtualDesktopDispatcher.h"
+
+#include "VirtualDesktopUtils.h"
+
+VirtualDesktopDispatcher::VirtualDesktopDispatcher()
+{
+    // Explorer's interfaces are reached through proxies, which are fine to call from the MTA
+    m_thread.submit(OnThreadExecutor::task_t{ [] {
+        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    } });
+}
+
+VirtualDesktopDispatcher::~VirtualDesktopDispatcher()
+{
+    m_thread.submit(OnThreadExecutor::task_t{ [] {
+                VirtualDesktopUtils::ReleaseShellServices();
+                CoUninitialize();
+            } })
+        .wait();
+}
+
+std::future<bool> VirtualDesktopDispatcher::SwitchTo(UINT index, Completion completion)
+{
+    return Submit([index] { return VirtualDesktopUtils::SwitchToVirtualDesktop(index); }, std::move(completion));
+}
+
+std::future<bool> VirtualDesktopDispatcher::MoveWindowTo(HWND window, UINT index, Completion completion)
+{
+    return Submit([window, index] { return VirtualDesktopUtils::MoveWindowToVirtualDesktop(window, index); }, std::move(completion));
+}
+
+std::future<bool> VirtualDesktopDispatcher::Submit(std::function<bool()> operation, Completion completion)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto result = promise->get_future();
+    m_thread.submit(OnThreadExecutor::task_t{ [promise, operation = std::move(operation), completion = std::move(completion)] {
+        const bool succeeded = operation();
+        promise->set_value(succeeded);
+        if (completion)
+        {
+            completion(succeeded);
+        }
+    } });
+    return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <common/on_thread_executor.h>
+
+#include <functional>
+#include <future>
+
+/**
+ * Virtual desktop operations are cross-process COM calls to Explorer, which can take a long time
+ * when Explorer is busy. They're queued here and run in order on a dedicated thread, so the
+ * keyboard hook only has to enqueue them.
+ */
+class VirtualDesktopDispatcher
+{
+public:
+    /**
+     * Called on the dispatcher thread when an operation finished, with its result.
+     */
+    using Completion = std::function<void(bool)>;
+
+    VirtualDesktopDispatcher();
+    ~VirtualDesktopDispatcher();
+
+    VirtualDesktopDispatcher(const VirtualDesktopDispatcher&) = delete;
+    VirtualDesktopDispatcher& operator=(const VirtualDesktopDispatcher&) = delete;
+
+    /**
+     * Queue switch to virtual desktop.
+     *
+     * @param   index      Zero-based index of virtual desktop.
+     * @param   completion Optional callback, e.g. to retile once the switch is made.
+     *
+     * @returns Future holding false if there's no virtual desktop with given index.
+     */
+    std::future<bool> SwitchTo(UINT index, Completion completion = nullptr);
+
+    /**
+     * Queue moving window to virtual desktop.
+     *
+     * @param   window     Handle of top-level window to move.
+     * @param   index      Zero-based index of virtual desktop.
+     * @param   completion Optional callback, e.g. to retile once the window is gone.
+     *
+     * @returns Future holding false if there's no virtual desktop with given index.
+     */
+    std::future<bool> MoveWindowTo(HWND window, UINT index, Completion completion = nullptr);
+
+private:
+    std::future<bool> Submit(std::function<bool()> operation, Completion completion);
+
+    OnThreadExecutor m_thread;
+};
@@ -1,6 +1,8 @@
 #include "pch.h"
 
 #include "VirtualDesktopUtils.h"
+#include "ShellServiceBroker.h"
+#include "StartupTimeline.h"
 #include <objbase.h>
 #include <ObjectArray.h>
 #include <comip.h>
@@ -17,50 +19,115 @@ namespace VirtualDesktopUtils
     const IID IID_IApplicatonView = { 0x9AC0B5C8, 0x1484, 0x4C5B, 0x95, 0x33, 0x41, 0x34, 0xA0, 0xF9, 0x7C, 0xEA };
     const IID IID_IApplicatonViewCollection = { 0x1841C6D7, 0x4F9D, 0x42C0, 0xAF, 0x41, 0x87, 0x47, 0x53, 0x8F, 0x10, 0xE5 };
 
-    const wchar_t GUID_EmptyGUID[] = L"{00000000-0000-0000-0000-000000000000}";
-
     const wchar_t RegCurrentVirtualDesktop[] = L"CurrentVirtualDesktop";
     const wchar_t RegVirtualDesktopIds[] = L"VirtualDesktopIDs";
     const wchar_t RegKeyVirtualDesktops[] = L"Software\\Microsoft\\Windows\\CurrentVersion\\Explorer\\VirtualDesktops";
 
-    IServiceProvider* GetServiceProvider()
+    namespace
     {
-        IServiceProvider* provider{ nullptr };
-        if (FAILED(CoCreateInstance(CLSID_ImmersiveShell, nullptr, CLSCTX_LOCAL_SERVER, __uuidof(provider), (PVOID*)&provider)))
+        struct ShellConnection
+        {
+            winrt::com_ptr<IServiceProvider> serviceProvider;
+            winrt::com_ptr<IVirtualDesktopManager> manager;
+            winrt::com_ptr<IVirtualDesktopManagerInternal> managerInternal;
+            winrt::com_ptr<IApplicationViewCollection> applicationViews;
+        };
+
+        ShellCallResult ToShellCallResult(HRESULT hr) noexcept
         {
-            return nullptr;
+            if (SUCCEEDED(hr))
+            {
+                return ShellCallResult::Succeeded;
+            }
+
+            switch (hr)
+            {
+            case RPC_E_DISCONNECTED:
+            case RPC_E_SERVER_DIED:
+            case RPC_E_SERVER_DIED_DNE:
+            case HRESULT_FROM_WIN32(RPC_S_SERVER_UNAVAILABLE):
+            case HRESULT_FROM_WIN32(RPC_S_CALL_FAILED):
+                return ShellCallResult::Disconnected;
+            default:
+                return ShellCallResult::Failed;
+            }
         }
-        return provider;
-    }
 
-    IVirtualDesktopManager* GetVirtualDesktopManager(void)
-    {
-        IVirtualDesktopManager* manager{ nullptr };
-        IServiceProvider* serviceProvider = GetServiceProvider();
-        if (serviceProvider == nullptr || FAILED(serviceProvider->QueryService(__uuidof(manager), &manager)))
+        struct ImmersiveShellProvider
+        {
+            using Connection = ShellConnection;
+            using Desktop = winrt::com_ptr<IVirtualDesktop>;
+
+            ShellCallResult Connect(ShellConnection& connection)
+            {
+                // Connected on first use rather than at startup, the timeline keeps the first connection
+                Startup::PhaseTimer timer(Startup::Phase::ShellServices);
+                const HRESULT hr = CoCreateInstance(CLSID_ImmersiveShell, nullptr, CLSCTX_LOCAL_SERVER, IID_PPV_ARGS(connection.serviceProvider.put()));
+                if (FAILED(hr))
+                {
+                    return ToShellCallResult(hr);
+                }
+
+                // Undocumented services may be missing, only calls which need them fail then
+                connection.serviceProvider->QueryService(__uuidof(IVirtualDesktopManager), connection.manager.put());
+                connection.serviceProvider->QueryService(CLSID_VirtualDesktopAPI_Unknown, connection.managerInternal.put());
+                connection.serviceProvider->QueryService(IID_IApplicatonViewCollection, connection.applicationViews.put());
+                return ShellCallResult::Succeeded;
+            }
+
+            ShellCallResult ListDesktops(ShellConnection& connection, std::vector<Desktop>& desktops)
+            {
+                if (!connection.managerInternal)
+                {
+                    return ShellCallResult::Failed;
+                }
+
+                winrt::com_ptr<IObjectArray> desktopArray;
+                HRESULT hr = connection.managerInternal->GetDesktops(desktopArray.put());
+                UINT count = 0;
+                if (SUCCEEDED(hr))
+                {
+                    hr = desktopArray->GetCount(&count);
+                }
+
+                desktops.reserve(count);
+                for (UINT i = 0; SUCCEEDED(hr) && i < count; i++)
+                {
+                    Desktop desktop;
+                    hr = desktopArray->GetAt(i, IID_PPV_ARGS(desktop.put()));
+                    desktops.push_back(std::move(desktop));
+                }
+                return ToShellCallResult(hr);
+            }
+        };
+
+        std::atomic<uint64_t> s_desktopListGeneration{ 0 };
+
+        // Interfaces are proxies tied to the apartment of the thread which obtained them, so every
+        // thread talking to the shell gets a broker of its own.
+        ShellServiceBroker<ImmersiveShellProvider>& Broker()
         {
-            return nullptr;
+            thread_local ShellServiceBroker<ImmersiveShellProvider> broker(s_desktopListGeneration);
+            return broker;
         }
-        return manager;
     }
 
     bool GetWindowDesktopId(HWND topLevelWindow, GUID* desktopId)
     {
-        static IVirtualDesktopManager* virtualDesktopManager = GetVirtualDesktopManager();
-        return (virtualDesktopManager != nullptr) &&
-               SUCCEEDED(virtualDesktopManager->GetWindowDesktopId(topLevelWindow, desktopId));
+        return Broker().Invoke([&](ShellConnection& connection) {
+            if (!connection.manager)
+            {
+                return ShellCallResult::Failed;
+            }
+            return ToShellCallResult(connection.manager->GetWindowDesktopId(topLevelWindow, desktopId));
+        }) == ShellCallResult::Succeeded;
     }
 
     bool GetZoneWindowDesktopId(IZoneWindow* zoneWindow, GUID* desktopId)
     {
-        // Format: <device-id>_<resolution>_<virtual-desktop-id>
-        std::wstring uniqueId = zoneWindow->UniqueId();
-        std::wstring virtualDesktopId = uniqueId.substr(uniqueId.rfind('_') + 1);
-        if (virtualDesktopId == GUID_EmptyGUID)
-        {
-            return false;
-        }
-        return SUCCEEDED(CLSIDFromString(virtualDesktopId.c_str(), desktopId));
+        // Parsed from the unique id when the zone window was made, it's compared on every placement
+        *desktopId = zoneWindow->VirtualDesktopId();
+        return *desktopId != GUID_NULL;
     }
 
     bool GetDesktopIdFromCurrentSession(GUID* desktopId)
@@ -201,72 +268,73 @@ namespace VirtualDesktopUtils
         }
     }
 
-    IVirtualDesktopManagerInternal* GetVirtualDesktopInternal()
+    void InvalidateVirtualDesktops()
     {
-        IVirtualDesktopManagerInternal* manager{ nullptr };
-        IServiceProvider* serviceProvider = GetServiceProvider();
-        if (FAILED(serviceProvider->QueryService(CLSID_VirtualDesktopAPI_Unknown, &manager)))
-        {
-            return nullptr;
-        }
-        return manager;
+        s_desktopListGeneration.fetch_add(1, std::memory_order_release);
     }
 
-    IVirtualDesktop* GetVirtualDesktopFromIndex(UINT index)
+    void ReleaseShellServices()
     {
-        static IVirtualDesktopManagerInternal* manager = GetVirtualDesktopInternal();
-
-        if (!manager)
-        {
-            return nullptr;
-        }
-
-        IObjectArray* desktops = nullptr;
-        if (FAILED(manager->GetDesktops(&desktops)))
-        {
-            return nullptr;
-        }
-
-        IVirtualDesktop* desktop = nullptr;
-        if (FAILED(desktops->GetAt(index, IID_PPV_ARGS(&desktop))) || desktop == nullptr)
-        {
-            return nullptr;
-        }
-
-        return desktop;
+        Broker().Disconnect();
     }
 
     bool SwitchToVirtualDesktop(UINT index)
     {
-        static IVirtualDesktopManagerInternal* manager = GetVirtualDesktopInternal();
-        IVirtualDesktop* desktop = GetVirtualDesktopFromIndex(index);
-        if (desktop != nullptr)
-        {
-            manager->SwitchDesktop(desktop);
-            return true;
-        }
-        return false;
+        auto& broker = Broker();
+        return broker.Invoke([&](ShellConnection& connection) {
+            ImmersiveShellProvider::Desktop desktop;
+            const ShellCallResult result = broker.DesktopAt(connection, index, desktop);
+            if (result != ShellCallResult::Succeeded)
+            {
+                return result;
+            }
+            return ToShellCallResult(connection.managerInternal->SwitchDesktop(desktop.get()));
+        }) == ShellCallResult::Succeeded;
     }
 
-    IApplicationViewCollection* GetApplicationViewCollection(void)
+    bool MoveWindowToVirtualDesktop(HWND window, UINT index)
     {
-        IApplicationViewCollection* collection;
-        GetServiceProvider()->QueryService(IID_IApplicatonViewCollection, &collection);
-        return collection;
+        auto& broker = Broker();
+        return broker.Invoke([&](ShellConnection& connection) {
+            if (!connection.applicationViews)
+            {
+                return ShellCallResult::Failed;
+            }
+
+            winrt::com_ptr<IApplicationView> view;
+            ShellCallResult result = ToShellCallResult(connection.applicationViews->GetViewForHwnd(window, view.put()));
+            if (result != ShellCallResult::Succeeded || !view)
+            {
+                return view ? result : ShellCallResult::Failed;
+            }
+
+            ImmersiveShellProvider::Desktop desktop;
+            result = broker.DesktopAt(connection, index, desktop);
+            if (result != ShellCallResult::Succeeded)
+            {
+                return result;
+            }
+            return ToShellCallResult(connection.managerInternal->MoveViewToDesktop(view.get(), desktop.get()));
+        }) == ShellCallResult::Succeeded;
     }
 
-    bool MoveWindowToVirtualDesktop(HWND window, UINT index)
+    bool IsApplicationViewVisible(HWND window)
     {
-        static IVirtualDesktopManagerInternal* manager = GetVirtualDesktopInternal();
-        IVirtualDesktop* desktop = GetVirtualDesktopFromIndex(index);
-        if (desktop == nullptr)
-        {
-            return false;
-        }
-        IApplicationViewCollection* applications = GetApplicationViewCollection();
-        IApplicationView* applicationView;
-        applications->GetViewForHwnd(window, &applicationView);
-        manager->MoveViewToDesktop(applicationView, desktop);
-        return true;
+        int visible = 0;
+        const ShellCallResult result = Broker().Invoke([&](ShellConnection& connection) {
+            if (!connection.applicationViews)
+            {
+                return ShellCallResult::Failed;
+            }
+
+            winrt::com_ptr<IApplicationView> view;
+            const ShellCallResult viewResult = ToShellCallResult(connection.applicationViews->GetViewForHwnd(window, view.put()));
+            if (viewResult != ShellCallResult::Succeeded || !view)
+            {
+                return view ? viewResult : ShellCallResult::Failed;
+            }
+            return ToShellCallResult(view->GetVisibility(&visible));
+        });
+        return result == ShellCallResult::Succeeded && visible;
     }
 }
@@ -206,6 +206,9 @@ namespace VirtualDesktopUtils
     void HandleVirtualDesktopUpdates(HWND window, UINT message, HANDLE terminateEvent);
     bool SwitchToVirtualDesktop(UINT index);
     bool MoveWindowToVirtualDesktop(HWND window, UINT index);
-    IApplicationViewCollection* GetApplicationViewCollection(void);
-    IVirtualDesktopManager* GetVirtualDesktopManager(void);
+    bool IsApplicationViewVisible(HWND window);
+    // Desktop list is cached, drop it when desktops are created, deleted or reordered.
+    void InvalidateVirtualDesktops();
+    // Release shell interfaces held for the calling thread, before it leaves its COM apartment.
+    void ReleaseShellServices();
 }
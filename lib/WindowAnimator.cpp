@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "WindowAnimator.h"
+
+#include "FrameScheduler.h"
+#include "MonitorTopology.h"
+#include "Platform.h"
+#include "util.h"
+
+namespace
+{
+    constexpr std::chrono::milliseconds ANIMATION_LENGTH{ 150 };
+    constexpr UINT DEFAULT_REFRESH_RATE = 60;
+
+    thread_local WindowAnimator::Batch* t_activeBatch = nullptr;
+
+    std::chrono::steady_clock::duration GetFrameInterval() noexcept
+    {
+        using duration = std::chrono::steady_clock::duration;
+        const duration fallback = std::chrono::duration_cast<duration>(std::chrono::seconds{ 1 }) / DEFAULT_REFRESH_RATE;
+
+        // Composition rate is exact, e.g. 60000/1001 for 59.94 Hz
+        DWM_TIMING_INFO timingInfo{};
+        timingInfo.cbSize = sizeof(timingInfo);
+        if (SUCCEEDED(DwmGetCompositionTimingInfo(nullptr, &timingInfo)))
+        {
+            return FrameScheduling::FrameInterval(timingInfo.rateRefresh.uiNumerator, timingInfo.rateRefresh.uiDenominator, fallback);
+        }
+
+        // Whole Hz only, but better than assuming 60
+        DEVMODEW mode{};
+        mode.dmSize = sizeof(mode);
+        if (EnumDisplaySettingsW(nullptr, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1)
+        {
+            return FrameScheduling::FrameInterval(mode.dmDisplayFrequency, 1, fallback);
+        }
+        return fallback;
+    }
+
+    // Offset between workspace coordinates (used by WINDOWPLACEMENT) and screen coordinates.
+    POINT GetWorkspaceOffset(const RECT& rect) noexcept
+    {
+        const auto topology = MonitorTopologyInstance().Current(PlatformInstance());
+        if (const auto info = topology->FromRect(rect))
+        {
+            return POINT{ info->workArea.left - info->rect.left, info->workArea.top - info->rect.top };
+        }
+        return POINT{};
+    }
+
+    // Sleeps by waiting for DWM composition, so frames land on display refresh.
+    struct DwmPacedClock
+    {
+        using duration = std::chrono::steady_clock::duration;
+        using time_point = std::chrono::steady_clock::time_point;
+
+        time_point now() const noexcept { return std::chrono::steady_clock::now(); }
+
+        void sleep_until(time_point deadline) const noexcept
+        {
+            while (now() < deadline)
+            {
+                if (FAILED(DwmFlush()))
+                {
+                    std::this_thread::sleep_until(deadline);
+                    return;
+                }
+            }
+        }
+    };
+
+    struct DeferWindowPosBackend
+    {
+        std::vector<std::pair<HWND, RECT>> workspaceTargets;
+
+        void PresentFrame(const std::vector<std::pair<HWND, RECT>>& frame) noexcept
+        {
+            constexpr UINT flags = SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOOWNERZORDER;
+            HDWP hdwp = BeginDeferWindowPos(static_cast<int>(frame.size()));
+            for (const auto& [window, rect] : frame)
+            {
+                if (hdwp)
+                {
+                    hdwp = DeferWindowPos(hdwp, window, nullptr, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, flags);
+                }
+            }
+
+            if (!hdwp || !EndDeferWindowPos(hdwp))
+            {
+                for (const auto& [window, rect] : frame)
+                {
+                    SetWindowPos(window, nullptr, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, flags | SWP_ASYNCWINDOWPOS);
+                }
+            }
+        }
+
+        void CommitFrame(const std::vector<std::pair<HWND, RECT>>&) noexcept
+        {
+            // Final placement goes through the regular path, with the original workspace rects.
+            for (const auto& [window, rect] : workspaceTargets)
+            {
+                PlatformInstance().PlaceWindow(window, rect);
+            }
+        }
+    };
+}
+
+WindowAnimator::WindowAnimator()
+{
+}
+
+WindowAnimator::~WindowAnimator()
+{
+    // Abandon any animation in flight, the executor joins its thread.
+    m_generation++;
+}
+
+WindowAnimator::Batch::Batch(WindowAnimator& animator, bool enabled) noexcept :
+    m_previous(t_activeBatch)
+{
+    if (enabled)
+    {
+        m_animator = &animator;
+        t_activeBatch = this;
+    }
+}
+
+WindowAnimator::Batch::~Batch()
+{
+    if (m_animator)
+    {
+        t_activeBatch = m_previous;
+        if (!m_placements.empty())
+        {
+            m_animator->Animate(std::move(m_placements));
+        }
+    }
+}
+
+bool WindowAnimator::CollectPlacement(HWND window, const RECT& rect) noexcept
+{
+    auto batch = t_activeBatch;
+    if (!batch || !batch->m_animator)
+    {
+        return false;
+    }
+
+    auto it = std::find_if(batch->m_placements.begin(), batch->m_placements.end(), [window](const auto& placement) {
+        return placement.first == window;
+    });
+    if (it != batch->m_placements.end())
+    {
+        it->second = rect;
+    }
+    else
+    {
+        batch->m_placements.emplace_back(window, rect);
+    }
+    return true;
+}
+
+void WindowAnimator::Animate(std::vector<std::pair<HWND, RECT>> placements) noexcept
+{
+    // A newer batch supersedes the one in flight, it starts from wherever the windows are at that moment.
+    const uint64_t generation = ++m_generation;
+    m_animationThread.submit(OnThreadExecutor::task_t{ [this, generation, placements = std::move(placements)] {
+        // Windows a superseded batch didn't finish are committed to its target, unless this batch moves them again
+        std::erase_if(m_unfinished, [&placements](const auto& unfinished) {
+            return std::any_of(placements.begin(), placements.end(), [&unfinished](const auto& placement) {
+                return placement.first == unfinished.first;
+            });
+        });
+        if (m_generation != generation)
+        {
+            m_unfinished.insert(m_unfinished.end(), placements.begin(), placements.end());
+            return;
+        }
+        for (const auto& [window, rect] : m_unfinished)
+        {
+            PlatformInstance().PlaceWindow(window, rect);
+        }
+        m_unfinished.clear();
+
+        DeferWindowPosBackend backend;
+        std::vector<FrameScheduling::AnimationTarget<HWND, RECT>> targets;
+        for (const auto& [window, rect] : placements)
+        {
+            RECT current{};
+            if (IsWindowVisible(window) && !IsIconic(window) && !IsZoomed(window) && GetWindowRect(window, &current))
+            {
+                const POINT offset = GetWorkspaceOffset(rect);
+                RECT target = rect;
+                OffsetRect(&target, offset.x, offset.y);
+                targets.push_back({ window, current, target });
+                backend.workspaceTargets.emplace_back(window, rect);
+            }
+            else
+            {
+                // Minimized, maximized or hidden windows are not animated.
+                PlatformInstance().PlaceWindow(window, rect);
+            }
+        }
+
+        DwmPacedClock clock;
+        FrameScheduling::FrameScheduler<HWND, RECT, DwmPacedClock, DeferWindowPosBackend> scheduler(clock, backend, GetFrameInterval(), ANIMATION_LENGTH);
+        if (scheduler.Run(targets, [this, generation] { return m_generation != generation; }).cancelled)
+        {
+            m_unfinished = std::move(backend.workspaceTargets);
+        }
+    } });
+}
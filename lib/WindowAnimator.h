@@ -0,0 +1,52 @@
+#pragma once
+
+#include <common/on_thread_executor.h>
+
+#include <atomic>
+
+/**
+ * Optional animated mode for window placement. While a Batch is open on the calling thread,
+ * every SizeWindowToRect request is collected instead of being applied. When the batch closes,
+ * collected windows are interpolated from their current rect to the target rect on a dedicated
+ * thread, paced to the display refresh rate, and finally placed with ApplyWindowPlacement.
+ */
+class WindowAnimator
+{
+public:
+    WindowAnimator();
+    ~WindowAnimator();
+
+    class Batch
+    {
+    public:
+        Batch(WindowAnimator& animator, bool enabled) noexcept;
+        ~Batch();
+
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+    private:
+        friend class WindowAnimator;
+
+        WindowAnimator* m_animator{};
+        Batch* m_previous{};
+        std::vector<std::pair<HWND, RECT>> m_placements;
+    };
+
+    /**
+     * Collect window placement into the batch open on the calling thread, if any.
+     *
+     * @param   window Handle of window which should be placed.
+     * @param   rect   Target rect, in workspace coordinates (same as WINDOWPLACEMENT::rcNormalPosition).
+     *
+     * @returns Boolean indicating if placement was collected and should not be applied immediately.
+     */
+    static bool CollectPlacement(HWND window, const RECT& rect) noexcept;
+
+private:
+    void Animate(std::vector<std::pair<HWND, RECT>> placements) noexcept;
+
+    std::atomic<uint64_t> m_generation{ 0 };
+    std::vector<std::pair<HWND, RECT>> m_unfinished; // Targets of superseded batches, only used on the animation thread
+    OnThreadExecutor m_animationThread;
+};
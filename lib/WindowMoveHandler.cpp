@@ -5,7 +5,9 @@
 #include <common/notifications/fancyzones_notifications.h>
 #include <common/window_helpers.h>
 
+#include "lib/Platform.h"
 #include "lib/Settings.h"
+#include "lib/ZoneNeighborIndex.h"
 #include "lib/ZoneWindow.h"
 #include "lib/util.h"
 #include "VirtualDesktopUtils.h"
@@ -51,7 +53,7 @@ public:
     {};
 
     void MoveWindowIntoZoneByIndexSet(HWND window, HMONITOR monitor, const std::vector<int>& indexSet, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap) noexcept;
-    bool MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, bool cycle, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap);
+    bool MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, uint32_t steps, const ZoneNeighborIndex& neighbors, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap);
 
 
 private:
@@ -79,16 +81,16 @@ void WindowMoveHandler::MoveWindowIntoZoneByIndexSet(HWND window, HMONITOR monit
     pimpl->MoveWindowIntoZoneByIndexSet(window, monitor, indexSet, zoneWindowMap);
 }
 
-bool WindowMoveHandler::MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, bool cycle, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap)
+bool WindowMoveHandler::MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, uint32_t steps, const ZoneNeighborIndex& neighbors, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap)
 {
-    return pimpl->MoveWindowIntoZoneByDirection(monitor, window, vkCode, cycle, zoneWindowMap);
+    return pimpl->MoveWindowIntoZoneByDirection(monitor, window, vkCode, steps, neighbors, zoneWindowMap);
 }
 
 void WindowMoveHandlerPrivate::MoveWindowIntoZoneByIndexSet(HWND window, HMONITOR monitor, const std::vector<int>& indexSet, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap) noexcept
 {
     if (window != m_windowMoveSize)
     {
-        const HMONITOR hm = (monitor != nullptr) ? monitor : MonitorFromWindow(window, MONITOR_DEFAULTTONULL);
+        const HMONITOR hm = (monitor != nullptr) ? monitor : PlatformInstance().MonitorOfWindow(window);
         if (hm)
         {
             auto zoneWindow = zoneWindowMap.find(hm);
@@ -110,13 +112,57 @@ void WindowMoveHandlerPrivate::MoveWindowIntoZoneByIndexSet(HWND window, HMONITO
     }
 }
 
-bool WindowMoveHandlerPrivate::MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, bool cycle, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap)
+bool WindowMoveHandlerPrivate::MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, uint32_t steps, const ZoneNeighborIndex& neighbors, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap)
 {
     auto iter = zoneWindowMap.find(monitor);
-    if (iter != std::end(zoneWindowMap))
+    if (iter == std::end(zoneWindowMap) || !iter->second->ActiveZoneSet())
     {
-        const auto& zoneWindowPtr = iter->second;
-        return zoneWindowPtr->MoveWindowIntoZoneByDirection(window, vkCode, cycle);
+        return false;
+    }
+
+    const auto& zoneWindowPtr = iter->second;
+    const int index = zoneWindowPtr->ActiveZoneSet()->GetZoneIndexFromWindow(window);
+    if (index < 0)
+    {
+        // Not in a zone yet, it goes to the first or last zone of its own monitor
+        return zoneWindowPtr->MoveWindowIntoZoneByDirection(window, vkCode, false);
+    }
+
+    ZoneNeighborIndex::Direction direction;
+    switch (vkCode)
+    {
+    case VK_LEFT:
+        direction = ZoneNeighborIndex::Direction::Left;
+        break;
+    case VK_RIGHT:
+        direction = ZoneNeighborIndex::Direction::Right;
+        break;
+    case VK_UP:
+        direction = ZoneNeighborIndex::Direction::Up;
+        break;
+    case VK_DOWN:
+        direction = ZoneNeighborIndex::Direction::Down;
+        break;
+    default:
+        return false;
+    }
+
+    // Nearest zone that way on any monitor, past the last one it starts over from the other end
+    ZoneNeighborIndex::ZoneRef neighbor{ monitor, index };
+    for (uint32_t step = 0; step < steps && neighbor.Valid(); step++)
+    {
+        neighbor = neighbors.NeighborOrWrap(neighbor, direction);
+    }
+    if (!neighbor.Valid())
+    {
+        return false;
+    }
+
+    if (neighbor.monitor != monitor)
+    {
+        // Forget the window in the zone set it leaves
+        zoneWindowPtr->MoveWindowIntoZoneByIndexSet(window, {});
     }
-    return false;
+    MoveWindowIntoZoneByIndexSet(window, neighbor.monitor, { neighbor.index }, zoneWindowMap);
+    return true;
 }
@@ -2,6 +2,7 @@
 
 interface IFancyZonesSettings;
 interface IZoneWindow;
+class ZoneNeighborIndex;
 
 class WindowMoveHandler
 {
@@ -10,7 +11,7 @@ public:
     ~WindowMoveHandler();
 
     void MoveWindowIntoZoneByIndexSet(HWND window, HMONITOR monitor, const std::vector<int>& indexSet, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap) noexcept;
-    bool MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, bool cycle, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap);
+    bool MoveWindowIntoZoneByDirection(HMONITOR monitor, HWND window, DWORD vkCode, uint32_t steps, const ZoneNeighborIndex& neighbors, const std::map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap);
 
 private:
     class WindowMoveHandlerPrivate* pimpl;
@@ -6,6 +6,8 @@
 #include <common/dpi_aware.h>
 #include <common/monitors.h>
 #include "Zone.h"
+#include "MonitorTopology.h"
+#include "Platform.h"
 #include "Settings.h"
 #include "util.h"
 
@@ -22,7 +24,7 @@ public:
     IFACEMETHODIMP_(RECT) GetZoneRect() noexcept { return m_zoneRect; }
     IFACEMETHODIMP_(void) SetId(size_t id) noexcept { m_id = id; }
     IFACEMETHODIMP_(size_t) Id() noexcept { return m_id; }
-    IFACEMETHODIMP_(RECT) ComputeActualZoneRect(HWND window, HWND zoneWindow) noexcept;
+    IFACEMETHODIMP_(RECT) ComputeActualZoneRect(HWND window, HWND zoneWindow, HMONITOR monitor) noexcept;
 
 private:
     RECT m_zoneRect{};
@@ -30,46 +32,7 @@ private:
     std::map<HWND, RECT> m_windows{};
 };
 
-static BOOL CALLBACK saveDisplayToVector(HMONITOR monitor, HDC hdc, LPRECT rect, LPARAM data)
-{
-    reinterpret_cast<std::vector<HMONITOR>*>(data)->emplace_back(monitor);
-    return true;
-}
-
-bool allMonitorsHaveSameDpiScaling()
-{
-    std::vector<HMONITOR> monitors;
-    EnumDisplayMonitors(NULL, NULL, saveDisplayToVector, reinterpret_cast<LPARAM>(&monitors));
-
-    if (monitors.size() < 2)
-    {
-        return true;
-    }
-
-    UINT firstMonitorDpiX;
-    UINT firstMonitorDpiY;
-
-    if (S_OK != GetDpiForMonitor(monitors[0], MDT_EFFECTIVE_DPI, &firstMonitorDpiX, &firstMonitorDpiY))
-    {
-        return false;
-    }
-
-    for (int i = 1; i < monitors.size(); i++)
-    {
-        UINT iteratedMonitorDpiX;
-        UINT iteratedMonitorDpiY;
-
-        if (S_OK != GetDpiForMonitor(monitors[i], MDT_EFFECTIVE_DPI, &iteratedMonitorDpiX, &iteratedMonitorDpiY) ||
-            iteratedMonitorDpiX != firstMonitorDpiX)
-        {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-RECT Zone::ComputeActualZoneRect(HWND window, HWND zoneWindow) noexcept
+RECT Zone::ComputeActualZoneRect(HWND window, HWND zoneWindow, HMONITOR monitor) noexcept
 {
     // Take care of 1px border
     RECT newWindowRect = m_zoneRect;
@@ -95,19 +58,20 @@ RECT Zone::ComputeActualZoneRect(HWND window, HWND zoneWindow) noexcept
     // Map to screen coords
     MapWindowRect(zoneWindow, nullptr, &newWindowRect);
 
-    MONITORINFO mi{ sizeof(mi) };
-    if (GetMonitorInfoW(MonitorFromWindow(zoneWindow, MONITOR_DEFAULTTONEAREST), &mi))
+    // Geometry of the zone window's monitor as of the last topology change
+    const auto topology = MonitorTopologyInstance().Current(PlatformInstance());
+    if (const auto info = topology->Find(monitor))
     {
-        const auto taskbar_left_size = std::abs(mi.rcMonitor.left - mi.rcWork.left);
-        const auto taskbar_top_size = std::abs(mi.rcMonitor.top - mi.rcWork.top);
+        const auto taskbar_left_size = std::abs(info->rect.left - info->workArea.left);
+        const auto taskbar_top_size = std::abs(info->rect.top - info->workArea.top);
         OffsetRect(&newWindowRect, -taskbar_left_size, -taskbar_top_size);
 
-        if (accountForUnawareness && !allMonitorsHaveSameDpiScaling())
+        if (accountForUnawareness && !topology->uniformDpi)
         {
-            newWindowRect.left = max(mi.rcMonitor.left, newWindowRect.left);
-            newWindowRect.right = min(mi.rcMonitor.right - taskbar_left_size, newWindowRect.right);
-            newWindowRect.top = max(mi.rcMonitor.top, newWindowRect.top);
-            newWindowRect.bottom = min(mi.rcMonitor.bottom - taskbar_top_size, newWindowRect.bottom);
+            newWindowRect.left = max(info->rect.left, newWindowRect.left);
+            newWindowRect.right = min(info->rect.right - taskbar_left_size, newWindowRect.right);
+            newWindowRect.top = max(info->rect.top, newWindowRect.top);
+            newWindowRect.bottom = min(info->rect.bottom - taskbar_top_size, newWindowRect.bottom);
         }
     }
 
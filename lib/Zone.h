@@ -23,9 +23,10 @@ interface __declspec(uuid("{8228E934-B6EF-402A-9892-15A1441BF8B0}")) IZone : pub
      * @param   window     Handle of window which should be assigned to zone.
      * @param   zoneWindow The m_window of a ZoneWindow, it's a hidden window representing the
      *                     current monitor desktop work area.
+     * @param   monitor    Monitor of the zone window.
      * @returns a RECT structure, describing global coordinates to which a window should be resized
      */
-    IFACEMETHOD_(RECT, ComputeActualZoneRect)(HWND window, HWND zoneWindow) = 0;
+    IFACEMETHOD_(RECT, ComputeActualZoneRect)(HWND window, HWND zoneWindow, HMONITOR monitor) = 0;
 
 };
 
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// Nearest zone in each direction, over the zones of every monitor in virtual-screen coordinates,
+// so a directional move is one lookup wherever the window is. Zone b is a candidate to the right
+// of zone a if b's center is right of a's and b extends further right; candidates are ranked by
+//   1. whether they overlap a vertically, overlapping ones first,
+//   2. the gap between a's right edge and b's left edge, none if they overlap,
+//   3. the distance between their vertical centers,
+// then by monitor handle and zone index, so the result doesn't depend on the order zones were
+// added in. Other directions are the same, mirrored or transposed.
+class ZoneNeighborIndex
+{
+public:
+    enum class Direction : uint8_t
+    {
+        Left,
+        Right,
+        Up,
+        Down,
+        Count
+    };
+
+    struct ZoneRef
+    {
+        Platform::MonitorHandle monitor{};
+        int index{ -1 }; // In the monitor's active zone set
+
+        bool Valid() const noexcept
+        {
+            return index >= 0;
+        }
+
+        bool operator==(const ZoneRef& other) const noexcept
+        {
+            return monitor == other.monitor && index == other.index;
+        }
+    };
+
+    // Replaces the zones of a monitor, none removes it. Only zones whose neighbor was on the monitor
+    // are ranked against every zone again, the others are only compared with the new zones.
+    void SetMonitorZones(Platform::MonitorHandle monitor, const std::vector<Platform::Rect>& zones)
+    {
+        RemoveBlock(monitor);
+
+        // Zones whose neighbor was just removed
+        std::vector<size_t>& stale = m_stale;
+        stale.clear();
+        for (size_t i = 0; i < m_nodes.size(); i++)
+        {
+            for (const auto& neighbor : m_nodes[i].neighbors)
+            {
+                if (neighbor.monitor == monitor)
+                {
+                    stale.push_back(i);
+                    break;
+                }
+            }
+        }
+
+        const size_t first = m_nodes.size();
+        if (!zones.empty())
+        {
+            m_blocks.push_back(Block{ monitor, first, zones.size() });
+        }
+        for (size_t i = 0; i < zones.size(); i++)
+        {
+            m_nodes.push_back(Node{ ZoneRef{ monitor, static_cast<int>(i) }, zones[i] });
+        }
+
+        size_t nextStale = 0;
+        for (size_t i = 0; i < first; i++)
+        {
+            if (nextStale < stale.size() && stale[nextStale] == i)
+            {
+                nextStale++;
+                Rank(i, 0, m_nodes.size());
+            }
+            else
+            {
+                Merge(i, first, m_nodes.size());
+            }
+        }
+        for (size_t i = first; i < m_nodes.size(); i++)
+        {
+            Rank(i, 0, m_nodes.size());
+        }
+    }
+
+    void RemoveMonitor(Platform::MonitorHandle monitor)
+    {
+        SetMonitorZones(monitor, {});
+    }
+
+    void Clear() noexcept
+    {
+        m_nodes.clear();
+        m_blocks.clear();
+    }
+
+    // Invalid if the zone isn't known or has no neighbor that way.
+    ZoneRef Neighbor(ZoneRef zone, Direction direction) const noexcept
+    {
+        for (const auto& block : m_blocks)
+        {
+            if (block.monitor == zone.monitor)
+            {
+                return zone.index >= 0 && static_cast<size_t>(zone.index) < block.count ?
+                           m_nodes[block.first + zone.index].neighbors[static_cast<size_t>(direction)] :
+                           ZoneRef{};
+            }
+        }
+        return ZoneRef{};
+    }
+
+    // Neighbor that way, or if there's none the farthest zone the opposite way, so repeated moves go
+    // around. Invalid only if the zone isn't known.
+    ZoneRef NeighborOrWrap(ZoneRef zone, Direction direction) const noexcept
+    {
+        const auto neighbor = Neighbor(zone, direction);
+        if (neighbor.Valid() || !Find(zone).Valid())
+        {
+            return neighbor;
+        }
+
+        // Neighbors are always further that way, so the walk ends. A zone alone in its row is its own.
+        ZoneRef farthest = zone;
+        for (auto next = Neighbor(zone, Opposite(direction)); next.Valid(); next = Neighbor(next, Opposite(direction)))
+        {
+            farthest = next;
+        }
+        return farthest;
+    }
+
+    size_t Size() const noexcept
+    {
+        return m_nodes.size();
+    }
+
+    // Zone pairs ranked so far, to see how much an update cost.
+    uint64_t Comparisons() const noexcept
+    {
+        return m_comparisons;
+    }
+
+private:
+    static constexpr size_t DIRECTIONS = static_cast<size_t>(Direction::Count);
+
+    // Lower is better, the tie-breakers make it a total order
+    using Score = std::tuple<bool, int64_t, int64_t, uintptr_t, int>;
+
+    struct Node
+    {
+        ZoneRef ref;
+        Platform::Rect rect{};
+        std::array<ZoneRef, DIRECTIONS> neighbors{};
+        std::array<Score, DIRECTIONS> scores{};
+    };
+
+    // Zones of a monitor are contiguous, in zone index order
+    struct Block
+    {
+        Platform::MonitorHandle monitor{};
+        size_t first{};
+        size_t count{};
+    };
+
+    // A rect seen from a direction: near and far edge along it, low and high edge across it.
+    struct Span
+    {
+        int64_t nearEdge;
+        int64_t farEdge;
+        int64_t low;
+        int64_t high;
+    };
+
+    static Direction Opposite(Direction direction) noexcept
+    {
+        switch (direction)
+        {
+        case Direction::Left:
+            return Direction::Right;
+        case Direction::Right:
+            return Direction::Left;
+        case Direction::Up:
+            return Direction::Down;
+        default:
+            return Direction::Up;
+        }
+    }
+
+    // The zone itself if it's known, invalid otherwise.
+    ZoneRef Find(ZoneRef zone) const noexcept
+    {
+        for (const auto& block : m_blocks)
+        {
+            if (block.monitor == zone.monitor)
+            {
+                return zone.index >= 0 && static_cast<size_t>(zone.index) < block.count ? zone : ZoneRef{};
+            }
+        }
+        return ZoneRef{};
+    }
+
+    static Span Project(const Platform::Rect& rect, Direction direction) noexcept
+    {
+        switch (direction)
+        {
+        case Direction::Left:
+            return Span{ -static_cast<int64_t>(rect.right), -static_cast<int64_t>(rect.left), rect.top, rect.bottom };
+        case Direction::Right:
+            return Span{ rect.left, rect.right, rect.top, rect.bottom };
+        case Direction::Up:
+            return Span{ -static_cast<int64_t>(rect.bottom), -static_cast<int64_t>(rect.top), rect.left, rect.right };
+        default:
+            return Span{ rect.top, rect.bottom, rect.left, rect.right };
+        }
+    }
+
+    // False if to isn't a candidate from from.
+    bool Evaluate(const Node& from, const Node& to, Direction direction, Score& score) noexcept
+    {
+        m_comparisons++;
+        const Span a = Project(from.rect, direction);
+        const Span b = Project(to.rect, direction);
+        if (b.nearEdge + b.farEdge <= a.nearEdge + a.farEdge || b.farEdge <= a.farEdge)
+        {
+            return false;
+        }
+
+        const int64_t overlap = (std::min)(a.high, b.high) - (std::max)(a.low, b.low);
+        const int64_t gap = (std::max)(static_cast<int64_t>(0), b.nearEdge - a.farEdge);
+        const int64_t centers = (b.low + b.high) - (a.low + a.high);
+        score = Score{ overlap <= 0, gap, centers < 0 ? -centers : centers, reinterpret_cast<uintptr_t>(to.ref.monitor), to.ref.index };
+        return true;
+    }
+
+    // Neighbors of node i among nodes [begin, end) only.
+    void Rank(size_t i, size_t begin, size_t end) noexcept
+    {
+        auto& node = m_nodes[i];
+        node.neighbors.fill(ZoneRef{});
+        Merge(i, begin, end);
+    }
+
+    // Keeps node i's neighbors unless one of nodes [begin, end) is better.
+    void Merge(size_t i, size_t begin, size_t end) noexcept
+    {
+        auto& node = m_nodes[i];
+        for (size_t d = 0; d < DIRECTIONS; d++)
+        {
+            for (size_t j = begin; j < end; j++)
+            {
+                Score score;
+                if (j != i && Evaluate(node, m_nodes[j], static_cast<Direction>(d), score) &&
+                    (!node.neighbors[d].Valid() || score < node.scores[d]))
+                {
+                    node.neighbors[d] = m_nodes[j].ref;
+                    node.scores[d] = score;
+                }
+            }
+        }
+    }
+
+    void RemoveBlock(Platform::MonitorHandle monitor)
+    {
+        for (size_t b = 0; b < m_blocks.size(); b++)
+        {
+            if (m_blocks[b].monitor == monitor)
+            {
+                const Block removed = m_blocks[b];
+                m_nodes.erase(m_nodes.begin() + removed.first, m_nodes.begin() + removed.first + removed.count);
+                m_blocks.erase(m_blocks.begin() + b);
+                for (auto& block : m_blocks)
+                {
+                    block.first -= block.first > removed.first ? removed.count : 0;
+                }
+                return;
+            }
+        }
+    }
+
+    std::vector<Node> m_nodes;
+    std::vector<Block> m_blocks;
+    std::vector<size_t> m_stale;
+    uint64_t m_comparisons{};
+};
@@ -2,13 +2,14 @@
 
 #include "util.h"
 #include "lib/ZoneSet.h"
+#include "ZoneSetUtils.h"
 #include "Settings.h"
 
 #include <common/dpi_aware.h>
 
 namespace
 {
-    constexpr int C_MULTIPLIER = 10000;
+    using ZoneSetUtils::C_MULTIPLIER;
 
     /*
       struct GridLayoutInfo {
@@ -47,8 +48,12 @@ public:
     ZonesFromPoint(POINT pt) noexcept;
     IFACEMETHODIMP_(std::vector<int>)
     GetZoneIndexSetFromWindow(HWND window) noexcept;
+    IFACEMETHODIMP_(int)
+    GetZoneIndexFromWindow(HWND window) noexcept;
     IFACEMETHODIMP_(std::vector<winrt::com_ptr<IZone>>)
     GetZones() noexcept { return m_zones; }
+    IFACEMETHODIMP_(size_t)
+    ZoneCount() noexcept { return m_zones.size(); }
     IFACEMETHODIMP_(void)
     MoveWindowIntoZoneByIndex(HWND window, HWND zoneWindow, int index, bool stampZone) noexcept;
     IFACEMETHODIMP_(void)
@@ -67,6 +72,10 @@ public:
     SetZoneIndexSetFromWindowDangerously(HWND window, int index) noexcept;
     IFACEMETHODIMP_(void)
     ChangeMainZoneWidth(bool increase) noexcept;
+    IFACEMETHODIMP_(int)
+    MainZoneWidth() noexcept { return m_mainZoneWidth; }
+    IFACEMETHODIMP_(void)
+    ReplaceZones(const std::vector<RECT>& zones, int mainZoneWidth) noexcept;
 
 private:
     bool CalculateFocusLayout(Rect workArea, int zoneCount) noexcept;
@@ -102,76 +111,7 @@ bool ZoneSet::KillZones(void) noexcept
 IFACEMETHODIMP_(std::vector<int>)
 ZoneSet::ZonesFromPoint(POINT pt) noexcept
 {
-    const int SENSITIVITY_RADIUS = 20;
-    std::vector<int> capturedZones;
-    std::vector<int> strictlyCapturedZones;
-    for (size_t i = 0; i < m_zones.size(); i++)
-    {
-        auto zone = m_zones[i];
-        RECT newZoneRect = zone->GetZoneRect();
-        if (newZoneRect.left < newZoneRect.right && newZoneRect.top < newZoneRect.bottom) // proper zone
-        {
-            if (newZoneRect.left - SENSITIVITY_RADIUS <= pt.x && pt.x <= newZoneRect.right + SENSITIVITY_RADIUS &&
-                newZoneRect.top - SENSITIVITY_RADIUS <= pt.y && pt.y <= newZoneRect.bottom + SENSITIVITY_RADIUS)
-            {
-                capturedZones.emplace_back(static_cast<int>(i));
-            }
-            
-            if (newZoneRect.left <= pt.x && pt.x < newZoneRect.right &&
-                newZoneRect.top <= pt.y && pt.y < newZoneRect.bottom)
-            {
-                strictlyCapturedZones.emplace_back(static_cast<int>(i));
-            }
-        }
-    }
-
-    // If only one zone is captured, but it's not strictly captured
-    // don't consider it as captured
-    if (capturedZones.size() == 1 && strictlyCapturedZones.size() == 0)
-    {
-        return {};
-    }
-
-    // If captured zones do not overlap, return all of them
-    // Otherwise, return the smallest one
-
-    bool overlap = false;
-    for (size_t i = 0; i < capturedZones.size(); ++i)
-    {
-        for (size_t j = i + 1; j < capturedZones.size(); ++j)
-        {
-            auto rectI = m_zones[capturedZones[i]]->GetZoneRect();
-            auto rectJ = m_zones[capturedZones[j]]->GetZoneRect();
-            if (max(rectI.top, rectJ.top) < min(rectI.bottom, rectJ.bottom) &&
-                max(rectI.left, rectJ.left) < min(rectI.right, rectJ.right))
-            {
-                overlap = true;
-                i = capturedZones.size() - 1;
-                break;
-            }
-        }
-    }
-
-    if (overlap)
-    {
-        size_t smallestIdx = 0;
-        for (size_t i = 1; i < capturedZones.size(); ++i)
-        {
-            auto rectS = m_zones[capturedZones[smallestIdx]]->GetZoneRect();
-            auto rectI = m_zones[capturedZones[i]]->GetZoneRect();
-            int smallestSize = (rectS.bottom - rectS.top) * (rectS.right - rectS.left);
-            int iSize = (rectI.bottom - rectI.top) * (rectI.right - rectI.left);
-
-            if (iSize <= smallestSize)
-            {
-                smallestIdx = i;
-            }
-        }
-
-        capturedZones = { capturedZones[smallestIdx] };
-    }
-
-    return capturedZones;
+    return ZoneSetUtils::ZonesFromPoint(m_zones.size(), [this](size_t i) { return m_zones[i]->GetZoneRect(); }, pt.x, pt.y);
 }
 
 std::vector<int> ZoneSet::GetZoneIndexSetFromWindow(HWND window) noexcept
@@ -187,6 +127,17 @@ std::vector<int> ZoneSet::GetZoneIndexSetFromWindow(HWND window) noexcept
     }
 }
 
+IFACEMETHODIMP_(int)
+ZoneSet::GetZoneIndexFromWindow(HWND window) noexcept
+{
+    auto it = m_windowIndexSet.find(window);
+    if (it == m_windowIndexSet.end() || it->second.empty())
+    {
+        return -1;
+    }
+    return it->second[0];
+}
+
 IFACEMETHODIMP_(bool)
 ZoneSet::SetZoneIndexSetFromWindowDangerously(HWND window, int index) noexcept
 {
@@ -220,14 +171,15 @@ ZoneSet::MoveWindowIntoZoneByIndexSet(HWND window, HWND windowZone, const std::v
     bool sizeEmpty = true;
     size_t bitmask = 0;
 
+    // Cleared rather than replaced, windows moved again reuse their index set's buffer
     auto& storedIndexSet = m_windowIndexSet[window];
-    storedIndexSet = {};
+    storedIndexSet.clear();
 
     for (int index : indexSet)
     {
         if (index < static_cast<int>(m_zones.size()))
         {
-            RECT newSize = m_zones.at(index)->ComputeActualZoneRect(window, windowZone);
+            RECT newSize = m_zones.at(index)->ComputeActualZoneRect(window, windowZone, m_config.Monitor);
             if (!sizeEmpty)
             {
                 size.left = min(size.left, newSize.left);
@@ -438,69 +390,29 @@ bool ZoneSet::CalculateColumnsAndRowsLayout(Rect workArea, JSONHelpers::ZoneSetL
 
 void ZoneSet::ChangeMainZoneWidth(bool increase) noexcept
 {
-    m_mainZoneWidth = m_mainZoneWidth + (increase ? 500 : -500);
-
-    if (m_mainZoneWidth >= 8500)
-    {
-        m_mainZoneWidth = 8500;
-        return;
-    }
+    m_mainZoneWidth = ZoneSetUtils::ChangeMainZoneWidth(m_mainZoneWidth, increase);
+}
 
-    if (m_mainZoneWidth <= 1500)
+IFACEMETHODIMP_(void)
+ZoneSet::ReplaceZones(const std::vector<RECT>& zones, int mainZoneWidth) noexcept
+{
+    m_zones.clear();
+    for (const auto& zone : zones)
     {
-        m_mainZoneWidth = 1500;
-        return;
+        AddZone(MakeZone(zone));
     }
+    m_mainZoneWidth = mainZoneWidth;
 }
 
 bool ZoneSet::CalculateGridLayout(Rect workArea, JSONHelpers::ZoneSetLayoutType type, int zoneCount, int spacing) noexcept
 {
-    if (zoneCount < 2)
-    {
-        return CalculateGridZones(
-            workArea, 
-            JSONHelpers::GridLayoutInfo(JSONHelpers::GridLayoutInfo::Full{ 
-                .rows = 1, 
-                .columns = 1, 
-                .rowsPercents = { C_MULTIPLIER }, 
-                .columnsPercents = { C_MULTIPLIER }, 
-                .cellChildMap = { { 0 } } }), 
-            spacing
-        );
-    }
-
-    int rows = zoneCount - 1, columns = 2;
-
-    JSONHelpers::GridLayoutInfo gridLayoutInfo(JSONHelpers::GridLayoutInfo::Minimal{ .rows = rows, .columns = columns });
-
-    // Note: The expressions below are NOT equal to C_MULTIPLIER / {rows|columns} and are done
-    // like this to make the sum of all percents exactly C_MULTIPLIER
-    for (int row = 0; row < rows; row++)
-    {
-        gridLayoutInfo.rowsPercents()[row] = C_MULTIPLIER * (row + 1) / rows - C_MULTIPLIER * row / rows;
-    }
-    
-    gridLayoutInfo.columnsPercents()[0] = m_mainZoneWidth;
-    gridLayoutInfo.columnsPercents()[1] = C_MULTIPLIER - m_mainZoneWidth;
-
-    for (int i = 0; i < rows; ++i)
+    std::vector<RECT> zones;
+    const bool success = ZoneSetUtils::CalculateMainZoneLayout(workArea.width(), workArea.height(), zoneCount, spacing, m_mainZoneWidth, zones);
+    for (const auto& zone : zones)
     {
-        gridLayoutInfo.cellChildMap()[i] = std::vector<int>(columns);
+        AddZone(MakeZone(zone));
     }
-
-    int index = 0;
-    for (int col = columns - 1; col >= 0; col--)
-    {
-        for (int row = rows - 1; row >= 0; row--)
-        {
-            gridLayoutInfo.cellChildMap()[row][col] = index++;
-            if (index == zoneCount)
-            {
-                index--;
-            }
-        }
-    }
-    return CalculateGridZones(workArea, gridLayoutInfo, spacing);
+    return success;
 }
 
 bool ZoneSet::CalculateCustomLayout(Rect workArea, int spacing) noexcept
@@ -553,74 +465,12 @@ bool ZoneSet::CalculateCustomLayout(Rect workArea, int spacing) noexcept
 
 bool ZoneSet::CalculateGridZones(Rect workArea, JSONHelpers::GridLayoutInfo gridLayoutInfo, int spacing)
 {
-    bool success = true;
-
-    long totalWidth = workArea.width() - (spacing * (gridLayoutInfo.columns() + 1));
-    long totalHeight = workArea.height() - (spacing * (gridLayoutInfo.rows() + 1));
-    struct Info
-    {
-        long Extent;
-        long Start;
-        long End;
-    };
-    std::vector<Info> rowInfo(gridLayoutInfo.rows());
-    std::vector<Info> columnInfo(gridLayoutInfo.columns());
-
-    // Note: The expressions below are carefully written to 
-    // make the sum of all zones' sizes exactly total{Width|Height}
-    int totalPercents = 0;
-    for (int row = 0; row < gridLayoutInfo.rows(); row++)
+    std::vector<RECT> zones;
+    const bool success = ZoneSetUtils::CalculateGridZones(workArea.width(), workArea.height(), gridLayoutInfo, spacing, zones);
+    for (const auto& zone : zones)
     {
-        rowInfo[row].Start = totalPercents * totalHeight / C_MULTIPLIER + (row + 1) * spacing;
-        totalPercents += gridLayoutInfo.rowsPercents()[row];
-        rowInfo[row].End = totalPercents * totalHeight / C_MULTIPLIER + (row + 1) * spacing;
-        rowInfo[row].Extent = rowInfo[row].End - rowInfo[row].Start;
+        AddZone(MakeZone(zone));
     }
-
-    totalPercents = 0;
-    for (int col = 0; col < gridLayoutInfo.columns(); col++)
-    {
-        columnInfo[col].Start = totalPercents * totalWidth / C_MULTIPLIER + (col + 1) * spacing;
-        totalPercents += gridLayoutInfo.columnsPercents()[col];
-        columnInfo[col].End = totalPercents * totalWidth / C_MULTIPLIER + (col + 1) * spacing;
-        columnInfo[col].Extent = columnInfo[col].End - columnInfo[col].Start;
-    }
-
-    for (int row = 0; row < gridLayoutInfo.rows(); row++)
-    {
-        for (int col = 0; col < gridLayoutInfo.columns(); col++)
-        {
-            int i = gridLayoutInfo.cellChildMap()[row][col];
-            if (((row == 0) || (gridLayoutInfo.cellChildMap()[row - 1][col] != i)) &&
-                ((col == 0) || (gridLayoutInfo.cellChildMap()[row][col - 1] != i)))
-            {
-                long left = columnInfo[col].Start;
-                long top = rowInfo[row].Start;
-
-                int maxRow = row;
-                while (((maxRow + 1) < gridLayoutInfo.rows()) && (gridLayoutInfo.cellChildMap()[maxRow + 1][col] == i))
-                {
-                    maxRow++;
-                }
-                int maxCol = col;
-                while (((maxCol + 1) < gridLayoutInfo.columns()) && (gridLayoutInfo.cellChildMap()[row][maxCol + 1] == i))
-                {
-                    maxCol++;
-                }
-
-                long right = columnInfo[maxCol].End;
-                long bottom = rowInfo[maxRow].End;
-
-                if (left >= right || top >= bottom || left < 0 || right < 0 || top < 0 || bottom < 0)
-                {
-                    success = false;
-                }
-
-                AddZone(MakeZone(RECT{ left, top, right, bottom }));
-            }
-        }
-    }
-
     return success;
 }
 
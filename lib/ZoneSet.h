@@ -37,10 +37,21 @@ interface __declspec(uuid("{E4839EB7-669D-49CF-84A9-71A2DFD851A3}")) IZoneSet :
      * @returns A vector of integers, 0-based, the index set.
      */
     IFACEMETHOD_(std::vector<int>, GetZoneIndexSetFromWindow)(HWND window) = 0;
+    /**
+     * Get the first zone to which the window was assigned, without copying its index set.
+     *
+     * @param   window Handle of the window.
+     * @returns 0-based zone index, -1 if the window isn't assigned to a zone.
+     */
+    IFACEMETHOD_(int, GetZoneIndexFromWindow)(HWND window) = 0;
     /**
      * @returns Array of zone objects (defining coordinates of the zone) inside this zone layout.
      */
     IFACEMETHOD_(std::vector<winrt::com_ptr<IZone>>, GetZones)() = 0;
+    /**
+     * @returns Number of zones inside this zone layout.
+     */
+    IFACEMETHOD_(size_t, ZoneCount)() = 0;
     /**
      * Assign window to the zone based on zone index inside zone layout.
      *
@@ -106,6 +117,17 @@ interface __declspec(uuid("{E4839EB7-669D-49CF-84A9-71A2DFD851A3}")) IZoneSet :
     IFACEMETHOD_(bool, KillZones)(void) = 0;
     IFACEMETHOD_(bool, SetZoneIndexSetFromWindowDangerously)(HWND window, int index) = 0;
     IFACEMETHOD_(void, ChangeMainZoneWidth)(bool increase) = 0;
+    /**
+     * @returns Width of the main zone, in 1/10000 of the work area width.
+     */
+    IFACEMETHOD_(int, MainZoneWidth)() = 0;
+    /**
+     * Replace zones of the layout with ones calculated elsewhere, e.g. on the layout worker thread.
+     *
+     * @param   zones         Zone coordinates, relative to the work area.
+     * @param   mainZoneWidth Width of the main zone the zones were calculated with.
+     */
+    IFACEMETHOD_(void, ReplaceZones)(const std::vector<RECT>& zones, int mainZoneWidth) = 0;
 };
 
 #define VERSION_PERSISTEDDATA 0x0000F00D
@@ -140,4 +162,4 @@ struct ZoneSetConfig
     PCWSTR ResolutionKey{};
 };
 
-winrt::com_ptr<IZoneSet> MakeZoneSet(ZoneSetConfig const& config) noexcept;
\ No newline at end of file
+winrt::com_ptr<IZoneSet> MakeZoneSet(ZoneSetConfig const& config) noexcept;
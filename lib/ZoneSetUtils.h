@@ -0,0 +1,248 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <vector>
+
+// Zone calculation without any zone set state, safe to call from any thread. Zones are relative to
+// the work area, only its size matters, and are appended to the given vector, which allocates.
+namespace ZoneSetUtils
+{
+    // Percents are in hundredths of a percent
+    constexpr int C_MULTIPLIER = 10000;
+
+    // Same accessors as JSONHelpers::GridLayoutInfo, which is what custom grid layouts are read into.
+    class Grid
+    {
+    public:
+        Grid(int rows, int columns) :
+            m_rows(rows),
+            m_columns(columns),
+            m_rowsPercents(rows, 0),
+            m_columnsPercents(columns, 0),
+            m_cellChildMap(rows, std::vector<int>(columns, 0))
+        {
+        }
+
+        int rows() const { return m_rows; }
+        int columns() const { return m_columns; }
+
+        std::vector<int>& rowsPercents() { return m_rowsPercents; }
+        std::vector<int>& columnsPercents() { return m_columnsPercents; }
+        std::vector<std::vector<int>>& cellChildMap() { return m_cellChildMap; }
+
+        const std::vector<int>& rowsPercents() const { return m_rowsPercents; }
+        const std::vector<int>& columnsPercents() const { return m_columnsPercents; }
+        const std::vector<std::vector<int>>& cellChildMap() const { return m_cellChildMap; }
+
+    private:
+        int m_rows;
+        int m_columns;
+        std::vector<int> m_rowsPercents;
+        std::vector<int> m_columnsPercents;
+        std::vector<std::vector<int>> m_cellChildMap;
+    };
+
+    // GridInfo is Grid or JSONHelpers::GridLayoutInfo. Returns false if a zone came out empty or negative.
+    template<typename GridInfo>
+    bool CalculateGridZones(int width, int height, const GridInfo& gridLayoutInfo, int spacing, std::vector<Platform::Rect>& zones)
+    {
+        bool success = true;
+
+        long totalWidth = width - (spacing * (gridLayoutInfo.columns() + 1));
+        long totalHeight = height - (spacing * (gridLayoutInfo.rows() + 1));
+        struct Info
+        {
+            long Extent;
+            long Start;
+            long End;
+        };
+        std::vector<Info> rowInfo(gridLayoutInfo.rows());
+        std::vector<Info> columnInfo(gridLayoutInfo.columns());
+
+        // Note: The expressions below are carefully written to
+        // make the sum of all zones' sizes exactly total{Width|Height}
+        int totalPercents = 0;
+        for (int row = 0; row < gridLayoutInfo.rows(); row++)
+        {
+            rowInfo[row].Start = totalPercents * totalHeight / C_MULTIPLIER + (row + 1) * spacing;
+            totalPercents += gridLayoutInfo.rowsPercents()[row];
+            rowInfo[row].End = totalPercents * totalHeight / C_MULTIPLIER + (row + 1) * spacing;
+            rowInfo[row].Extent = rowInfo[row].End - rowInfo[row].Start;
+        }
+
+        totalPercents = 0;
+        for (int col = 0; col < gridLayoutInfo.columns(); col++)
+        {
+            columnInfo[col].Start = totalPercents * totalWidth / C_MULTIPLIER + (col + 1) * spacing;
+            totalPercents += gridLayoutInfo.columnsPercents()[col];
+            columnInfo[col].End = totalPercents * totalWidth / C_MULTIPLIER + (col + 1) * spacing;
+            columnInfo[col].Extent = columnInfo[col].End - columnInfo[col].Start;
+        }
+
+        for (int row = 0; row < gridLayoutInfo.rows(); row++)
+        {
+            for (int col = 0; col < gridLayoutInfo.columns(); col++)
+            {
+                int i = gridLayoutInfo.cellChildMap()[row][col];
+                if (((row == 0) || (gridLayoutInfo.cellChildMap()[row - 1][col] != i)) &&
+                    ((col == 0) || (gridLayoutInfo.cellChildMap()[row][col - 1] != i)))
+                {
+                    long left = columnInfo[col].Start;
+                    long top = rowInfo[row].Start;
+
+                    int maxRow = row;
+                    while (((maxRow + 1) < gridLayoutInfo.rows()) && (gridLayoutInfo.cellChildMap()[maxRow + 1][col] == i))
+                    {
+                        maxRow++;
+                    }
+                    int maxCol = col;
+                    while (((maxCol + 1) < gridLayoutInfo.columns()) && (gridLayoutInfo.cellChildMap()[row][maxCol + 1] == i))
+                    {
+                        maxCol++;
+                    }
+
+                    long right = columnInfo[maxCol].End;
+                    long bottom = rowInfo[maxRow].End;
+
+                    if (left >= right || top >= bottom || left < 0 || right < 0 || top < 0 || bottom < 0)
+                    {
+                        success = false;
+                    }
+
+                    Platform::Rect zone{};
+                    zone.left = left;
+                    zone.top = top;
+                    zone.right = right;
+                    zone.bottom = bottom;
+                    zones.push_back(zone);
+                }
+            }
+        }
+
+        return success;
+    }
+
+    // Main zone on the left, the others stacked on the right, numbered from the bottom right.
+    inline bool CalculateMainZoneLayout(int width, int height, int zoneCount, int spacing, int mainZoneWidth, std::vector<Platform::Rect>& zones)
+    {
+        if (zoneCount < 2)
+        {
+            Grid grid(1, 1);
+            grid.rowsPercents()[0] = C_MULTIPLIER;
+            grid.columnsPercents()[0] = C_MULTIPLIER;
+            return CalculateGridZones(width, height, grid, spacing, zones);
+        }
+
+        int rows = zoneCount - 1, columns = 2;
+
+        Grid gridLayoutInfo(rows, columns);
+
+        // Note: The expressions below are NOT equal to C_MULTIPLIER / {rows|columns} and are done
+        // like this to make the sum of all percents exactly C_MULTIPLIER
+        for (int row = 0; row < rows; row++)
+        {
+            gridLayoutInfo.rowsPercents()[row] = C_MULTIPLIER * (row + 1) / rows - C_MULTIPLIER * row / rows;
+        }
+
+        gridLayoutInfo.columnsPercents()[0] = mainZoneWidth;
+        gridLayoutInfo.columnsPercents()[1] = C_MULTIPLIER - mainZoneWidth;
+
+        int index = 0;
+        for (int col = columns - 1; col >= 0; col--)
+        {
+            for (int row = rows - 1; row >= 0; row--)
+            {
+                gridLayoutInfo.cellChildMap()[row][col] = index++;
+                if (index == zoneCount)
+                {
+                    index--;
+                }
+            }
+        }
+        return CalculateGridZones(width, height, gridLayoutInfo, spacing, zones);
+    }
+
+    inline int ChangeMainZoneWidth(int mainZoneWidth, bool increase) noexcept
+    {
+        return std::clamp(mainZoneWidth + (increase ? 500 : -500), 1500, 8500);
+    }
+
+    // Zones the point is dragged over, ZoneRect(i) returns the rectangle of zone i, a RECT or a
+    // Platform::Rect. Zones within the sensitivity radius count, one of them has to contain the
+    // point. Of overlapping zones only the smallest is returned.
+    template<typename ZoneRect>
+    std::vector<int> ZonesFromPoint(size_t zoneCount, ZoneRect&& zoneRect, int x, int y)
+    {
+        const int SENSITIVITY_RADIUS = 20;
+        std::vector<int> capturedZones;
+        std::vector<int> strictlyCapturedZones;
+        for (size_t i = 0; i < zoneCount; i++)
+        {
+            const auto newZoneRect = zoneRect(i);
+            if (newZoneRect.left < newZoneRect.right && newZoneRect.top < newZoneRect.bottom) // proper zone
+            {
+                if (newZoneRect.left - SENSITIVITY_RADIUS <= x && x <= newZoneRect.right + SENSITIVITY_RADIUS &&
+                    newZoneRect.top - SENSITIVITY_RADIUS <= y && y <= newZoneRect.bottom + SENSITIVITY_RADIUS)
+                {
+                    capturedZones.emplace_back(static_cast<int>(i));
+                }
+
+                if (newZoneRect.left <= x && x < newZoneRect.right &&
+                    newZoneRect.top <= y && y < newZoneRect.bottom)
+                {
+                    strictlyCapturedZones.emplace_back(static_cast<int>(i));
+                }
+            }
+        }
+
+        // If only one zone is captured, but it's not strictly captured
+        // don't consider it as captured
+        if (capturedZones.size() == 1 && strictlyCapturedZones.size() == 0)
+        {
+            return {};
+        }
+
+        // If captured zones do not overlap, return all of them
+        // Otherwise, return the smallest one
+
+        bool overlap = false;
+        for (size_t i = 0; i < capturedZones.size(); ++i)
+        {
+            for (size_t j = i + 1; j < capturedZones.size(); ++j)
+            {
+                const auto rectI = zoneRect(capturedZones[i]);
+                const auto rectJ = zoneRect(capturedZones[j]);
+                if ((std::max)(rectI.top, rectJ.top) < (std::min)(rectI.bottom, rectJ.bottom) &&
+                    (std::max)(rectI.left, rectJ.left) < (std::min)(rectI.right, rectJ.right))
+                {
+                    overlap = true;
+                    i = capturedZones.size() - 1;
+                    break;
+                }
+            }
+        }
+
+        if (overlap)
+        {
+            size_t smallestIdx = 0;
+            for (size_t i = 1; i < capturedZones.size(); ++i)
+            {
+                const auto rectS = zoneRect(capturedZones[smallestIdx]);
+                const auto rectI = zoneRect(capturedZones[i]);
+                int smallestSize = (rectS.bottom - rectS.top) * (rectS.right - rectS.left);
+                int iSize = (rectI.bottom - rectI.top) * (rectI.right - rectI.left);
+
+                if (iSize <= smallestSize)
+                {
+                    smallestIdx = i;
+                }
+            }
+
+            capturedZones = { capturedZones[smallestIdx] };
+        }
+
+        return capturedZones;
+    }
+}
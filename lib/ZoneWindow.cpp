@@ -2,13 +2,13 @@
 
 
 #include "ZoneWindow.h"
+#include "MonitorTopology.h"
+#include "Platform.h"
 #include "util.h"
 
 #include <ShellScalingApi.h>
 #include <mutex>
 
-#include <gdiplus.h>
-
 namespace ZoneWindowUtils
 {
     const std::wstring& GetActiveZoneSetTmpPath()
@@ -66,14 +66,14 @@ namespace ZoneWindowUtils
     {
         wchar_t uniqueId[256]{}; // Parsed deviceId + resolution + virtualDesktopId
 
-        MONITORINFOEXW mi;
-        mi.cbSize = sizeof(mi);
-        if (virtualDesktopId && GetMonitorInfo(monitor, &mi))
+        const auto topology = MonitorTopologyInstance().Current(PlatformInstance());
+        const auto info = topology->Find(monitor);
+        if (virtualDesktopId && info)
         {
             wchar_t parsedId[256]{};
             ParseDeviceId(deviceId, parsedId, 256);
 
-            Rect const monitorRect(mi.rcMonitor);
+            Rect const monitorRect(info->rect);
             StringCchPrintf(uniqueId, ARRAYSIZE(uniqueId), L"%s_%d_%d_%s", parsedId, monitorRect.width(), monitorRect.height(), virtualDesktopId);
         }
         return std::wstring{ uniqueId };
@@ -84,7 +84,6 @@ struct ZoneWindow : public winrt::implements<ZoneWindow, IZoneWindow>
 {
 public:
     ZoneWindow(HINSTANCE hinstance);
-    ~ZoneWindow();
 
     bool Init(IZoneWindowHost* host, HINSTANCE hinstance, HMONITOR monitor, const std::wstring& uniqueId, bool flashZones, bool newWorkArea);
 
@@ -96,6 +95,8 @@ public:
     MoveWindowIntoZoneByDirection(HWND window, DWORD vkCode, bool cycle) noexcept;
     IFACEMETHODIMP_(std::wstring)
     UniqueId() noexcept { return { m_uniqueId }; }
+    IFACEMETHODIMP_(GUID)
+    VirtualDesktopId() noexcept { return m_virtualDesktopId; }
     IFACEMETHODIMP_(std::wstring)
     WorkAreaKey() noexcept { return { m_workArea }; }
     IFACEMETHODIMP_(void)
@@ -118,14 +119,13 @@ private:
     winrt::com_ptr<IZoneWindowHost> m_host;
     HMONITOR m_monitor{};
     std::wstring m_uniqueId; // Parsed deviceId + resolution + virtualDesktopId
+    GUID m_virtualDesktopId{}; // Parsed from m_uniqueId
     wchar_t m_workArea[256]{};
     wil::unique_hwnd m_window{}; // Hidden tool window used to represent current monitor desktop work area.
     winrt::com_ptr<IZoneSet> m_activeZoneSet;
     std::vector<winrt::com_ptr<IZoneSet>> m_zoneSets;
     WPARAM m_keyLast{};
     size_t m_keyCycle{};
-
-    ULONG_PTR gdiplusToken;
 };
 
 ZoneWindow::ZoneWindow(HINSTANCE hinstance)
@@ -137,34 +137,31 @@ ZoneWindow::ZoneWindow(HINSTANCE hinstance)
     wcex.lpszClassName = L"FancyTiling_ZoneWindow";
     wcex.hCursor = LoadCursorW(nullptr, IDC_ARROW);
     RegisterClassExW(&wcex);
-
-    Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-    Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
-}
-
-ZoneWindow::~ZoneWindow()
-{
-    Gdiplus::GdiplusShutdown(gdiplusToken);
 }
 
 bool ZoneWindow::Init(IZoneWindowHost* host, HINSTANCE hinstance, HMONITOR monitor, const std::wstring& uniqueId, bool flashZones, bool newWorkArea)
 {
     m_host.copy_from(host);
 
-    MONITORINFO mi{};
-    mi.cbSize = sizeof(mi);
-    if (!GetMonitorInfoW(monitor, &mi))
+    const auto topology = MonitorTopologyInstance().Current(PlatformInstance());
+    const auto info = topology->Find(monitor);
+    if (!info)
     {
         return false;
     }
 
     m_monitor = monitor;
-    const UINT dpi = GetDpiForMonitor(m_monitor);
-    const Rect monitorRect(mi.rcMonitor);
-    const Rect workAreaRect(mi.rcWork, dpi);
+    const Rect monitorRect(info->rect);
+    const Rect workAreaRect(info->workArea, info->dpi);
     StringCchPrintf(m_workArea, ARRAYSIZE(m_workArea), L"%d_%d", monitorRect.width(), monitorRect.height());
 
     m_uniqueId = uniqueId;
+    // Format: <device-id>_<resolution>_<virtual-desktop-id>, the null GUID when there's no virtual desktop
+    const std::wstring virtualDesktopId = m_uniqueId.substr(m_uniqueId.rfind('_') + 1);
+    if (FAILED(CLSIDFromString(virtualDesktopId.c_str(), &m_virtualDesktopId)))
+    {
+        m_virtualDesktopId = GUID_NULL;
+    }
     LoadSettings();
     InitializeZoneSets(newWorkArea);
 
@@ -284,10 +281,10 @@ void ZoneWindow::CalculateZoneSet() noexcept
             activeZoneSet.type,
             m_monitor,
             m_workArea));
-        MONITORINFO monitorInfo{};
-        monitorInfo.cbSize = sizeof(monitorInfo);
-        if (GetMonitorInfoW(m_monitor, &monitorInfo))
+        const auto topology = MonitorTopologyInstance().Current(PlatformInstance());
+        if (const auto info = topology->Find(m_monitor))
         {
+            const MONITORINFO monitorInfo{ sizeof(MONITORINFO), info->rect, info->workArea, 0 };
             bool showSpacing = deviceInfoData->showSpacing;
             int spacing = showSpacing ? deviceInfoData->spacing : 0;
             int zoneCount = deviceInfoData->zoneCount;
@@ -52,6 +52,10 @@ interface __declspec(uuid("{7F017528-8110-4FB3-BE41-F472969C2560}")) IZoneWindow
      * @returns Unique work area identifier. Format: <device-id>_<resolution>_<virtual-desktop-id>
      */
     IFACEMETHOD_(std::wstring, UniqueId)() = 0;
+    /**
+     * @returns Virtual desktop part of the unique work area identifier, GUID_NULL if there is none.
+     */
+    IFACEMETHOD_(GUID, VirtualDesktopId)() = 0;
     /**
      * @returns Work area resolution (not same as monitor resolution).
      */
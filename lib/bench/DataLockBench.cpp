@@ -0,0 +1,351 @@
+#include "FancyZonesDataStore.h"
+#include "LatencyHistogram.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reader and writer threads on FancyZonesDataStore, the part of FancyZonesData which doesn't need
+// winrt, filled with data shaped like the JsonHelpers structs. Readers look devices, custom zone sets
+// and app history up like zone windows and the move handler do, writers save app zones and replace
+// virtual desktops. Like SetAppLastZones, saving happens under the write lock, here as text into a
+// temporary directory. Runs once saving on every write and once without saving, which shows how
+// much of the lock wait is file I/O.
+//   DataLockBench [--smoke] [readers] [writers] [seconds]
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using JSONHelpers::DataLockSite;
+
+    enum class LayoutType : int
+    {
+        Blank = -1,
+        Focus,
+        Columns,
+        Rows,
+        Grid,
+        PriorityGrid,
+        Custom
+    };
+
+    struct ZoneSetData
+    {
+        std::wstring uuid;
+        LayoutType type;
+    };
+
+    struct DeviceInfoData
+    {
+        ZoneSetData activeZoneSet;
+        bool showSpacing;
+        int spacing;
+        int zoneCount;
+    };
+
+    struct CustomZoneSetData
+    {
+        std::wstring name;
+        int referenceWidth;
+        int referenceHeight;
+        std::vector<std::array<int, 4>> zones;
+    };
+
+    constexpr size_t MONITORS = 3;
+    constexpr size_t DESKTOPS = 8;
+    constexpr size_t CUSTOM_ZONE_SETS = 20;
+    constexpr size_t APPS = 500;
+
+    std::wstring Guid(unsigned prefix, size_t i)
+    {
+        wchar_t guid[39];
+        std::swprintf(guid, std::size(guid), L"{%08X-130D-4B5D-8851-%012zX}", prefix, i);
+        return guid;
+    }
+
+    std::wstring AppPath(size_t i)
+    {
+        return L"C:\\Program Files\\Vendor" + std::to_wstring(i % 10) + L"\\Application" + std::to_wstring(i) + L".exe";
+    }
+
+    // Ids made up front, so the measured operations don't include building them
+    struct Ids
+    {
+        Ids()
+        {
+            for (size_t desktop = 0; desktop < DESKTOPS; desktop++)
+            {
+                desktops.push_back(Guid(0x39B25DD2, desktop));
+                for (size_t monitor = 0; monitor < MONITORS; monitor++)
+                {
+                    devices.push_back(L"DELA026#5&10a58c63&0&UID1677748" + std::to_wstring(monitor) + L"_1920_1200_" + desktops.back());
+                }
+            }
+            for (size_t i = 0; i < CUSTOM_ZONE_SETS; i++)
+            {
+                zoneSets.push_back(Guid(0x5A3C1E07, i));
+            }
+            for (size_t i = 0; i < 1200; i++) // Some apps aren't in the history
+            {
+                apps.push_back(AppPath(i));
+            }
+        }
+
+        const std::wstring& Device(size_t monitor, size_t desktop) const
+        {
+            return devices[desktop * MONITORS + monitor];
+        }
+
+        std::vector<std::wstring> desktops;
+        std::vector<std::wstring> devices;
+        std::vector<std::wstring> zoneSets;
+        std::vector<std::wstring> apps;
+    };
+
+    // FancyZonesData with the JSON files replaced by a text file.
+    class BenchData : public JSONHelpers::FancyZonesDataStore<DeviceInfoData, CustomZoneSetData>
+    {
+    public:
+        BenchData(std::filesystem::path file, bool saveOnWrite) :
+            m_file(std::move(file)),
+            m_saveOnWrite(saveOnWrite)
+        {
+        }
+
+        // LoadFancyZonesData, before any thread uses the data
+        void Fill(const Ids& ids)
+        {
+            for (size_t i = 0; i < CUSTOM_ZONE_SETS; i++)
+            {
+                customZoneSetsMap[ids.zoneSets[i]] = CustomZoneSetData{ L"Custom " + std::to_wstring(i), 1920, 1200, std::vector<std::array<int, 4>>(i % 6 + 1, { 0, 0, 960, 600 }) };
+            }
+            for (const auto& device : ids.devices)
+            {
+                deviceInfoMap[device] = DeviceInfoData{ ZoneSetData{ ids.zoneSets[deviceInfoMap.size() % CUSTOM_ZONE_SETS], LayoutType::Custom }, true, 16, 3 };
+            }
+            for (size_t i = 0; i < APPS; i++)
+            {
+                appZoneHistory.Set(ids.apps[i], ids.zoneSets[i % CUSTOM_ZONE_SETS], ids.Device(i % MONITORS, 0), { static_cast<int>(i % 4) });
+            }
+        }
+
+        // FancyZonesData::AddDevice
+        void AddDevice(const std::wstring& deviceId)
+        {
+            auto lock = LockData(DataLockSite::Write);
+            if (!deviceInfoMap.contains(deviceId))
+            {
+                deviceInfoMap[deviceId] = DeviceInfoData{ ZoneSetData{ L"null", LayoutType::Blank } };
+            }
+        }
+
+        // Reads the previous file and writes the new one
+        void SaveFancyZonesData() const override
+        {
+            if (!m_saveOnWrite)
+            {
+                return;
+            }
+
+            auto lock = LockData(DataLockSite::Persist);
+            std::wstring text;
+            appZoneHistory.ForEach([&](std::wstring appPath, std::wstring_view zoneSetUuid, std::wstring_view deviceId, const std::vector<int>& zoneIndexSet) {
+                text.append(appPath).append(L" ").append(zoneSetUuid).append(L" ").append(deviceId);
+                for (int index : zoneIndexSet)
+                {
+                    text.append(L" ").append(std::to_wstring(index));
+                }
+                text.append(L"\n");
+            });
+            for (const auto& [id, data] : deviceInfoMap)
+            {
+                text.append(id).append(L" ").append(data.activeZoneSet.uuid).append(L" ").append(std::to_wstring(data.zoneCount)).append(L"\n");
+            }
+
+            {
+                std::ifstream before(m_file, std::ios::binary);
+                const std::string previous(std::istreambuf_iterator<char>(before), {});
+            }
+            std::ofstream stream(m_file, std::ios::binary | std::ios::trunc);
+            stream.write(reinterpret_cast<const char*>(text.data()), static_cast<std::streamsize>(text.size() * sizeof(wchar_t)));
+        }
+
+    private:
+        const std::filesystem::path m_file;
+        const bool m_saveOnWrite;
+    };
+
+    enum class Op : size_t
+    {
+        FindDeviceInfo,
+        FindCustomZoneSet,
+        GetAppLastZoneIndexSet,
+        SetAppLastZones,
+        RemoveDevicesByVirtualDesktopIds,
+        CloneDeviceInfo,
+        Count
+    };
+
+    constexpr const char* OP_NAMES[] = {
+        "FindDeviceInfo",
+        "FindCustomZoneSet",
+        "GetAppLastZoneIndexSet",
+        "SetAppLastZones",
+        "RemoveDevicesByVirtualDesktopIds",
+        "CloneDeviceInfo",
+    };
+    static_assert(std::size(OP_NAMES) == static_cast<size_t>(Op::Count));
+
+    struct Result
+    {
+        double seconds{};
+        std::array<LatencyHistogram, static_cast<size_t>(Op::Count)> latency;
+    };
+
+    // Readers look windows up as they're created, writers place windows at a tenth of the rate and
+    // every eighth write replaces a virtual desktop, whose monitors start as clones of the first one's.
+    void Run(BenchData& data, const Ids& ids, unsigned readers, unsigned writers, std::chrono::milliseconds duration, Result& result)
+    {
+        data.Fill(ids);
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> threads;
+        const auto start = Clock::now();
+        for (unsigned i = 0; i < readers + writers; i++)
+        {
+            const bool writer = i >= readers;
+            threads.emplace_back([&, writer, seed = i] {
+                std::mt19937 random(seed);
+                const auto timed = [&](Op op, auto&& operation) {
+                    const auto operationStart = Clock::now();
+                    operation();
+                    result.latency[static_cast<size_t>(op)].Record(Clock::now() - operationStart);
+                };
+
+                uint64_t count = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    const size_t app = random() % ids.apps.size();
+                    const auto& device = ids.Device(app % MONITORS, 0);
+                    const auto& zoneSet = ids.zoneSets[app % CUSTOM_ZONE_SETS];
+                    if (writer && count % 8 == 7)
+                    {
+                        const size_t desktop = 1 + random() % (DESKTOPS - 1);
+                        timed(Op::RemoveDevicesByVirtualDesktopIds, [&] { data.RemoveDevicesByVirtualDesktopIds({ ids.desktops[desktop] }); });
+                        for (size_t monitor = 0; monitor < MONITORS; monitor++)
+                        {
+                            data.AddDevice(ids.Device(monitor, desktop));
+                            timed(Op::CloneDeviceInfo, [&] { data.CloneDeviceInfo(ids.Device(monitor, 0), ids.Device(monitor, desktop)); });
+                        }
+                    }
+                    else if (writer)
+                    {
+                        timed(Op::SetAppLastZones, [&] { data.SetAppLastZones(ids.apps[app], device, zoneSet, { static_cast<int>(count % 4) }); });
+                    }
+                    else
+                    {
+                        const size_t monitor = random() % MONITORS;
+                        const size_t desktop = random() % DESKTOPS;
+                        timed(Op::FindDeviceInfo, [&] { data.FindDeviceInfo(ids.Device(monitor, desktop)); });
+                        timed(Op::FindCustomZoneSet, [&] { data.FindCustomZoneSet(zoneSet); });
+                        timed(Op::GetAppLastZoneIndexSet, [&] { data.GetAppLastZoneIndexSet(ids.apps[app], device, zoneSet); });
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(random() % (writer ? 1000 : 100)));
+                    count++;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(duration);
+        stop = true;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void Print(const char* name, const BenchData& data, const Result& result)
+    {
+        const auto us = [](uint64_t nanoseconds) { return nanoseconds / 1000.0; };
+        std::printf("%s\n", name);
+        std::printf("  %-32s %12s %10s %10s %10s %10s\n", "op", "ops/s", "p50 us", "p99 us", "p99.9 us", "max us");
+        for (size_t op = 0; op < static_cast<size_t>(Op::Count); op++)
+        {
+            const auto& histogram = result.latency[op];
+            std::printf("  %-32s %12.0f %10.2f %10.2f %10.2f %10.2f\n",
+                        OP_NAMES[op],
+                        histogram.Count() / result.seconds,
+                        us(histogram.ValueAtPercentile(50)),
+                        us(histogram.ValueAtPercentile(99)),
+                        us(histogram.ValueAtPercentile(99.9)),
+                        us(histogram.Max()));
+        }
+
+        // Nested acquisitions never wait, their hold time is part of the outer one's
+        std::printf("  %-8s %10s %10s %12s %12s %12s %12s\n", "site", "acquired", "contended", "wait ms", "max wait us", "mean hold us", "max hold us");
+        for (size_t site = 0; site < static_cast<size_t>(DataLockSite::Count); site++)
+        {
+            const auto& stats = data.GetLockStats(static_cast<DataLockSite>(site));
+            const uint64_t acquisitions = stats.acquisitions.load();
+            std::printf("  %-8ls %10llu %9.1f%% %12.2f %12.2f %12.2f %12.2f\n",
+                        JSONHelpers::DataLockSiteNames[site],
+                        static_cast<unsigned long long>(acquisitions),
+                        acquisitions ? stats.contended.load() * 100.0 / acquisitions : 0.0,
+                        stats.waitNs.load() / 1e6,
+                        us(stats.maxWaitNs.load()),
+                        acquisitions ? us(stats.holdNs.load() / acquisitions) : 0.0,
+                        us(stats.maxHoldNs.load()));
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool smoke = false;
+    std::vector<uint64_t> numbers;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--smoke") == 0)
+        {
+            smoke = true;
+        }
+        else
+        {
+            numbers.push_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+    const unsigned readers = numbers.size() > 0 ? static_cast<unsigned>(numbers[0]) : 4;
+    const unsigned writers = numbers.size() > 1 ? static_cast<unsigned>(numbers[1]) : 2;
+    const std::chrono::milliseconds duration = smoke ? std::chrono::milliseconds(200) : std::chrono::seconds(numbers.size() > 2 ? numbers[2] : 3);
+
+    std::random_device device;
+    const auto directory = std::filesystem::temp_directory_path() / ("fancyzones-data-lock-bench-" + std::to_string(device()));
+    std::filesystem::create_directories(directory);
+    std::printf("%u readers, %u writers, %lld ms, saving to %s\n", readers, writers, static_cast<long long>(duration.count()), directory.string().c_str());
+
+    const Ids ids;
+    bool saved = false;
+    for (const bool saveOnWrite : { true, false })
+    {
+        const auto file = directory / "zones-settings.txt";
+        BenchData data(file, saveOnWrite);
+        Result result;
+        Run(data, ids, readers, writers, duration, result);
+        Print(saveOnWrite ? "saving on every write, like SetAppLastZones" : "without saving", data, result);
+        saved |= saveOnWrite && std::filesystem::file_size(file) > 0;
+    }
+
+    std::filesystem::remove_all(directory);
+    return saved ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include "HookEventQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Hook callbacks of several threads pushing into the queue while the message loop drains it, the
+// way FancyZones uses it. Wake-ups are a flag the consumer polls instead of a posted message.
+// Producers push bursts, like a window being created, shown and uncloaked, and wait for a drain
+// after each one, so the ring only overflows if the consumer falls behind. The mutex queue is what
+// the hooks would otherwise do, for comparison.
+//   HookEventQueueBench [--smoke] [producers] [events per producer] [burst]
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr uint32_t EVENT_OBJECT_CREATE = 0x8000;
+    constexpr uint32_t EVENT_OBJECT_SHOW = 0x8002;
+
+    struct Result
+    {
+        double seconds{};
+        uint64_t pushed{};
+        uint64_t handled{};
+        uint64_t wakes{};
+        HookEvents::QueueStats stats{};
+    };
+
+    class MutexQueue
+    {
+    public:
+        bool Push(uintptr_t window, uint32_t event)
+        {
+            std::scoped_lock lock{ m_mutex };
+            m_pending.push_back(HookEvents::EventRecord<uintptr_t>{ window, event });
+            return m_pending.size() == 1;
+        }
+
+        template<typename Handler>
+        bool Drain(Handler&& handler)
+        {
+            {
+                std::scoped_lock lock{ m_mutex };
+                m_batch.swap(m_pending);
+            }
+            for (const auto& record : m_batch)
+            {
+                handler(record);
+            }
+            m_batch.clear();
+            return true;
+        }
+
+        HookEvents::QueueStats GetStats() const noexcept
+        {
+            return {};
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::vector<HookEvents::EventRecord<uintptr_t>> m_pending;
+        std::vector<HookEvents::EventRecord<uintptr_t>> m_batch;
+    };
+
+    template<typename Queue>
+    Result Run(Queue& queue, unsigned producers, uint64_t eventsPerProducer, uint64_t burst)
+    {
+        std::atomic<bool> wake{ false };
+        std::atomic<uint64_t> drains{ 0 };
+        std::atomic<unsigned> running{ producers };
+        std::atomic<uint64_t> wakes{ 0 };
+        std::vector<std::thread> threads;
+
+        const auto start = Clock::now();
+        for (unsigned p = 0; p < producers; p++)
+        {
+            threads.emplace_back([&, p] {
+                uint64_t drainsSeen = 0;
+                for (uint64_t i = 0; i < eventsPerProducer; i++)
+                {
+                    if (i % burst == 0)
+                    {
+                        while (drains.load(std::memory_order_acquire) == drainsSeen && i > 0)
+                        {
+                            std::this_thread::yield();
+                        }
+                        drainsSeen = drains.load(std::memory_order_acquire);
+                    }
+
+                    // Each window shows up a few times in a row
+                    const uintptr_t window = (static_cast<uintptr_t>(p) << 32) | ((i / 4) & 0xffff);
+                    if (queue.Push(window, i % 2 ? EVENT_OBJECT_SHOW : EVENT_OBJECT_CREATE))
+                    {
+                        wakes.fetch_add(1, std::memory_order_relaxed);
+                        wake.store(true, std::memory_order_release);
+                    }
+                }
+                running--;
+            });
+        }
+
+        Result result;
+        for (bool done = false; !done;)
+        {
+            done = running == 0;
+            if (!done && !wake.exchange(false, std::memory_order_acq_rel))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            queue.Drain([&result](const HookEvents::EventRecord<uintptr_t>&) { result.handled++; });
+            drains.fetch_add(1, std::memory_order_release);
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        result.pushed = producers * eventsPerProducer;
+        result.wakes = wakes;
+        result.stats = queue.GetStats();
+        return result;
+    }
+
+    void Print(const char* name, unsigned producers, const Result& result)
+    {
+        std::printf("%-10s %9u %12.2f %10llu %10llu %10llu %10llu\n",
+                    name,
+                    producers,
+                    result.pushed / result.seconds / 1e6,
+                    static_cast<unsigned long long>(result.wakes),
+                    static_cast<unsigned long long>(result.handled),
+                    static_cast<unsigned long long>(result.stats.coalesced),
+                    static_cast<unsigned long long>(result.stats.dropped));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool smoke = false;
+    std::vector<uint64_t> numbers;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--smoke") == 0)
+        {
+            smoke = true;
+        }
+        else
+        {
+            numbers.push_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+    const unsigned maxProducers = numbers.size() > 0 ? static_cast<unsigned>(numbers[0]) : 4;
+    const uint64_t eventsPerProducer = numbers.size() > 1 ? numbers[1] : (smoke ? 10000 : 2000000);
+    const uint64_t burst = numbers.size() > 2 ? (std::max)(numbers[2], static_cast<uint64_t>(1)) : 16;
+
+    std::printf("%-10s %9s %12s %10s %10s %10s %10s\n", "queue", "producers", "Mevents/s", "wakes", "handled", "coalesced", "dropped");
+    bool consistent = true;
+    for (unsigned producers = 1; producers <= maxProducers; producers *= 2)
+    {
+        HookEvents::EventQueue<uintptr_t, 256> ring;
+        const auto ringResult = Run(ring, producers, eventsPerProducer, burst);
+        Print("ring", producers, ringResult);
+
+        MutexQueue mutexQueue;
+        Print("mutex", producers, Run(mutexQueue, producers, eventsPerProducer, burst));
+
+        // Every event is either handled, folded into one that was, or dropped on overflow
+        const auto& stats = ringResult.stats;
+        consistent &= stats.received == ringResult.pushed && ringResult.handled + stats.coalesced + stats.dropped == stats.received;
+    }
+    return consistent ? 0 : 1;
+}
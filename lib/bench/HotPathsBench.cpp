@@ -0,0 +1,332 @@
+#if defined(FANCYZONES_BENCH_JSON)
+#include "pch.h"
+#include "JsonHelpers.h"
+#endif
+
+#include "AppZoneHistory.h"
+#include "DeviceIdUtils.h"
+#include "ExcludedApps.h"
+#include "MonitorOrder.h"
+#include "ZoneSetUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwctype>
+#include <random>
+#include <string>
+#include <vector>
+
+// Time per call of what FancyZones runs on every drag, relayout, display change or window
+// placement: zone calculation and hit testing, monitor ordering, app zone history lookups,
+// device id parsing and checking, and excluded-app matching. Each case runs at a few sizes.
+// The JSON (de)serializers need winrt, they're timed only in Windows builds next to a PowerToys
+// checkout (POWERTOYS_SRC_DIR in CMakeLists.txt).
+// Prints CSV: name,param,ns_per_op
+//   HotPathsBench [--smoke]
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t s_sink = 0; // Keeps results alive
+
+    template<typename Code>
+    void Measure(const char* name, size_t param, size_t iterations, Code&& code)
+    {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            s_sink += code(i);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        std::printf("%s,%zu,%.1f\n", name, param, elapsed.count() / iterations);
+    }
+
+    // Custom grid layout of size x size cells, with the top left quarter merged into one zone
+    // like the editor makes them.
+    ZoneSetUtils::Grid MakeGrid(int size)
+    {
+        ZoneSetUtils::Grid grid(size, size);
+        for (int i = 0; i < size; i++)
+        {
+            grid.rowsPercents()[i] = ZoneSetUtils::C_MULTIPLIER * (i + 1) / size - ZoneSetUtils::C_MULTIPLIER * i / size;
+            grid.columnsPercents()[i] = ZoneSetUtils::C_MULTIPLIER * (i + 1) / size - ZoneSetUtils::C_MULTIPLIER * i / size;
+        }
+        int zone = 0;
+        for (int row = 0; row < size; row++)
+        {
+            for (int column = 0; column < size; column++)
+            {
+                grid.cellChildMap()[row][column] = row < size / 2 && column < size / 2 ? 0 : ++zone;
+            }
+        }
+        return grid;
+    }
+
+    // Monitors of a grid, in random order.
+    std::vector<MonitorOrder::Entry> MakeMonitors(size_t count, std::mt19937& random)
+    {
+        std::vector<MonitorOrder::Entry> monitors;
+        const size_t columns = (std::max)(static_cast<size_t>(1), static_cast<size_t>(std::sqrt(static_cast<double>(count))));
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto left = static_cast<int>(i % columns) * 1920;
+            const auto top = static_cast<int>(i / columns) * 1080;
+            monitors.push_back({ reinterpret_cast<Platform::MonitorHandle>(i + 1), Platform::Rect{ left, top, left + 1920, top + 1080 } });
+        }
+        std::shuffle(monitors.begin(), monitors.end(), random);
+        return monitors;
+    }
+
+    std::wstring AppPath(size_t i)
+    {
+        return L"C:\\Program Files\\Vendor" + std::to_wstring(i % 10) + L"\\Application" + std::to_wstring(i) + L".exe";
+    }
+
+    std::wstring Upper(std::wstring text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::towupper(c)); });
+        return text;
+    }
+
+    // Device interface path of a monitor, the instance part padded to make it length characters
+    std::wstring DevicePath(size_t length)
+    {
+        const std::wstring prefix = L"\\\\?\\DISPLAY#DELA026#5&10a58c63&0&UID16777488";
+        const std::wstring suffix = L"#{e6f07b5f-ee97-4a90-b076-33f57bf4eaa7}";
+        return prefix + std::wstring(length - (std::min)(length, prefix.size() + suffix.size()), L'0') + suffix;
+    }
+
+    // Stands in for JSONHelpers::isValidGuid, which is CLSIDFromString: checks the
+    // {xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx} format only.
+    bool IsGuidFormat(const std::wstring& str)
+    {
+        if (str.size() != 38 || str.front() != L'{' || str.back() != L'}')
+        {
+            return false;
+        }
+        for (size_t i = 1; i < 37; i++)
+        {
+            const bool dash = i == 9 || i == 14 || i == 19 || i == 24;
+            if (dash ? str[i] != L'-' : !std::iswxdigit(str[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#if defined(FANCYZONES_BENCH_JSON)
+    void MeasureJson(size_t iterations)
+    {
+        using namespace JSONHelpers;
+
+        for (int count : { 1, 8, MAX_ZONE_COUNT })
+        {
+            std::vector<int> zoneIndexSet(count);
+            for (int i = 0; i < count; i++)
+            {
+                zoneIndexSet[i] = i;
+            }
+            const AppZoneHistoryJSON history{ AppPath(1), AppZoneHistoryData{ L"{39B25DD2-130D-4B5D-8851-4791D66B1539}", L"DELA026#5&10a58c63&0&UID16777488_1920_1200_{39B25DD2-130D-4B5D-8851-4791D66B1539}", zoneIndexSet } };
+            Measure("AppZoneHistoryJSON::ToJson", count, iterations, [&](size_t) {
+                return AppZoneHistoryJSON::ToJson(history).Size();
+            });
+            const auto json = AppZoneHistoryJSON::ToJson(history);
+            Measure("AppZoneHistoryJSON::FromJson", count, iterations, [&](size_t) {
+                const auto result = AppZoneHistoryJSON::FromJson(json);
+                return result ? result->data.zoneIndexSet.size() : 0;
+            });
+        }
+
+        for (int size : { 2, 4, 8 })
+        {
+            const auto grid = MakeGrid(size);
+            const CustomZoneSetJSON zoneSet{ L"{33A2B101-06E0-437B-A61E-CDBECF502906}",
+                                             CustomZoneSetData{ L"grid", CustomLayoutType::Grid, GridLayoutInfo(GridLayoutInfo::Full{ size, size, grid.rowsPercents(), grid.columnsPercents(), grid.cellChildMap() }) } };
+            Measure("CustomZoneSetJSON::ToJson grid", size, iterations, [&](size_t) {
+                return CustomZoneSetJSON::ToJson(zoneSet).Size();
+            });
+            const auto json = CustomZoneSetJSON::ToJson(zoneSet);
+            Measure("CustomZoneSetJSON::FromJson grid", size, iterations, [&](size_t) {
+                return CustomZoneSetJSON::FromJson(json) ? 1 : 0;
+            });
+        }
+
+        for (int count : { 4, 16, MAX_ZONE_COUNT })
+        {
+            CanvasLayoutInfo canvas{ 1920, 1080 };
+            for (int i = 0; i < count; i++)
+            {
+                canvas.zones.push_back({ i * 10, i * 10, 400, 300 });
+            }
+            const CustomZoneSetJSON zoneSet{ L"{33A2B101-06E0-437B-A61E-CDBECF502906}", CustomZoneSetData{ L"canvas", CustomLayoutType::Canvas, canvas } };
+            Measure("CustomZoneSetJSON::ToJson canvas", count, iterations, [&](size_t) {
+                return CustomZoneSetJSON::ToJson(zoneSet).Size();
+            });
+            const auto json = CustomZoneSetJSON::ToJson(zoneSet);
+            Measure("CustomZoneSetJSON::FromJson canvas", count, iterations, [&](size_t) {
+                return CustomZoneSetJSON::FromJson(json) ? 1 : 0;
+            });
+        }
+
+        const DeviceInfoJSON device{ L"DELA026#5&10a58c63&0&UID16777488_1920_1200_{39B25DD2-130D-4B5D-8851-4791D66B1539}",
+                                     DeviceInfoData{ ZoneSetData{ L"{33A2B101-06E0-437B-A61E-CDBECF502906}", ZoneSetLayoutType::PriorityGrid }, true, 16, 4 } };
+        Measure("DeviceInfoJSON::ToJson", 1, iterations, [&](size_t) {
+            return DeviceInfoJSON::ToJson(device).Size();
+        });
+        const auto json = DeviceInfoJSON::ToJson(device);
+        Measure("DeviceInfoJSON::FromJson", 1, iterations, [&](size_t) {
+            return DeviceInfoJSON::FromJson(json) ? 1 : 0;
+        });
+    }
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    const bool smoke = argc > 1 && std::strcmp(argv[1], "--smoke") == 0;
+    const size_t iterations = smoke ? 1000 : 1000000;
+    std::mt19937 random(1018);
+
+    std::printf("name,param,ns_per_op\n");
+
+    std::vector<Platform::Rect> zones;
+    for (int size : { 2, 4, 8 })
+    {
+        const auto grid = MakeGrid(size);
+        Measure("CalculateGridZones", size, iterations, [&](size_t) {
+            zones.clear();
+            ZoneSetUtils::CalculateGridZones(3840, 2120, grid, 16, zones);
+            return zones.size();
+        });
+    }
+    for (int zoneCount : { 2, 4, 16 })
+    {
+        Measure("CalculateMainZoneLayout", zoneCount, iterations, [&](size_t i) {
+            zones.clear();
+            ZoneSetUtils::CalculateMainZoneLayout(1920, 1040, zoneCount, 0, 5000 + static_cast<int>(i % 10) * 100, zones);
+            return zones.size();
+        });
+    }
+
+    // Points of a drag over the work area, the zones are grids and don't overlap
+    std::vector<std::pair<int, int>> points(4096);
+    for (auto& [x, y] : points)
+    {
+        x = static_cast<int>(random() % 1920);
+        y = static_cast<int>(random() % 1040);
+    }
+    for (int zoneCount : { 4, 16, 50 })
+    {
+        zones.clear();
+        ZoneSetUtils::CalculateMainZoneLayout(1920, 1040, zoneCount, 16, 5000, zones);
+        Measure("ZonesFromPoint", zoneCount, iterations, [&](size_t i) {
+            const auto& [x, y] = points[i % points.size()];
+            return ZoneSetUtils::ZonesFromPoint(zones.size(), [&](size_t zone) { return zones[zone]; }, x, y).size();
+        });
+    }
+
+    MonitorOrder::Sorter sorter;
+    for (size_t count : { 2, 8, 32 })
+    {
+        const auto monitors = MakeMonitors(count, random);
+        std::vector<MonitorOrder::Entry> sorted;
+        Measure("MonitorOrder::Sorter", count, smoke ? iterations : iterations / 10, [&](size_t) {
+            sorted = monitors;
+            sorter.Sort(sorted);
+            return reinterpret_cast<uintptr_t>(sorted.front().first);
+        });
+    }
+
+    // Parameter is the length of the device interface path
+    for (size_t length : { 83, 128, 255 })
+    {
+        const auto path = DevicePath(length);
+        Measure("ParseDeviceId", length, iterations, [&](size_t) {
+            return DeviceIdUtils::ParseDeviceId(path).size();
+        });
+    }
+    for (size_t length : { 83, 128, 255 })
+    {
+        const auto id = std::wstring(DeviceIdUtils::ParseDeviceId(DevicePath(length))) + L"_1920_1200_{39B25DD2-130D-4B5D-8851-4791D66B1539}";
+        Measure("IsValidDeviceId", length, iterations, [&](size_t) {
+            return DeviceIdUtils::IsValidDeviceId(id, IsGuidFormat) ? 1 : 0;
+        });
+    }
+
+    // Parameter is the number of excluded apps, none of them matches like for most windows
+    std::vector<std::wstring> processPaths;
+    for (size_t i = 0; i < 256; i++)
+    {
+        processPaths.push_back(Upper(AppPath(i)));
+    }
+    for (size_t count : { 1, 10, 100 })
+    {
+        std::vector<std::wstring> excludedApps;
+        for (size_t i = 0; i < count; i++)
+        {
+            excludedApps.push_back(Upper(L"Excluded" + std::to_wstring(i) + L".exe"));
+        }
+        Measure("ExcludedApps::Matches", count, iterations, [&](size_t i) {
+            return ExcludedApps::Matches(processPaths[i % processPaths.size()], excludedApps) ? 0 : 1;
+        });
+    }
+
+    // Parameter is the number of applications in the history
+    bool evicted = true;
+    for (size_t capacity : { size_t{ 100 }, AppZoneHistory::DEFAULT_CAPACITY })
+    {
+        AppZoneHistory history(capacity);
+        std::vector<std::wstring> paths;
+        for (size_t i = 0; i < capacity; i++)
+        {
+            paths.push_back(AppPath(i));
+            history.Set(paths.back(), L"{39B25DD2-130D-4B5D-8851-4791D66B1539}", L"DELA026#5&10a58c63&0&UID16777488_1920_1200_{39B25DD2-130D-4B5D-8851-4791D66B1539}", { static_cast<int>(i % 4) });
+        }
+        std::vector<std::wstring> missing;
+        for (size_t i = 0; i < 1000; i++)
+        {
+            missing.push_back(AppPath(capacity + i));
+        }
+        std::uniform_int_distribution<size_t> pick(0, paths.size() - 1);
+        std::vector<size_t> order(4096);
+        for (auto& index : order)
+        {
+            index = pick(random);
+        }
+
+        Measure("AppZoneHistory::Find hit", capacity, iterations, [&](size_t i) {
+            const auto entry = history.Find(paths[order[i % order.size()]]);
+            return entry ? entry->zoneIndexSet.size() : 0;
+        });
+        Measure("AppZoneHistory::Find miss", capacity, iterations, [&](size_t i) {
+            return history.Find(missing[i % missing.size()]) ? 1 : 0;
+        });
+        Measure("AppZoneHistory::Set existing", capacity, iterations, [&](size_t i) {
+            history.Set(paths[order[i % order.size()]], L"{39B25DD2-130D-4B5D-8851-4791D66B1539}", L"DELA026#5&10a58c63&0&UID16777488_1920_1200_{39B25DD2-130D-4B5D-8851-4791D66B1539}", { static_cast<int>(i % 4) });
+            return history.Size();
+        });
+
+        // Every new application evicts the least recently used one
+        std::vector<std::wstring> newPaths;
+        for (size_t i = 0; i < 4096; i++)
+        {
+            newPaths.push_back(AppPath(capacity + 1000 + i));
+        }
+        Measure("AppZoneHistory::Set evicting", capacity, smoke ? iterations : iterations / 10, [&](size_t i) {
+            history.Set(newPaths[i % newPaths.size()], L"{39B25DD2-130D-4B5D-8851-4791D66B1539}", L"DELA026#5&10a58c63&0&UID16777488_1920_1200_{39B25DD2-130D-4B5D-8851-4791D66B1539}", { 0 });
+            return history.Evictions();
+        });
+        evicted &= history.Size() == capacity;
+    }
+
+#if defined(FANCYZONES_BENCH_JSON)
+    MeasureJson(smoke ? iterations : iterations / 10);
+#endif
+
+    return evicted && s_sink != 0 ? 0 : 1;
+}
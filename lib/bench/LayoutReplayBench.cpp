@@ -0,0 +1,214 @@
+#include "EventReplay.h"
+#include "EventTrace.h"
+#include "InMemoryPlatform.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+// Relayouts through the whole pipeline (snapshot, Layout::Model, commit) against InMemoryPlatform,
+// so they measure FancyZones' own work without the cost of moving real windows.
+//   1. Win+Down relayouts of a desktop with a growing number of windows.
+//   2. Replay of a session, recorded with the event trace or generated: windows opening in bursts
+//      and closing, Win+Up/Down cycling, Win+Shift+Left/Right resizing the main zone.
+//   LayoutReplayBench [--smoke] [--trace file] [sessions steps]
+namespace
+{
+    using namespace std::chrono_literals;
+    using Clock = std::chrono::steady_clock;
+    using EventTrace::Event;
+    using EventTrace::EventKind;
+    namespace WinEvent = EventTrace::WinEvent;
+    namespace VirtualKey = KeyboardHook::VirtualKey;
+
+    double Micros(uint64_t nanoseconds)
+    {
+        return nanoseconds / 1000.0;
+    }
+
+    void RunRelayouts(size_t windows, size_t relayouts)
+    {
+        auto platform = InMemoryPlatform::Generate(2, 1, 0);
+        EventTrace::SimulatedDesktop desktop(platform);
+        for (uint64_t window = 1; window <= windows; window++)
+        {
+            desktop.WindowShown(window);
+        }
+
+        std::vector<Relayout::Request> requests(1);
+        requests[0].kind = Relayout::RequestKind::Snap;
+        requests[0].repeat = 1;
+        desktop.Relayout(requests); // Zones for the new windows
+
+        LatencyHistogram histogram;
+        uint64_t placements = 0;
+        requests[0].vkCode = VirtualKey::Down;
+        const auto start = Clock::now();
+        for (size_t i = 0; i < relayouts; i++)
+        {
+            requests[0].generation = i + 1;
+            const auto relayoutStart = Clock::now();
+            placements += desktop.Relayout(requests);
+            histogram.Record(Clock::now() - relayoutStart);
+        }
+        const std::chrono::duration<double> seconds = Clock::now() - start;
+
+        std::printf("%8zu %12.0f %10.2f %10.2f %10.2f %12.1f\n",
+                    windows,
+                    relayouts / seconds.count(),
+                    Micros(histogram.ValueAtPercentile(50)),
+                    Micros(histogram.ValueAtPercentile(99)),
+                    Micros(histogram.Max()),
+                    static_cast<double>(placements) / relayouts);
+    }
+
+    // Everything in the session happens at least a millisecond apart, hotkeys auto-repeat.
+    std::vector<Event> GenerateSession(std::mt19937& random, size_t steps)
+    {
+        std::vector<Event> events;
+        std::vector<uint64_t> open;
+        uint64_t nextWindow = 1;
+        std::chrono::microseconds time{};
+        const auto add = [&](EventKind kind, uint32_t value, uint64_t window = 0) {
+            events.push_back(Event{ time, kind, value, 0, window });
+            time += 1ms;
+        };
+        const auto hotkey = [&](uint32_t modifier, uint32_t vkCode, int repeats) {
+            add(EventKind::KeyDown, VirtualKey::LWin);
+            if (modifier)
+            {
+                add(EventKind::KeyDown, modifier);
+            }
+            for (int i = 0; i < repeats; i++)
+            {
+                add(EventKind::KeyDown, vkCode);
+                time += 30ms;
+            }
+            add(EventKind::KeyUp, vkCode);
+            if (modifier)
+            {
+                add(EventKind::KeyUp, modifier);
+            }
+            add(EventKind::KeyUp, VirtualKey::LWin);
+        };
+
+        for (size_t step = 0; step < steps; step++)
+        {
+            time += std::chrono::milliseconds(random() % 500);
+            const auto action = random() % 10;
+            if (action < 2 || open.size() < 2)
+            {
+                for (auto burst = random() % 5; burst <= 5 && open.size() < 40; burst++)
+                {
+                    add(EventKind::WinHook, WinEvent::ObjectCreate, nextWindow);
+                    add(EventKind::WinHook, WinEvent::ObjectShow, nextWindow);
+                    open.push_back(nextWindow++);
+                }
+            }
+            else if (action < 4)
+            {
+                const auto closed = open.begin() + random() % open.size();
+                add(EventKind::WinHook, WinEvent::ObjectDestroy, *closed);
+                open.erase(closed);
+            }
+            else if (action < 8)
+            {
+                hotkey(0, random() % 2 ? VirtualKey::Up : VirtualKey::Down, 1 + random() % 4);
+            }
+            else
+            {
+                hotkey(VirtualKey::LShift, random() % 2 ? VirtualKey::Left : VirtualKey::Right, 1 + random() % 3);
+            }
+        }
+        return events;
+    }
+
+    void PrintReplay(const char* name, const std::vector<Event>& events)
+    {
+        auto platform = InMemoryPlatform::Generate(2, 1, 0);
+        EventTrace::SimulatedDesktop desktop(platform);
+        EventTrace::Replayer<> replayer(desktop);
+        const auto start = Clock::now();
+        const auto& report = replayer.Run(events);
+        const std::chrono::duration<double> seconds = Clock::now() - start;
+
+        std::printf("%s: %llu events in %.3f s, %llu requests, %llu relayouts, %llu placements\n",
+                    name,
+                    static_cast<unsigned long long>(report.events),
+                    seconds.count(),
+                    static_cast<unsigned long long>(report.requests),
+                    static_cast<unsigned long long>(report.relayouts),
+                    static_cast<unsigned long long>(report.placements));
+        std::printf("  relayout us  p50 %.2f  p99 %.2f  max %.2f\n",
+                    Micros(report.relayoutTime.ValueAtPercentile(50)),
+                    Micros(report.relayoutTime.ValueAtPercentile(99)),
+                    Micros(report.relayoutTime.Max()));
+        std::printf("  input to placed us  p50 %.2f  p99 %.2f  max %.2f\n",
+                    Micros(report.latency.ValueAtPercentile(50)),
+                    Micros(report.latency.ValueAtPercentile(99)),
+                    Micros(report.latency.Max()));
+        const auto& stats = platform.GetStats();
+        std::printf("  platform  enumerations %llu  window queries %llu  monitor queries %llu  placements %llu\n",
+                    static_cast<unsigned long long>(stats.windowEnumerations),
+                    static_cast<unsigned long long>(stats.windowQueries),
+                    static_cast<unsigned long long>(stats.monitorQueries),
+                    static_cast<unsigned long long>(stats.placements));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool smoke = false;
+    const char* trace = nullptr;
+    std::vector<uint64_t> numbers;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--smoke") == 0)
+        {
+            smoke = true;
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            trace = argv[++i];
+        }
+        else
+        {
+            numbers.push_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+    const uint64_t sessions = numbers.size() > 0 ? numbers[0] : 3;
+    const uint64_t steps = numbers.size() > 1 ? numbers[1] : (smoke ? 200 : 20000);
+
+    std::printf("%8s %12s %10s %10s %10s %12s\n", "windows", "relayouts/s", "p50 us", "p99 us", "max us", "placed/each");
+    for (size_t windows = 2; windows <= 64; windows *= 2)
+    {
+        RunRelayouts(windows, smoke ? 100 : 20000);
+    }
+
+    if (trace)
+    {
+        std::ifstream stream(trace, std::ios::binary);
+        std::vector<Event> events;
+        if (!EventTrace::Read(stream, events))
+        {
+            std::fprintf(stderr, "%s isn't an event trace\n", trace);
+            return 1;
+        }
+        PrintReplay(trace, events);
+        return 0;
+    }
+
+    std::mt19937 random(1018);
+    for (uint64_t session = 0; session < sessions; session++)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "session %llu", static_cast<unsigned long long>(session + 1));
+        PrintReplay(name, GenerateSession(random, steps));
+    }
+    return 0;
+}
@@ -23,3 +23,6 @@
 #define IDS_CANT_DRAG_ELEVATED                                      123
 #define IDS_CANT_DRAG_ELEVATED_LEARN_MORE                           124
 #define IDS_CANT_DRAG_ELEVATED_DIALOG_DONT_SHOW_AGAIN               125
+#define IDS_SETTING_DESCRIPTION_ANIMATE_WINDOW_MOVES                126
+#define IDS_SETTING_DESCRIPTION_RECORD_EVENT_TRACE                  127
+#define IDS_SETTING_DESCRIPTION_APP_ZONE_HISTORY_CAPACITY           128
@@ -0,0 +1,208 @@
+#include "AllocationTracker.h"
+#include "BurstCoalescer.h"
+#include "HookEventQueue.h"
+#include "InMemoryPlatform.h"
+#include "LatencyHistogram.h"
+#include "LayoutPipeline.h"
+#include "RelayoutRequests.h"
+#include "tests/Check.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(__GNUC__) && !defined(__clang__)
+// Inlined standard containers look like they free what operator new returned
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// Counting allocation functions, like AllocationTracker.cpp in the module built with
+// FANCYZONES_ALLOCATION_TRACKING.
+void* operator new(size_t size)
+{
+    Allocations::Record(size);
+    if (void* memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    // Allocations made on this thread while running the given code.
+    template<typename Code>
+    uint64_t AllocationsOf(Code&& code)
+    {
+        const uint64_t before = Allocations::OnThisThread();
+        code();
+        return Allocations::OnThisThread() - before;
+    }
+
+    void TestCountingWorks()
+    {
+        CHECK(AllocationsOf([] { std::vector<int> allocates(100); }) == 1);
+    }
+
+    void TestHookEventsDontAllocate()
+    {
+        HookEvents::MpscRing<uint64_t, 64> ring;
+        HookEvents::EventQueue<uint64_t, 64> queue;
+        uint64_t handled = 0;
+        const uint64_t allocations = AllocationsOf([&] {
+            for (uint64_t round = 0; round < 1000; round++)
+            {
+                for (uint64_t i = 0; i < 80; i++)
+                {
+                    ring.TryPush(i);
+                    queue.Push(i % 8, 0x8002);
+                }
+                uint64_t value;
+                while (ring.TryPop(value))
+                {
+                }
+                queue.Drain([&](const auto&) { handled++; });
+            }
+        });
+        CHECK(allocations == 0);
+        CHECK(handled == 8000);
+    }
+
+    struct FakeClock
+    {
+        using duration = std::chrono::nanoseconds;
+        using time_point = std::chrono::time_point<FakeClock, duration>;
+
+        static time_point now() noexcept
+        {
+            return current;
+        }
+
+        static inline time_point current{};
+    };
+
+    void TestBurstCoalescerDoesntAllocate()
+    {
+        BurstCoalescer<FakeClock> coalescer;
+        uint64_t flushes = 0;
+        const uint64_t allocations = AllocationsOf([&] {
+            for (int burst = 0; burst < 1000; burst++)
+            {
+                for (int i = 0; i < 10; i++)
+                {
+                    coalescer.OnEvent();
+                    FakeClock::current += 1ms;
+                }
+                FakeClock::current += 1s;
+                flushes += coalescer.Flush();
+                coalescer.RecordLatency(3ms);
+            }
+        });
+        CHECK(allocations == 0);
+        CHECK(flushes == 1000);
+    }
+
+    void TestLatencyHistogramDoesntAllocate()
+    {
+        LatencyHistogram histogram;
+        const uint64_t allocations = AllocationsOf([&] {
+            for (uint64_t i = 0; i < 100000; i++)
+            {
+                histogram.Record(std::chrono::nanoseconds{ i * 7919 });
+            }
+            histogram.ValueAtPercentile(99);
+        });
+        CHECK(allocations == 0);
+        CHECK(histogram.Count() == 100000);
+    }
+
+    // Queue, snapshot and layout model of hotkey relayouts, once their buffers have grown. Zones
+    // are only calculated when their number or the main zone width changes, which allocates.
+    void TestRelayoutSteadyStateDoesntAllocate()
+    {
+        auto platform = InMemoryPlatform::Generate(1, 1, 6);
+        Relayout::RequestQueue requests;
+        Layout::Model model;
+        Layout::Snapshot snapshot;
+        Layout::Result result;
+        std::vector<Relayout::Request> taken;
+        int zoneCount = 0;
+        int mainZoneWidth = 7000;
+
+        const auto relayout = [&](uint32_t vkCode) {
+            for (int press = 0; press < 3; press++)
+            {
+                requests.Submit(Relayout::RequestKind::Snap, vkCode);
+            }
+            requests.TakeAll(taken);
+
+            snapshot.requests = taken;
+            snapshot.generation = taken.back().generation;
+            snapshot.foregroundWindow = platform.ForegroundWindow();
+            snapshot.monitor = platform.MonitorOfWindow(snapshot.foregroundWindow);
+            Platform::Rect area{};
+            platform.GetMonitorRects(snapshot.monitor, area, snapshot.workArea);
+            platform.TopLevelWindows(snapshot.windows);
+            snapshot.zoneIndices.assign(snapshot.windows.size(), -1);
+            snapshot.zoneCount = zoneCount;
+            snapshot.mainZoneWidth = mainZoneWidth;
+
+            model.Compute(snapshot, result);
+            if (result.zonesChanged)
+            {
+                zoneCount = static_cast<int>(result.zones.size());
+                mainZoneWidth = result.mainZoneWidth;
+            }
+        };
+
+        relayout(KeyboardHook::VirtualKey::Down);
+        relayout(KeyboardHook::VirtualKey::Up);
+        const uint64_t allocations = AllocationsOf([&] {
+            for (int i = 0; i < 1000; i++)
+            {
+                relayout(i % 2 ? KeyboardHook::VirtualKey::Up : KeyboardHook::VirtualKey::Down);
+            }
+        });
+        CHECK(allocations == 0);
+        CHECK(zoneCount == 6);
+        CHECK(result.order.size() == 6);
+    }
+}
+
+int main()
+{
+    TestCountingWorks();
+    TestHookEventsDontAllocate();
+    TestBurstCoalescerDoesntAllocate();
+    TestLatencyHistogramDoesntAllocate();
+    TestRelayoutSteadyStateDoesntAllocate();
+    return Check::Result();
+}
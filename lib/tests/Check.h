@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks for the portable tests, so they need nothing but a compiler. A failed check is reported
+// and the test carries on, main returns Check::Result().
+namespace Check
+{
+    inline int s_failures = 0;
+
+    inline bool Report(bool passed, const char* expression, const char* file, int line) noexcept
+    {
+        if (!passed)
+        {
+            s_failures++;
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+        }
+        return passed;
+    }
+
+    inline int Result() noexcept
+    {
+        if (s_failures > 0)
+        {
+            std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+        }
+        return s_failures > 0 ? 1 : 0;
+    }
+}
+
+#define CHECK(expression) Check::Report(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
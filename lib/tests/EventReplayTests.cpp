@@ -0,0 +1,148 @@
+#include "EventReplay.h"
+#include "tests/Check.h"
+
+#include <chrono>
+#include <vector>
+
+namespace
+{
+    using namespace EventTrace;
+    using namespace std::chrono_literals;
+
+    Event WinHook(std::chrono::microseconds time, uint32_t event, uint64_t window)
+    {
+        return Event{ time, EventKind::WinHook, event, WinEvent::ObjectIdWindow, window };
+    }
+
+    Event Key(std::chrono::microseconds time, EventKind kind, uint32_t vkCode)
+    {
+        return Event{ time, kind, vkCode, 0, 0 };
+    }
+
+    // Three windows open at once, then Win+Up cycles them.
+    std::vector<Event> Session()
+    {
+        return {
+            WinHook(0us, WinEvent::ObjectShow, 1),
+            WinHook(1000us, WinEvent::ObjectShow, 2),
+            WinHook(2000us, WinEvent::ObjectShow, 3),
+            Key(1s, EventKind::KeyDown, KeyboardHook::VirtualKey::LWin),
+            Key(1s + 100ms, EventKind::KeyDown, KeyboardHook::VirtualKey::Up),
+            Key(1s + 150ms, EventKind::KeyUp, KeyboardHook::VirtualKey::Up),
+            Key(1s + 200ms, EventKind::KeyUp, KeyboardHook::VirtualKey::LWin),
+        };
+    }
+
+    bool InZones(InMemoryPlatform& platform, const std::vector<Platform::WindowHandle>& windows, const std::vector<Platform::Rect>& zones)
+    {
+        std::vector<bool> taken(zones.size());
+        for (const auto window : windows)
+        {
+            const auto& rect = platform.WindowInfo(window)->rect;
+            bool found = false;
+            for (size_t i = 0; i < zones.size() && !found; i++)
+            {
+                found = !taken[i] && zones[i].left == rect.left && zones[i].top == rect.top && zones[i].right == rect.right && zones[i].bottom == rect.bottom;
+                taken[i] = taken[i] || found;
+            }
+            if (!found)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestBurstAndHotkeyRunTheLayoutModel()
+    {
+        auto platform = InMemoryPlatform::Generate(2, 1, 0);
+        SimulatedDesktop desktop(platform);
+        Replayer<> replayer(desktop);
+        const auto& report = replayer.Run(Session());
+
+        CHECK(desktop.WindowCount() == 3);
+        CHECK(report.requests == 2);
+        CHECK(report.relayouts == 2);
+        CHECK(report.relayoutTime.Count() == 2);
+
+        // Zones of the work area, the taskbar takes the bottom 40 pixels
+        std::vector<Platform::Rect> zones;
+        ZoneSetUtils::CalculateMainZoneLayout(1920, 1040, 3, 0, 7000, zones);
+        std::vector<Platform::WindowHandle> windows;
+        platform.TopLevelWindows(windows);
+        CHECK(windows.size() == 3);
+        CHECK(InZones(platform, windows, zones));
+
+        // The burst placed every window, cycling moved every window to the next zone
+        CHECK(report.placements == 6);
+        CHECK(platform.GetStats().placements == 6);
+    }
+
+    void TestDisplayChangeFollowsSettings()
+    {
+        auto events = Session();
+        events.push_back(Event{ 2s, EventKind::DisplayChange });
+        events.push_back(Event{ 3s, EventKind::EditorExit, 1 }); // Terminated, zones are unchanged
+        {
+            auto platform = InMemoryPlatform::Generate(1, 1, 0);
+            SimulatedDesktop desktop(platform);
+            Replayer<> replayer(desktop);
+            CHECK(replayer.Run(events).relayouts == 2);
+        }
+        {
+            auto platform = InMemoryPlatform::Generate(1, 1, 0);
+            SimulatedDesktop desktop(platform);
+            ReplayOptions options;
+            options.displayChangeMoveWindows = true;
+            options.zoneSetChangeMoveWindows = true;
+            Replayer<> replayer(desktop, options);
+            const auto& report = replayer.Run(events);
+            CHECK(report.relayouts == 3);
+            CHECK(report.placements == 6); // Windows are already in their zones
+        }
+    }
+
+    void TestSyntheticCostIsPerPlacement()
+    {
+        auto platform = InMemoryPlatform::Generate(1, 1, 0);
+        SimulatedDesktop desktop(platform);
+        ReplayOptions options;
+        options.syntheticPlacementCost = 20ms;
+        Replayer<> replayer(desktop, options);
+        const auto& report = replayer.Run(Session());
+        CHECK(report.relayouts == 2);
+        CHECK(report.latency.Max() >= static_cast<uint64_t>(std::chrono::nanoseconds{ 60ms }.count()));
+        CHECK(report.relayoutTime.Max() < static_cast<uint64_t>(std::chrono::nanoseconds{ 20ms }.count()));
+    }
+
+    void TestHiddenWindowLeavesItsZone()
+    {
+        auto events = Session();
+        events.push_back(WinHook(2s, WinEvent::ObjectDestroy, 2));
+        events.push_back(Key(3s, EventKind::KeyDown, KeyboardHook::VirtualKey::LWin));
+        events.push_back(Key(3s + 10ms, EventKind::KeyDown, KeyboardHook::VirtualKey::Down));
+
+        auto platform = InMemoryPlatform::Generate(1, 1, 0);
+        SimulatedDesktop desktop(platform);
+        Replayer<> replayer(desktop);
+        const auto& report = replayer.Run(events);
+        CHECK(desktop.WindowCount() == 2);
+        CHECK(report.relayouts == 3);
+
+        // Two windows left, the zone set shrinks to two zones
+        std::vector<Platform::Rect> zones;
+        ZoneSetUtils::CalculateMainZoneLayout(1920, 1040, 2, 0, 7000, zones);
+        std::vector<Platform::WindowHandle> windows;
+        platform.TopLevelWindows(windows);
+        CHECK(InZones(platform, windows, zones));
+    }
+}
+
+int main()
+{
+    TestBurstAndHotkeyRunTheLayoutModel();
+    TestDisplayChangeFollowsSettings();
+    TestSyntheticCostIsPerPlacement();
+    TestHiddenWindowLeavesItsZone();
+    return Check::Result();
+}
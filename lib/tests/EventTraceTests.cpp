@@ -0,0 +1,86 @@
+#include "EventTrace.h"
+#include "tests/Check.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::filesystem::path TracePath(const char* name)
+    {
+        return std::filesystem::temp_directory_path() / name;
+    }
+
+    void TestRecordedEventsReadBack()
+    {
+        const auto path = TracePath("fancyzones-event-trace-test.bin");
+        EventTrace::Recorder recorder;
+        CHECK(recorder.Start(path));
+        recorder.Append(EventTrace::EventKind::WinHook, 42, 0x8002, 0);
+        recorder.Append(EventTrace::EventKind::KeyDown, 0, 0x5B);
+        recorder.Append(EventTrace::EventKind::DisplayChange);
+        recorder.Stop();
+
+        // Appends after stopping aren't recorded
+        recorder.Append(EventTrace::EventKind::KeyUp, 0, 0x5B);
+
+        std::ifstream stream(path, std::ios::binary);
+        std::vector<EventTrace::Event> events;
+        CHECK(EventTrace::Read(stream, events));
+        CHECK(events.size() == 3);
+        CHECK(events[0].kind == EventTrace::EventKind::WinHook && events[0].window == 42 && events[0].value == 0x8002);
+        CHECK(events[1].kind == EventTrace::EventKind::KeyDown && events[1].value == 0x5B);
+        CHECK(events[2].kind == EventTrace::EventKind::DisplayChange);
+        CHECK(events[0].time <= events[1].time && events[1].time <= events[2].time);
+        stream.close();
+        std::filesystem::remove(path);
+    }
+
+    // The flush timer keeps firing while another thread stops the recording.
+    void TestStopWhileFlushing()
+    {
+        const auto path = TracePath("fancyzones-event-trace-stop-test.bin");
+        for (int round = 0; round < 20; round++)
+        {
+            EventTrace::Recorder recorder;
+            CHECK(recorder.Start(path));
+            std::atomic<bool> stopped{ false };
+            std::thread timer([&] {
+                while (!stopped)
+                {
+                    recorder.Flush();
+                }
+                recorder.Flush();
+            });
+
+            uint64_t appended = 0;
+            for (; appended < 2000; appended++)
+            {
+                recorder.Append(EventTrace::EventKind::WinHook, appended);
+            }
+            recorder.Stop();
+            stopped = true;
+            timer.join();
+
+            std::ifstream stream(path, std::ios::binary);
+            std::vector<EventTrace::Event> events;
+            CHECK(EventTrace::Read(stream, events));
+            CHECK(events.size() + recorder.Dropped() == appended);
+            for (size_t i = 1; i < events.size(); i++)
+            {
+                CHECK(events[i].window > events[i - 1].window);
+            }
+        }
+        std::filesystem::remove(path);
+    }
+}
+
+int main()
+{
+    TestRecordedEventsReadBack();
+    TestStopWhileFlushing();
+    return Check::Result();
+}
@@ -0,0 +1,182 @@
+#include "FrameScheduler.h"
+#include "tests/Check.h"
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct TestRect
+    {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+    };
+
+    // Time only moves when the scheduler sleeps or the backend spends time presenting.
+    struct FakeClock
+    {
+        using duration = std::chrono::microseconds;
+        using time_point = std::chrono::time_point<std::chrono::steady_clock, duration>;
+
+        time_point time{};
+        std::vector<time_point> wakeUps;
+
+        time_point now() const noexcept
+        {
+            return time;
+        }
+
+        void sleep_until(time_point deadline) noexcept
+        {
+            time = (std::max)(time, deadline);
+            wakeUps.push_back(time);
+        }
+    };
+
+    struct FakeBackend
+    {
+        FakeClock& clock;
+        FakeClock::duration presentCost{};
+        std::vector<std::vector<std::pair<int, TestRect>>> presented;
+        std::vector<std::pair<int, TestRect>> committed;
+        size_t commits{};
+
+        void PresentFrame(const std::vector<std::pair<int, TestRect>>& frame)
+        {
+            presented.push_back(frame);
+            clock.time += presentCost;
+        }
+
+        void CommitFrame(const std::vector<std::pair<int, TestRect>>& frame)
+        {
+            committed = frame;
+            commits++;
+        }
+    };
+
+    using Scheduler = FrameScheduling::FrameScheduler<int, TestRect, FakeClock, FakeBackend>;
+    const std::vector<FrameScheduling::AnimationTarget<int, TestRect>> TARGETS{
+        { 1, TestRect{ 0, 0, 100, 100 }, TestRect{ 500, 0, 900, 400 } },
+        { 2, TestRect{ 100, 100, 200, 200 }, TestRect{ 0, 0, 1000, 1000 } },
+    };
+
+    bool SameRect(const TestRect& a, const TestRect& b)
+    {
+        return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+    }
+
+    void TestFastBackendPresentsEveryFrameOnSchedule()
+    {
+        FakeClock clock;
+        FakeBackend backend{ clock, 1ms };
+        Scheduler scheduler(clock, backend, 16ms, 160ms);
+        CHECK(scheduler.FrameCountPerAnimation() == 10);
+
+        const auto stats = scheduler.Run(TARGETS);
+        CHECK(stats.framesPresented == 10);
+        CHECK(stats.framesDropped == 0);
+        CHECK(!stats.cancelled);
+        CHECK(backend.presented.size() == 9);
+        CHECK(backend.commits == 1);
+
+        // Frame k starts at (k - 1) * interval
+        CHECK(clock.wakeUps.size() == 9);
+        for (size_t i = 0; i < clock.wakeUps.size(); i++)
+        {
+            CHECK(clock.wakeUps[i].time_since_epoch() == 16ms * static_cast<int>(i + 1));
+        }
+
+        // Eased progress only ever moves towards the target
+        for (size_t i = 1; i < backend.presented.size(); i++)
+        {
+            CHECK(backend.presented[i][0].second.left >= backend.presented[i - 1][0].second.left);
+        }
+        CHECK(SameRect(backend.committed[0].second, TARGETS[0].to));
+        CHECK(SameRect(backend.committed[1].second, TARGETS[1].to));
+    }
+
+    void TestLateFramesAreDropped()
+    {
+        FakeClock clock;
+        FakeBackend backend{ clock, 10ms };
+        Scheduler scheduler(clock, backend, 16ms, 160ms);
+        // Presenting costs 10ms, the first sleep oversleeps by two frames
+        clock.wakeUps.reserve(16);
+        const auto stats = scheduler.Run(TARGETS, [&] {
+            if (clock.wakeUps.size() == 1 && clock.time.time_since_epoch() < 48ms)
+            {
+                clock.time += 40ms;
+            }
+            return false;
+        });
+        CHECK(stats.framesDropped > 0);
+        CHECK(stats.framesPresented + stats.framesDropped == scheduler.FrameCountPerAnimation());
+        CHECK(backend.commits == 1);
+        CHECK(SameRect(backend.committed[0].second, TARGETS[0].to));
+    }
+
+    void TestSlowBackendCommitsRightAway()
+    {
+        FakeClock clock;
+        FakeBackend backend{ clock, 20ms };
+        Scheduler scheduler(clock, backend, 16ms, 160ms);
+        const auto stats = scheduler.Run(TARGETS);
+        CHECK(backend.presented.size() == 1);
+        CHECK(backend.commits == 1);
+        CHECK(stats.framesPresented == 2);
+        CHECK(stats.framesDropped == scheduler.FrameCountPerAnimation() - 2);
+    }
+
+    void TestCancelledAnimationIsNotCommitted()
+    {
+        FakeClock clock;
+        FakeBackend backend{ clock, 1ms };
+        Scheduler scheduler(clock, backend, 16ms, 160ms);
+        const auto stats = scheduler.Run(TARGETS, [&] { return backend.presented.size() == 3; });
+        CHECK(stats.cancelled);
+        CHECK(backend.commits == 0);
+        CHECK(backend.presented.size() == 3);
+    }
+
+    void TestShortAnimationIsOneCommit()
+    {
+        FakeClock clock;
+        FakeBackend backend{ clock, 1ms };
+        Scheduler scheduler(clock, backend, 16ms, 10ms);
+        CHECK(scheduler.FrameCountPerAnimation() == 1);
+        scheduler.Run(TARGETS);
+        CHECK(backend.presented.empty());
+        CHECK(backend.commits == 1);
+    }
+
+    void TestFrameIntervalKeepsFractionalRates()
+    {
+        using std::chrono::nanoseconds;
+        const nanoseconds fallback = 16'666'667ns;
+        CHECK(FrameScheduling::FrameInterval(60000, 1001, fallback) == 16'683'333ns);
+        CHECK(FrameScheduling::FrameInterval(144, 1, fallback) == 6'944'444ns);
+        CHECK(FrameScheduling::FrameInterval(0, 1, fallback) == fallback);
+        CHECK(FrameScheduling::FrameInterval(60, 0, fallback) == fallback);
+
+        // Truncating 59.94 Hz to 59 Hz puts a frame 17ms late after a second
+        const auto drift = FrameScheduling::FrameInterval(59, 1, fallback) * 60 - FrameScheduling::FrameInterval(60000, 1001, fallback) * 60;
+        CHECK(drift > 15ms);
+    }
+}
+
+int main()
+{
+    TestFastBackendPresentsEveryFrameOnSchedule();
+    TestLateFramesAreDropped();
+    TestSlowBackendCommitsRightAway();
+    TestCancelledAnimationIsNotCommitted();
+    TestShortAnimationIsOneCommit();
+    TestFrameIntervalKeepsFractionalRates();
+    return Check::Result();
+}
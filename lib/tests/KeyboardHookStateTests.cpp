@@ -0,0 +1,95 @@
+#include "KeyboardHookState.h"
+#include "tests/Check.h"
+
+#include <cstdint>
+
+namespace
+{
+    using namespace KeyboardHook;
+
+    // What OnKeyDown decided before the action table, from GetAsyncKeyState of Win, Shift and Ctrl.
+    // The hook only forwarded WM_KEYDOWN, keys pressed with Alt down come as WM_SYSKEYDOWN.
+    KeyAction Original(uint8_t modifiers, uint32_t vkCode)
+    {
+        if (modifiers & Modifier::Alt)
+        {
+            return KeyAction::PassThrough;
+        }
+        const bool win = modifiers & Modifier::Win;
+        const bool shift = modifiers & Modifier::Shift;
+        const bool ctrl = modifiers & Modifier::Ctrl;
+        const bool digit = vkCode >= '1' && vkCode <= '9';
+        if (win && !shift)
+        {
+            if (ctrl)
+            {
+                return digit ? KeyAction::MoveToVirtualDesktop : KeyAction::PassThrough;
+            }
+            if (vkCode == VirtualKey::Left || vkCode == VirtualKey::Up || vkCode == VirtualKey::Down)
+            {
+                return KeyAction::Snap;
+            }
+            if (vkCode == VirtualKey::Right)
+            {
+                return KeyAction::Swallow;
+            }
+            return digit ? KeyAction::SwitchToVirtualDesktop : KeyAction::PassThrough;
+        }
+        if (win && shift && (vkCode == VirtualKey::Left || vkCode == VirtualKey::Right))
+        {
+            return KeyAction::MainZoneWidth;
+        }
+        return KeyAction::PassThrough;
+    }
+
+    void TestDefaultsMatchOriginalHotkeys()
+    {
+        const auto table = ActionTable::FancyZonesDefaults();
+        for (uint8_t modifiers = 0; modifiers < MODIFIER_COMBINATIONS; modifiers++)
+        {
+            for (uint32_t vkCode = 0; vkCode < KEY_COUNT; vkCode++)
+            {
+                CHECK(table.Lookup(modifiers, vkCode) == Original(modifiers, vkCode));
+            }
+        }
+    }
+
+    void TestAltPassesThrough()
+    {
+        const auto table = ActionTable::FancyZonesDefaults();
+        ModifierState state;
+        state.Update(VirtualKey::LWin, true);
+        state.Update(VirtualKey::LMenu, true);
+        CHECK(state.Mask() == (Modifier::Win | Modifier::Alt));
+        CHECK(table.Lookup(state.Mask(), VirtualKey::Up) == KeyAction::PassThrough);
+        CHECK(table.Lookup(state.Mask(), '3') == KeyAction::PassThrough);
+        state.Update(VirtualKey::LControl, true);
+        CHECK(table.Lookup(state.Mask(), '3') == KeyAction::PassThrough);
+    }
+
+    void TestModifierTracking()
+    {
+        ModifierState state;
+        CHECK(state.Update(VirtualKey::LWin, true));
+        CHECK(!state.Update(VirtualKey::Up, true));
+        CHECK(state.Update(VirtualKey::RShift, true));
+        CHECK(state.Mask() == (Modifier::Win | Modifier::Shift));
+        CHECK(state.Update(VirtualKey::Shift, false));
+        CHECK(state.Mask() == (Modifier::Win | Modifier::Shift)); // Right shift is still down
+        state.Update(VirtualKey::RShift, false);
+        CHECK(state.Mask() == Modifier::Win);
+        state.Resync(Modifier::Ctrl);
+        CHECK(state.Mask() == Modifier::Ctrl);
+
+        CHECK(ModifierState::IsModifier(VirtualKey::RMenu));
+        CHECK(!ModifierState::IsModifier('A'));
+    }
+}
+
+int main()
+{
+    TestDefaultsMatchOriginalHotkeys();
+    TestAltPassesThrough();
+    TestModifierTracking();
+    return Check::Result();
+}
@@ -0,0 +1,96 @@
+#include "MetricsBlock.h"
+#include "tests/Check.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Metrics::Counter;
+
+    void TestPublishedCountersReadBack()
+    {
+        Metrics::Add(Counter::Relayouts, 2); // Kept locally until published
+        Metrics::Publisher publisher;
+        CHECK(publisher.Start(42));
+        Metrics::Add(Counter::Relayouts);
+        Metrics::Set(Counter::PlacementTrackerEntries, 7);
+        Metrics::Max(Counter::HookQueueDepthMax, 5);
+        Metrics::Max(Counter::HookQueueDepthMax, 3);
+
+        Metrics::Reader reader;
+        CHECK(reader.Open());
+        Metrics::Sample sample;
+        CHECK(reader.Read(sample));
+        CHECK(sample.processId == 42);
+        CHECK(sample.counterCount == static_cast<uint32_t>(Counter::Count));
+        CHECK(sample[Counter::Relayouts] == 3);
+        CHECK(sample[Counter::PlacementTrackerEntries] == 7);
+        CHECK(sample[Counter::HookQueueDepthMax] == 5);
+
+        std::ostringstream text;
+        Metrics::WriteText(text, sample);
+        CHECK(text.str().find("relayouts 3\n") != std::string::npos);
+
+        // Readers stop seeing the block, counting carries on locally
+        publisher.Stop();
+        CHECK(!reader.Read(sample));
+        Metrics::Add(Counter::Relayouts);
+        CHECK(Metrics::s_localBlock.values[static_cast<size_t>(Counter::Relayouts)].load() == 4);
+
+        // Published again in the same region, a reader which stayed open sees it
+        CHECK(publisher.Start(43));
+        CHECK(reader.Read(sample));
+        CHECK(sample.processId == 43);
+        CHECK(sample[Counter::Relayouts] == 4);
+        publisher.Stop();
+    }
+
+    // Writers keep updating while the block is published and unpublished, the shared block they
+    // may still hold must stay mapped.
+    void TestWritersDuringStartAndStop()
+    {
+        const auto before = Metrics::s_localBlock.values[static_cast<size_t>(Counter::HookEventsReceived)].load();
+        Metrics::Publisher publisher;
+        std::atomic<bool> done{ false };
+        std::atomic<int> running{ 0 };
+        std::vector<std::thread> writers;
+        for (int i = 0; i < 4; i++)
+        {
+            writers.emplace_back([&] {
+                Metrics::Add(Counter::HookEventsReceived);
+                running++;
+                while (!done.load(std::memory_order_relaxed))
+                {
+                    Metrics::Add(Counter::HookEventsReceived);
+                    Metrics::Max(Counter::HookQueueDepthMax, 9);
+                }
+            });
+        }
+        // Rounds are quick, they'd be over before the writers are scheduled
+        while (running < 4)
+        {
+            std::this_thread::yield();
+        }
+        for (int round = 0; round < 500; round++)
+        {
+            CHECK(publisher.Start(1));
+            publisher.Stop();
+        }
+        done = true;
+        for (auto& writer : writers)
+        {
+            writer.join();
+        }
+        CHECK(Metrics::s_localBlock.values[static_cast<size_t>(Counter::HookEventsReceived)].load() > before);
+    }
+}
+
+int main()
+{
+    TestPublishedCountersReadBack();
+    TestWritersDuringStartAndStop();
+    return Check::Result();
+}
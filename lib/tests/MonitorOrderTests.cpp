@@ -0,0 +1,113 @@
+#include "MonitorOrder.h"
+#include "tests/Check.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using MonitorOrder::Entry;
+
+    Platform::MonitorHandle Monitor(size_t index)
+    {
+        return reinterpret_cast<Platform::MonitorHandle>(index + 1);
+    }
+
+    // Tiled, overlapping and degenerate monitors, often sharing edges so ties are common.
+    std::vector<Entry> RandomMonitors(std::mt19937& random)
+    {
+        std::uniform_int_distribution<int> count(0, 8);
+        std::uniform_int_distribution<int> kind(0, 3);
+        std::uniform_int_distribution<int> cell(0, 3);
+        std::uniform_int_distribution<int> coordinate(-2000, 4000);
+        std::uniform_int_distribution<int> extent(0, 2500);
+
+        std::vector<Entry> monitors(count(random));
+        for (size_t i = 0; i < monitors.size(); i++)
+        {
+            Platform::Rect rect{};
+            switch (kind(random))
+            {
+            case 0: // Grid of 1920x1080 monitors
+                rect.left = cell(random) * 1920;
+                rect.top = cell(random) * 1080;
+                rect.right = rect.left + 1920;
+                rect.bottom = rect.top + 1080;
+                break;
+            case 1: // Anywhere
+                rect.left = coordinate(random);
+                rect.top = coordinate(random);
+                rect.right = rect.left + extent(random);
+                rect.bottom = rect.top + extent(random);
+                break;
+            case 2: // Same as another monitor, mirrored
+                rect = i > 0 ? monitors[random() % i].second : Platform::Rect{ 0, 0, 1920, 1080 };
+                break;
+            default: // Empty
+                rect.left = rect.right = coordinate(random);
+                rect.top = rect.bottom = coordinate(random);
+                break;
+            }
+            monitors[i] = { Monitor(i), rect };
+        }
+        return monitors;
+    }
+
+    bool SameOrder(const std::vector<Entry>& a, const std::vector<Entry>& b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i].first != b[i].first)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestMatchesReference()
+    {
+        std::mt19937 random(20201018);
+        MonitorOrder::Sorter sorter;
+        for (int round = 0; round < 20000; round++)
+        {
+            auto sorted = RandomMonitors(random);
+            auto reference = sorted;
+            sorter.Sort(sorted);
+            MonitorOrder::SortReference(reference);
+            if (!CHECK(SameOrder(sorted, reference)))
+            {
+                return;
+            }
+        }
+    }
+
+    void TestReadingOrder()
+    {
+        // Two rows of two, given bottom right first
+        std::vector<Entry> monitors = {
+            { Monitor(0), { 1920, 1080, 3840, 2160 } },
+            { Monitor(1), { 0, 1080, 1920, 2160 } },
+            { Monitor(2), { 1920, 0, 3840, 1080 } },
+            { Monitor(3), { 0, 0, 1920, 1080 } },
+        };
+        MonitorOrder::Sorter sorter;
+        sorter.Sort(monitors);
+        CHECK(monitors[0].first == Monitor(3));
+        CHECK(monitors[1].first == Monitor(2));
+        CHECK(monitors[2].first == Monitor(1));
+        CHECK(monitors[3].first == Monitor(0));
+    }
+}
+
+int main()
+{
+    TestMatchesReference();
+    TestReadingOrder();
+    return Check::Result();
+}
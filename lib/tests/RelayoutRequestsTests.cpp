@@ -0,0 +1,111 @@
+#include "RelayoutRequests.h"
+#include "tests/Check.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Relayout::RequestKind;
+
+    constexpr uint32_t VK_LEFT = 0x25;
+    constexpr uint32_t VK_UP = 0x26;
+
+    void TestConsecutiveRequestsAreMerged()
+    {
+        Relayout::RequestQueue queue;
+        std::vector<Relayout::Request> requests;
+        CHECK(queue.Submit(RequestKind::Snap, VK_UP));
+        CHECK(!queue.Submit(RequestKind::Snap, VK_UP));
+        CHECK(!queue.Submit(RequestKind::MainZoneWidth, VK_LEFT));
+        queue.TakeAll(requests);
+        CHECK(requests.size() == 2);
+        CHECK(requests[0].repeat == 2);
+        CHECK(requests[0].generation == 2);
+        CHECK(requests[1].generation == 3);
+        CHECK(!queue.IsSuperseded(3));
+        CHECK(requests.capacity() >= Relayout::RequestQueue::CAPACITY);
+    }
+
+    void TestFailedWakeIsRetried()
+    {
+        Relayout::RequestQueue queue;
+        std::vector<Relayout::Request> requests;
+        CHECK(queue.Submit(RequestKind::Snap, VK_UP));
+        CHECK(!queue.Submit(RequestKind::Snap, VK_UP));
+
+        // Posting failed, the requests stay and the next submission wakes the consumer
+        queue.CancelWake();
+        CHECK(queue.Submit(RequestKind::Snap, VK_UP));
+        queue.TakeAll(requests);
+        CHECK(requests.size() == 1);
+        CHECK(requests[0].repeat == 3);
+
+        // Taking re-arms the wake-up
+        CHECK(queue.Submit(RequestKind::Snap, VK_UP));
+    }
+
+    void TestOverflowKeepsNewestGeneration()
+    {
+        Relayout::RequestQueue queue;
+        std::vector<Relayout::Request> requests;
+        const size_t submitted = Relayout::RequestQueue::CAPACITY + 10;
+        for (size_t i = 0; i < submitted; i++)
+        {
+            queue.Submit(i % 2 ? RequestKind::Snap : RequestKind::MainZoneWidth, VK_UP);
+        }
+        CHECK(queue.Dropped() == 10);
+        queue.TakeAll(requests);
+        CHECK(requests.size() == Relayout::RequestQueue::CAPACITY);
+        CHECK(!queue.IsSuperseded(requests.back().generation));
+    }
+
+    void TestConcurrentSubmissionsAreAllAccountedFor()
+    {
+        Relayout::RequestQueue queue;
+        std::vector<Relayout::Request> requests;
+        constexpr uint64_t PER_THREAD = 20000;
+        std::atomic<int> running{ 3 };
+        std::vector<std::thread> producers;
+        for (uint32_t p = 0; p < 3; p++)
+        {
+            producers.emplace_back([&queue, &running, p] {
+                for (uint64_t i = 0; i < PER_THREAD; i++)
+                {
+                    queue.Submit(RequestKind::Snap, p);
+                }
+                running--;
+            });
+        }
+
+        uint64_t taken = 0;
+        uint64_t newest = 0;
+        for (bool done = false; !done;)
+        {
+            done = running == 0;
+            queue.TakeAll(requests);
+            for (const auto& request : requests)
+            {
+                taken += request.repeat;
+                newest = (std::max)(newest, request.generation);
+            }
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        CHECK(taken + queue.Dropped() == 3 * PER_THREAD);
+        CHECK(!queue.IsSuperseded(newest));
+    }
+}
+
+int main()
+{
+    TestConsecutiveRequestsAreMerged();
+    TestFailedWakeIsRetried();
+    TestOverflowKeepsNewestGeneration();
+    TestConcurrentSubmissionsAreAllAccountedFor();
+    return Check::Result();
+}
@@ -0,0 +1,154 @@
+#include "ShellServiceBroker.h"
+#include "tests/Check.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // Shell whose connections die when it restarts, counting every call made to it.
+    struct FakeShell
+    {
+        int connects{};
+        int desktopLists{};
+        int restarts{}; // Connections made before the last restart are gone
+        bool unavailable{};
+        size_t desktopCount{ 3 };
+    };
+
+    struct FakeProvider
+    {
+        struct Connection
+        {
+            int restart{ -1 };
+        };
+        using Desktop = int;
+
+        FakeShell* shell{};
+
+        ShellCallResult Connect(Connection& connection)
+        {
+            shell->connects++;
+            if (shell->unavailable)
+            {
+                return ShellCallResult::Failed;
+            }
+            connection.restart = shell->restarts;
+            return ShellCallResult::Succeeded;
+        }
+
+        ShellCallResult ListDesktops(Connection& connection, std::vector<Desktop>& desktops)
+        {
+            shell->desktopLists++;
+            if (connection.restart != shell->restarts)
+            {
+                return ShellCallResult::Disconnected;
+            }
+            for (size_t i = 0; i < shell->desktopCount; i++)
+            {
+                desktops.push_back(static_cast<int>(i) * 10);
+            }
+            return ShellCallResult::Succeeded;
+        }
+    };
+
+    using Broker = ShellServiceBroker<FakeProvider>;
+
+    ShellCallResult DesktopAt(Broker& broker, size_t index, int& desktop)
+    {
+        return broker.Invoke([&](FakeProvider::Connection& connection) { return broker.DesktopAt(connection, index, desktop); });
+    }
+
+    void TestDesktopListIsCachedPerGeneration()
+    {
+        FakeShell shell;
+        std::atomic<uint64_t> generation{ 0 };
+        Broker broker(generation, FakeProvider{ &shell });
+        int desktop = -1;
+
+        CHECK(DesktopAt(broker, 1, desktop) == ShellCallResult::Succeeded);
+        CHECK(desktop == 10);
+        CHECK(DesktopAt(broker, 2, desktop) == ShellCallResult::Succeeded);
+        CHECK(desktop == 20);
+        CHECK(DesktopAt(broker, 5, desktop) == ShellCallResult::Failed);
+        CHECK(shell.connects == 1);
+        CHECK(shell.desktopLists == 1);
+        CHECK(broker.GetStats().desktopListHits == 2);
+
+        // Desktops were added
+        shell.desktopCount = 6;
+        generation++;
+        CHECK(DesktopAt(broker, 5, desktop) == ShellCallResult::Succeeded);
+        CHECK(desktop == 50);
+        CHECK(shell.connects == 1);
+        CHECK(shell.desktopLists == 2);
+        CHECK(broker.GetStats().desktopListFetches == 2);
+    }
+
+    void TestReconnectsOnceWhenShellRestarted()
+    {
+        FakeShell shell;
+        std::atomic<uint64_t> generation{ 0 };
+        Broker broker(generation, FakeProvider{ &shell });
+        int desktop = -1;
+        CHECK(DesktopAt(broker, 0, desktop) == ShellCallResult::Succeeded);
+
+        // The cached list would still answer, a call that needs the connection finds it gone
+        shell.restarts++;
+        generation++;
+        CHECK(DesktopAt(broker, 2, desktop) == ShellCallResult::Succeeded);
+        CHECK(desktop == 20);
+        CHECK(shell.connects == 2);
+        CHECK(shell.desktopLists == 3);
+        CHECK(broker.GetStats().disconnects == 1);
+        CHECK(broker.IsConnected());
+    }
+
+    void TestGivesUpWhenShellIsGone()
+    {
+        FakeShell shell;
+        std::atomic<uint64_t> generation{ 0 };
+        Broker broker(generation, FakeProvider{ &shell });
+        int desktop = -1;
+        CHECK(DesktopAt(broker, 0, desktop) == ShellCallResult::Succeeded);
+
+        shell.restarts++;
+        shell.unavailable = true;
+        generation++;
+        CHECK(DesktopAt(broker, 0, desktop) == ShellCallResult::Failed);
+        CHECK(!broker.IsConnected());
+        CHECK(shell.connects == 2);
+
+        // Every call tries to connect again until the shell is back
+        CHECK(DesktopAt(broker, 0, desktop) == ShellCallResult::Failed);
+        CHECK(shell.connects == 3);
+        shell.unavailable = false;
+        CHECK(DesktopAt(broker, 0, desktop) == ShellCallResult::Succeeded);
+        CHECK(shell.connects == 4);
+        CHECK(broker.GetStats().connects == 2);
+    }
+
+    void TestDisconnectDropsCachedList()
+    {
+        FakeShell shell;
+        std::atomic<uint64_t> generation{ 0 };
+        Broker broker(generation, FakeProvider{ &shell });
+        int desktop = -1;
+        CHECK(DesktopAt(broker, 0, desktop) == ShellCallResult::Succeeded);
+        broker.Disconnect();
+        CHECK(!broker.IsConnected());
+        CHECK(DesktopAt(broker, 0, desktop) == ShellCallResult::Succeeded);
+        CHECK(shell.connects == 2);
+        CHECK(shell.desktopLists == 2);
+    }
+}
+
+int main()
+{
+    TestDesktopListIsCachedPerGeneration();
+    TestReconnectsOnceWhenShellRestarted();
+    TestGivesUpWhenShellIsGone();
+    TestDisconnectDropsCachedList();
+    return Check::Result();
+}
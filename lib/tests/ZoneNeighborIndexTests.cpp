@@ -0,0 +1,133 @@
+#include "ZoneNeighborIndex.h"
+#include "tests/Check.h"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using Direction = ZoneNeighborIndex::Direction;
+    using ZoneRef = ZoneNeighborIndex::ZoneRef;
+
+    Platform::MonitorHandle Monitor(size_t index)
+    {
+        return reinterpret_cast<Platform::MonitorHandle>(index + 1);
+    }
+
+    // Main zone on the left, two zones stacked on the right, like the main zone layout
+    std::vector<Platform::Rect> MainZoneLayout(int left)
+    {
+        return {
+            { left, 0, left + 960, 1080 },
+            { left + 960, 0, left + 1920, 540 },
+            { left + 960, 540, left + 1920, 1080 },
+        };
+    }
+
+    void TestAcrossMonitors()
+    {
+        ZoneNeighborIndex index;
+        index.SetMonitorZones(Monitor(0), MainZoneLayout(0));
+        index.SetMonitorZones(Monitor(1), MainZoneLayout(1920));
+
+        // Both stacked zones are as close, the lower index wins
+        CHECK((index.Neighbor({ Monitor(1), 0 }, Direction::Left) == ZoneRef{ Monitor(0), 1 }));
+        CHECK((index.Neighbor({ Monitor(0), 1 }, Direction::Right) == ZoneRef{ Monitor(1), 0 }));
+        CHECK((index.Neighbor({ Monitor(0), 2 }, Direction::Right) == ZoneRef{ Monitor(1), 0 }));
+        CHECK((index.Neighbor({ Monitor(1), 2 }, Direction::Left) == ZoneRef{ Monitor(1), 0 }));
+        CHECK((index.Neighbor({ Monitor(0), 2 }, Direction::Up) == ZoneRef{ Monitor(0), 1 }));
+        CHECK((index.Neighbor({ Monitor(0), 1 }, Direction::Down) == ZoneRef{ Monitor(0), 2 }));
+        CHECK(!index.Neighbor({ Monitor(0), 0 }, Direction::Left).Valid());
+        CHECK(!index.Neighbor({ Monitor(0), 1 }, Direction::Up).Valid());
+
+        // Past the leftmost zone moves start over from the rightmost one, on the other monitor
+        CHECK((index.NeighborOrWrap({ Monitor(0), 0 }, Direction::Left) == ZoneRef{ Monitor(1), 1 }));
+        CHECK((index.NeighborOrWrap({ Monitor(1), 0 }, Direction::Left) == ZoneRef{ Monitor(0), 1 }));
+        CHECK(!index.NeighborOrWrap({ Monitor(2), 0 }, Direction::Left).Valid());
+        CHECK(!index.NeighborOrWrap({ Monitor(0), 3 }, Direction::Left).Valid());
+
+        // Monitor below the first one
+        index.SetMonitorZones(Monitor(2), { { 0, 1080, 1920, 2160 } });
+        CHECK((index.Neighbor({ Monitor(0), 0 }, Direction::Down) == ZoneRef{ Monitor(2), 0 }));
+        CHECK((index.Neighbor({ Monitor(2), 0 }, Direction::Up) == ZoneRef{ Monitor(0), 0 }));
+        CHECK((index.Neighbor({ Monitor(2), 0 }, Direction::Right) == ZoneRef{ Monitor(1), 0 }));
+
+        index.RemoveMonitor(Monitor(1));
+        CHECK(!index.Neighbor({ Monitor(0), 1 }, Direction::Right).Valid());
+        CHECK(!index.Neighbor({ Monitor(1), 0 }, Direction::Left).Valid());
+        CHECK((index.NeighborOrWrap({ Monitor(0), 0 }, Direction::Left) == ZoneRef{ Monitor(0), 1 }));
+        CHECK(index.Size() == 4);
+
+        // A lone zone wraps onto itself
+        ZoneNeighborIndex single;
+        single.SetMonitorZones(Monitor(0), { { 0, 0, 1920, 1080 } });
+        CHECK((single.NeighborOrWrap({ Monitor(0), 0 }, Direction::Left) == ZoneRef{ Monitor(0), 0 }));
+    }
+
+    std::vector<Platform::Rect> RandomZones(std::mt19937& random)
+    {
+        std::uniform_int_distribution<int> count(0, 6);
+        std::uniform_int_distribution<int> coordinate(0, 3840);
+        std::uniform_int_distribution<int> extent(1, 1200);
+        std::vector<Platform::Rect> zones(count(random));
+        for (auto& zone : zones)
+        {
+            zone.left = coordinate(random);
+            zone.top = coordinate(random) / 2;
+            zone.right = zone.left + extent(random);
+            zone.bottom = zone.top + extent(random);
+        }
+        return zones;
+    }
+
+    // Updating one monitor at a time gives the same neighbors as building the index from scratch
+    void TestIncrementalMatchesRebuild()
+    {
+        std::mt19937 random(20201018);
+        for (int round = 0; round < 2000; round++)
+        {
+            ZoneNeighborIndex incremental;
+            std::map<size_t, std::vector<Platform::Rect>> monitors;
+            for (int update = 0; update < 8; update++)
+            {
+                const size_t monitor = random() % 4;
+                monitors[monitor] = RandomZones(random);
+                incremental.SetMonitorZones(Monitor(monitor), monitors[monitor]);
+
+                ZoneNeighborIndex rebuilt;
+                for (auto it = monitors.rbegin(); it != monitors.rend(); ++it)
+                {
+                    rebuilt.SetMonitorZones(Monitor(it->first), it->second);
+                }
+
+                if (!CHECK(incremental.Size() == rebuilt.Size()))
+                {
+                    return;
+                }
+                for (const auto& [handle, zones] : monitors)
+                {
+                    for (size_t zone = 0; zone < zones.size(); zone++)
+                    {
+                        for (size_t direction = 0; direction < static_cast<size_t>(Direction::Count); direction++)
+                        {
+                            const ZoneRef ref{ Monitor(handle), static_cast<int>(zone) };
+                            if (!CHECK(incremental.Neighbor(ref, static_cast<Direction>(direction)) == rebuilt.Neighbor(ref, static_cast<Direction>(direction))))
+                            {
+                                return;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestAcrossMonitors();
+    TestIncrementalMatchesRebuild();
+    return Check::Result();
+}
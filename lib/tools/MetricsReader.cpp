@@ -0,0 +1,47 @@
+#include "MetricsBlock.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// Prints the live counters of a running FancyZones, once or every given number of seconds.
+int main(int argc, char** argv)
+{
+    int interval = 0;
+    if (argc == 3 && std::strcmp(argv[1], "--watch") == 0)
+    {
+        interval = std::atoi(argv[2]);
+    }
+    else if (argc != 1)
+    {
+        std::fprintf(stderr, "usage: %s [--watch seconds]\n", argv[0]);
+        return 2;
+    }
+
+    Metrics::Reader reader;
+    if (!reader.Open())
+    {
+        std::fprintf(stderr, "FancyZones isn't publishing counters\n");
+        return 1;
+    }
+
+    Metrics::Sample sample;
+    for (;;)
+    {
+        if (!reader.Read(sample))
+        {
+            std::fprintf(stderr, "FancyZones stopped publishing counters\n");
+            return 1;
+        }
+        Metrics::WriteText(std::cout, sample);
+        if (interval <= 0)
+        {
+            return 0;
+        }
+        std::cout << std::endl;
+        std::this_thread::sleep_for(std::chrono::seconds(interval));
+    }
+}
@@ -1,5 +1,11 @@
 #include "pch.h"
 #include "util.h"
+#include "ExcludedApps.h"
+#include "MetricsBlock.h"
+#include "MonitorOrder.h"
+#include "PlacementTracker.h"
+#include "Platform.h"
+#include "WindowAnimator.h"
 
 #include <common/common.h>
 #include <common/dpi_aware.h>
@@ -7,13 +13,17 @@
 typedef BOOL(WINAPI* GetDpiForMonitorInternalFunc)(HMONITOR, UINT, UINT*, UINT*);
 UINT GetDpiForMonitor(HMONITOR monitor) noexcept
 {
+    // user32 stays loaded for the life of the process, so the export is resolved once
+    static const auto func = []() -> GetDpiForMonitorInternalFunc {
+        HMODULE user32 = GetModuleHandleW(L"user32.dll");
+        return user32 ? reinterpret_cast<GetDpiForMonitorInternalFunc>(GetProcAddress(user32, "GetDpiForMonitorInternal")) : nullptr;
+    }();
+
+    Metrics::Add(Metrics::Counter::MonitorDpiQueries);
     UINT dpi{};
-    if (wil::unique_hmodule user32{ LoadLibrary(L"user32.dll") })
+    if (func)
     {
-        if (auto func = reinterpret_cast<GetDpiForMonitorInternalFunc>(GetProcAddress(user32.get(), "GetDpiForMonitorInternal")))
-        {
-            func(monitor, 0, &dpi, &dpi);
-        }
+        func(monitor, 0, &dpi, &dpi);
     }
 
     if (dpi == 0)
@@ -29,88 +39,32 @@ UINT GetDpiForMonitor(HMONITOR monitor) noexcept
 
 void OrderMonitors(std::vector<std::pair<HMONITOR, RECT>>& monitorInfo)
 {
-    const size_t nMonitors = monitorInfo.size();
-    // blocking[i][j] - whether monitor i blocks monitor j in the ordering, i.e. monitor i should go before monitor j
-    std::vector<std::vector<bool>> blocking(nMonitors, std::vector<bool>(nMonitors, false));
-
-    // blockingCount[j] - the number of monitors which block monitor j
-    std::vector<size_t> blockingCount(nMonitors, 0);
+    MonitorOrder::Sorter sorter;
+    sorter.Sort(monitorInfo);
+}
 
-    for (size_t i = 0; i < nMonitors; i++)
+void SizeWindowToRect(HWND window, RECT rect) noexcept
+{
+    auto& placementTracker = PlacementTrackerInstance();
+    if (placementTracker.IsAlreadyApplied(window, rect))
     {
-        RECT rectI = monitorInfo[i].second;
-        for (size_t j = 0; j < nMonitors; j++)
-        {
-            RECT rectJ = monitorInfo[j].second;
-            blocking[i][j] = rectI.top < rectJ.bottom && rectI.left < rectJ.right && i != j;
-            if (blocking[i][j])
-            {
-                blockingCount[j]++;
-            }
-        }
+        placementTracker.CountSkipped();
+        Metrics::Add(Metrics::Counter::PlacementsSkipped);
+        return;
     }
+    placementTracker.CountIssued();
+    Metrics::Add(Metrics::Counter::PlacementsIssued);
 
-    // used[i] - whether the sorting algorithm has used monitor i so far
-    std::vector<bool> used(nMonitors, false);
-
-    // the sorted sequence of monitors
-    std::vector<std::pair<HMONITOR, RECT>> sortedMonitorInfo;
-
-    for (size_t iteration = 0; iteration < nMonitors; iteration++)
+    // Animated mode collects placements and applies them once the batch is closed
+    if (WindowAnimator::CollectPlacement(window, rect))
     {
-        // Indices of candidates to become the next monitor in the sequence
-        std::vector<size_t> candidates;
-
-        // First, find indices of all unblocked monitors
-        for (size_t i = 0; i < nMonitors; i++)
-        {
-            if (blockingCount[i] == 0 && !used[i])
-            {
-                candidates.push_back(i);
-            }
-        }
-
-        // In the unlikely event that there are no unblocked monitors, declare all unused monitors as candidates.
-        if (candidates.empty())
-        {
-            for (size_t i = 0; i < nMonitors; i++)
-            {
-                if (!used[i])
-                {
-                    candidates.push_back(i);
-                }
-            }
-        }
-
-        // Pick the lexicographically smallest monitor as the next one
-        size_t smallest = candidates[0];
-        for (size_t j = 1; j < candidates.size(); j++)
-        {
-            size_t current = candidates[j];
-
-            // Compare (top, left) lexicographically
-            if (std::tie(monitorInfo[current].second.top, monitorInfo[current].second.left) <
-                std::tie(monitorInfo[smallest].second.top, monitorInfo[smallest].second.left))
-            {
-                smallest = current;
-            }
-        }
-
-        used[smallest] = true;
-        sortedMonitorInfo.push_back(monitorInfo[smallest]);
-        for (size_t i = 0; i < nMonitors; i++)
-        {
-            if (blocking[smallest][i])
-            {
-                blockingCount[i]--;
-            }
-        }
+        return;
     }
 
-    monitorInfo = std::move(sortedMonitorInfo);
+    PlatformInstance().PlaceWindow(window, rect);
 }
 
-void SizeWindowToRect(HWND window, RECT rect) noexcept
+void ApplyWindowPlacement(HWND window, RECT rect) noexcept
 {
     WINDOWPLACEMENT placement{};
     ::GetWindowPlacement(window, &placement);
@@ -142,22 +96,26 @@ void SizeWindowToRect(HWND window, RECT rect) noexcept
     // Do it again, allowing Windows to resize the window and set correct scaling
     // This fixes Issue #365
     ::SetWindowPlacement(window, &placement);
+
+    PlacementTrackerInstance().RecordApplied(window, rect);
 }
 
 bool IsInterestingWindow(HWND window, const std::vector<std::wstring>& excludedApps) noexcept
 {
-    auto filtered = get_fancyzones_filtered_window(window);
-    if (!filtered.zonable)
+    // Called for every top-level window on each snap, the buffer is kept to not allocate each time
+    static thread_local std::wstring processPath;
+    static const std::vector<std::wstring> launcherApps{ L"POWERLAUNCHER.EXE" };
+    if (!PlatformInstance().GetZonableWindowProcess(window, processPath))
     {
         return false;
     }
     // Filter out user specified apps
-    CharUpperBuffW(filtered.process_path.data(), (DWORD)filtered.process_path.length());
-    if (find_app_name_in_path(filtered.process_path, excludedApps))
+    CharUpperBuffW(processPath.data(), (DWORD)processPath.length());
+    if (ExcludedApps::Matches(processPath, excludedApps))
     {
         return false;
     }
-    if (find_app_name_in_path(filtered.process_path, { L"POWERLAUNCHER.EXE" }))
+    if (ExcludedApps::Matches(processPath, launcherApps))
     {
         return false;
     }
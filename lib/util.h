@@ -1,6 +1,6 @@
 #pragma once
 
-#include "gdiplus.h"
+#include "DeviceIdUtils.h"
 
 struct Rect
 {
@@ -44,30 +44,8 @@ inline void MakeWindowTransparent(HWND window)
 
 inline void ParseDeviceId(PCWSTR deviceId, PWSTR parsedId, size_t size)
 {
-    // We're interested in the unique part between the first and last #'s
-    // Example input: \\?\DISPLAY#DELA026#5&10a58c63&0&UID16777488#{e6f07b5f-ee97-4a90-b076-33f57bf4eaa7}
-    // Example output: DELA026#5&10a58c63&0&UID16777488
-    const std::wstring defaultDeviceId = L"FallbackDevice";
-    if (!deviceId)
-    {
-        StringCchCopy(parsedId, size, defaultDeviceId.c_str());
-        return;
-    }
-    wchar_t buffer[256];
-    StringCchCopy(buffer, 256, deviceId);
-
-    PWSTR pszStart = wcschr(buffer, L'#');
-    PWSTR pszEnd = wcsrchr(buffer, L'#');
-    if (pszStart && pszEnd && (pszStart != pszEnd))
-    {
-        pszStart++; // skip past the first #
-        *pszEnd = '\0';
-        StringCchCopy(parsedId, size, pszStart);
-    }
-    else
-    {
-        StringCchCopy(parsedId, size, defaultDeviceId.c_str());
-    }
+    const auto id = deviceId ? DeviceIdUtils::ParseDeviceId(deviceId) : DeviceIdUtils::FALLBACK_DEVICE_ID;
+    StringCchCopyN(parsedId, size, id.data(), id.size());
 }
 
 inline BYTE OpacitySettingToAlpha(int opacity)
@@ -78,5 +56,6 @@ inline BYTE OpacitySettingToAlpha(int opacity)
 UINT GetDpiForMonitor(HMONITOR monitor) noexcept;
 void OrderMonitors(std::vector<std::pair<HMONITOR, RECT>>& monitorInfo);
 void SizeWindowToRect(HWND window, RECT rect) noexcept;
+void ApplyWindowPlacement(HWND window, RECT rect) noexcept;
 
 bool IsInterestingWindow(HWND window, const std::vector<std::wstring>& exludedApps) noexcept;
\ No newline at end of file